@@ -33,310 +33,1983 @@
 #include "nanocoop.h"
 #include "nc_config.h"
 #include "nc_port.h"
+#include "nc_bitmap.h"
+
+#if (CONFIG_NC_TIMER == 1)
+#include "nc_timer.h"
+#endif
+
+#include "nc_trace.h"
+
+#if (CONFIG_NC_DEFER == 1)
+#include "nc_defer.h"
+#endif
+
+#if (CONFIG_NC_IO == 1)
+#include "nc_io.h"
+#endif
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0)
+#include "nc_slab.h"
+#endif
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+#include <string.h>
+#endif
 
 /*========================================================  LOCAL MACRO's  ==*/
 
-#define LOG2_8(x)                                                           \
-    ((x) <   2u ? 0u :                                                      \
-     ((x) <   4u ? 1u :                                                     \
-      ((x) <   8u ? 2u :                                                    \
-       ((x) <  16u ? 3u :                                                   \
-        ((x) <  32u ? 4u :                                                  \
-         ((x) <  64u ? 5u :                                                 \
-          ((x) < 128u ? 6u : 7u)))))))
+/**@brief       Are there any thread members which are kept in struct
+ *              nc_thread_cold?
+ */
+#define THREAD_HAS_COLD                                                     \
+    ((CONFIG_NC_TIMER == 1) || (CONFIG_NC_PROFILE == 1) ||                  \
+     (CONFIG_NC_SCHED_EDF == 1))
+
+#if (CONFIG_NC_THREAD_SPLIT == 1) && defined(__GNUC__)
+#define CACHE_ALIGNED                                                       \
+    __attribute__((aligned(CONFIG_NC_CACHE_LINE_SIZE)))
+#else
+#define CACHE_ALIGNED
+#endif
+
+/*=====================================================  LOCAL DATA TYPES  ==*/
+
+#if THREAD_HAS_COLD
+/**@brief       Thread members which are not used to ready, block or dispatch
+ *              a thread
+ * @details     With `CONFIG_NC_THREAD_SPLIT` these members are kept in an
+ *              array parallel to the thread pool, otherwise they are a part of
+ *              the thread structure.
+ */
+struct nc_thread_cold
+{
+# if (CONFIG_NC_TIMER == 1)
+    struct nc_timer             delay;     /**<@brief nc_thread_delay() timer */
+# endif
+# if (CONFIG_NC_PROFILE == 1)
+    struct nc_thread_stats      stats;
+    uint64_t                    ready_time; /**<@brief Time of becoming ready */
+# endif
+# if (CONFIG_NC_SCHED_EDF == 1)
+    uint32_t                    deadline_misses;
+# endif
+};
+#endif
+
+struct nc_thread
+{
+    struct nc_thread *          next;
+    struct nc_thread *          prev;
+    void                     (* fn)(void *);
+    void *                      stack;
+    uint_fast8_t                priority;
+    nc_lc                       lc;          /**<@brief Resume point */
+    nc_thread_state             state;
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    struct nc_context * volatile context;    /**<@brief Owning core context */
+#endif
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    struct nc_sched *           sched;       /**<@brief Owning instance     */
+#endif
+#if (CONFIG_NC_READY_INBOX == 1)
+    void * volatile             inbox_next;   /**<@brief Next in ready inbox */
+#endif
+#if (CONFIG_NC_WEIGHTED_RR == 1)
+    uint_fast8_t                weight;     /**<@brief Dispatches per turn   */
+    uint_fast8_t                credit;     /**<@brief Dispatches left       */
+#endif
+#if (CONFIG_NC_SCHED_EDF == 1)
+    nc_tick                     deadline;   /**<@brief Absolute deadline     */
+    nc_tick                     relative_deadline;  /**<@brief 0 - none      */
+    uint32_t                    sequence;   /**<@brief Order among equals    */
+    size_t                      heap_index; /**<@brief Position in heap      */
+#endif
+#if THREAD_HAS_COLD && (CONFIG_NC_THREAD_SPLIT == 0)
+    struct nc_thread_cold       cold;
+#endif
+};
+
+/**@brief       Layout of a thread in nc_thread_storage
+ * @details     A statically allocated thread is not in the pool, so it keeps
+ *              its cold members next to it.
+ */
+struct nc_thread_static
+{
+    struct nc_thread            thread;
+#if THREAD_HAS_COLD && (CONFIG_NC_THREAD_SPLIT == 1)
+    struct nc_thread_cold       cold;
+#endif
+};
+
+struct nc_context
+{
+#if (CONFIG_NC_SCHED_EDF == 1)
+    struct nc_thread *          heap[CONFIG_NC_NUM_OF_THREADS];/**<@brief Ready */
+    size_t                      heap_size;
+    uint32_t                    sequence;   /**<@brief Next ready sequence   */
+#else
+    struct nc_bitmap            bitmap;
+#endif
+    struct nc_thread *          current;
+#if (CONFIG_NC_SCHED_EDF == 0)
+    struct nc_thread *          ready[CONFIG_NC_NUM_OF_PRIO_LEVELS];
+#endif
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spinlock                 lock;
+#endif
+#if (CONFIG_NC_READY_INBOX == 1)
+    void * volatile             inbox;  /**<@brief Threads readied by others */
+#endif
+};
+
+struct nc_sched
+{
+    struct nc_context           context[CONFIG_NC_NUM_OF_CORES];
+#if (CONFIG_NC_NUM_OF_THREADS != 0)
+    /**@brief   Pool memory for thread structures which are allocated through
+     *          nc_sched_thread_create() function.
+     */
+    struct nc_thread            threads[CONFIG_NC_NUM_OF_THREADS] CACHE_ALIGNED;
+
+# if THREAD_HAS_COLD && (CONFIG_NC_THREAD_SPLIT == 1)
+    /**@brief   Cold members of pool threads, at the same index
+     */
+    struct nc_thread_cold       threads_cold[CONFIG_NC_NUM_OF_THREADS];
+# endif
+
+    /**@brief   List of destroyed threads which are ready for reuse
+     * @details Free threads are linked through their `next` pointer.
+     */
+    struct nc_thread *          threads_free;
+
+    /**@brief   Number of pool threads which were ever allocated
+     * @details The pool is consumed from the start, so a zero initialized
+     *          instance needs no initialization pass.
+     */
+    size_t                      threads_used;
+#endif
+#if (CONFIG_NC_NUM_OF_THREADS == 0)
+    const nc_allocator *        allocator;  /**<@brief NULL - use `slab`    */
+    nc_slab                     slab;
+#endif
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spinlock                 threads_lock;
+#endif
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    bool                        is_used;
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    /**@brief   Context which executed the instance last
+     */
+    struct nc_context * volatile home;
+# endif
+#endif
+};
+
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Get the context of the core which is calling this function
+ */
+static inline
+uint_fast8_t core_this(void);
+
+
+
+static inline
+struct nc_sched * thread_sched(
+    const struct nc_thread *    thread);
+
+
+
+static inline
+struct nc_context * thread_context(
+    const struct nc_thread *    thread);
+
+
+
+#if (CONFIG_NC_NUM_OF_THREADS != 0)
+/**@brief       Is the thread taken from the instance thread pool?
+ * @details     Threads defined by NC_THREAD_DEFINE() are not.
+ */
+static inline
+bool thread_is_pooled(
+    const struct nc_sched *     sched,
+    const struct nc_thread *    thread);
+#endif
+
+
+
+#if THREAD_HAS_COLD
+/**@brief       Get cold members of a thread
+ */
+static inline
+struct nc_thread_cold * thread_cold(
+    const struct nc_thread *    thread);
+#endif
+
+
+
+/**@brief       Initialize a thread structure
+ */
+static
+void thread_init(
+    struct nc_sched *           sched,
+    struct nc_thread *          thread,
+    nc_thread_fn *              fn,
+    void *                      stack,
+    uint_fast8_t                priority);
+
+
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+/**@brief       Get the active context variable of the caller
+ */
+static inline
+struct nc_context ** active_this(void);
+
+
+
+/**@brief       Does the context belong to the instance?
+ */
+static inline
+bool sched_has_context(
+    const struct nc_sched *     sched,
+    const struct nc_context *   context);
+#endif
+
+
+
+/**@brief       Get the context on which new threads of an instance are put
+ * @details     This is the context of the caller when it executes the
+ *              instance, otherwise the context which executed it last.
+ */
+static inline
+struct nc_context * sched_context(
+    struct nc_sched *           sched);
+
+
+
+static inline
+struct nc_context * context_this(void);
+
+
+
+/**@brief       Lock the thread owning context
+ * @return      Context which is locked and which owns the thread
+ */
+static inline
+struct nc_context * context_lock_thread(
+    const struct nc_thread *    thread,
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Lock the thread owning context while other context may be
+ *              already locked
+ * @param       context
+ *              Currently locked context or NULL when no context is locked.
+ * @return      Context which is locked and which owns the thread
+ * @details     The lock is kept when the thread is owned by the already
+ *              locked context.
+ */
+static inline
+struct nc_context * context_relock_thread(
+    struct nc_context *         context,
+    const struct nc_thread *    thread,
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Lock a context
+ */
+static inline
+void context_lock(
+    struct nc_context *         context,
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock a context
+ */
+static inline
+void context_unlock(
+    struct nc_context *         context,
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Steal a ready thread from other core
+ * @return
+ * @retval      true  - a thread was moved into the given context
+ * @retval      false - there is nothing to steal
+ */
+static inline
+bool context_steal(
+    struct nc_sched *           sched,
+    struct nc_context *         context);
+
+
+
+#if (CONFIG_NC_SCHED_EDF == 1)
+/**@brief       Should thread `a` be executed before thread `b`?
+ */
+static inline
+bool heap_is_before(
+    const struct nc_thread *    a,
+    const struct nc_thread *    b);
+
+
+
+/**@brief       Move a heap element towards the root until heap is valid
+ */
+static inline
+void heap_sift_up(
+    struct nc_context *         context,
+    size_t                      index);
+
+
+
+/**@brief       Move a heap element towards leaves until heap is valid
+ */
+static inline
+void heap_sift_down(
+    struct nc_context *         context,
+    size_t                      index);
+#endif
+
+
+
+/**@brief       Are there any ready threads in the given context?
+ */
+static inline
+bool ready_is_empty(
+    const struct nc_context *   context);
+
+
+
+/**@brief       Get the thread which would be executed next
+ * @details     Context must not be empty.
+ */
+static inline
+struct nc_thread * ready_get_highest(
+    const struct nc_context *   context);
+
+
+
+/**@brief       Take the thread which is executed next
+ * @details     The thread stays ready, but other threads of the same
+ *              importance are executed before it next time.
+ */
+static inline
+struct nc_thread * ready_take(
+    struct nc_context *         context);
+
+
+
+/**@brief       Insert a thread into ready list of the given context
+ */
+static inline
+void ready_insert(
+    struct nc_context *         context,
+    struct nc_thread *          thread);
+
+
+
+/**@brief       Remove a thread from ready list of the given context
+ */
+static inline
+void ready_remove(
+    struct nc_context *         context,
+    struct nc_thread *          thread);
+
+
+
+/**@brief       Make a thread ready if it is not already ready
+ * @details     Context must be locked.
+ */
+static inline
+void thread_make_ready(
+    struct nc_context *         context,
+    struct nc_thread *          thread);
+
+
+
+/**@brief       Make a thread blocked
+ * @details     Context must be locked.
+ */
+static inline
+void thread_make_blocked(
+    struct nc_context *         context,
+    struct nc_thread *          thread);
+
+
+
+/**@brief       Execute a thread
+ */
+static inline
+void thread_dispatch(
+    struct nc_thread *          thread);
+
+
+
+/**@brief       Write a trace record about a thread
+ */
+static inline
+void thread_trace(
+    const struct nc_thread *    thread,
+    uint_fast8_t                event);
+
+
+
+/**@brief       Should deferred calls be executed before the next thread?
+ */
+static inline
+bool defer_is_due(
+    struct nc_context *         context);
+
+
+
+/**@brief       Push an already claimed thread into context ready inbox
+ */
+static inline
+void inbox_push(
+    struct nc_context *         context,
+    struct nc_thread *          thread);
+
+
+
+/**@brief       Make all threads from context ready inbox ready
+ * @details     Context must be locked.
+ */
+static inline
+void inbox_drain(
+    struct nc_context *         context);
+
+
+
+/**@brief       Is there any work for the given context?
+ */
+static inline
+bool context_has_work(
+    struct nc_context *         context);
+
+
+
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_TIMER == 1)
+/**@brief       Advance timers by the number of ticks elapsed since last call
+ * @return      Nanoseconds elapsed since the last processed tick
+ */
+static
+uint64_t idle_timer_sync(void);
+#endif
+
+
+
+/**@brief       Execute ready threads of an instance within a budget
+ * @param       max_dispatches
+ *              Maximum number of dispatches, 0 - no limit.
+ * @param       max_ns
+ *              Maximum time in nanoseconds, 0 - no limit.
+ * @return      Is there any ready work left?
+ */
+static
+bool sched_run(
+    struct nc_sched *           sched,
+    uint32_t                    max_dispatches,
+    uint64_t                    max_ns);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+/**@brief       Scheduler instances, the first one is the default instance
+ *              used by the global API
+ */
+static struct nc_sched    g_sched[CONFIG_NC_NUM_OF_SCHEDULERS];
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+# if defined(NCPU_THREAD_LOCAL)
+/**@brief       Context which is executed by nc_sched_schedule() in the calling
+ *              OS thread
+ * @details     NULL means the default instance. Each OS thread may execute
+ *              its own instance, even with a single core.
+ */
+static NCPU_THREAD_LOCAL struct nc_context * g_active;
+# else
+/**@brief       Context which is executed by nc_sched_schedule() on each core
+ * @details     NULL means the default instance.
+ */
+static struct nc_context * g_active[CONFIG_NC_NUM_OF_CORES];
+# endif
+
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+/**@brief       Lock protecting instance allocation
+ */
+static nc_spinlock        g_sched_lock;
+# endif
+#endif
+
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_TIMER == 1)
+/**@brief       Time of the last processed timer tick
+ */
+static uint64_t           g_idle_tick_time;
+
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+/**@brief       Lock protecting idle timer time
+ */
+static nc_spinlock        g_idle_lock;
+# endif
+#endif
+
+#if (CONFIG_NC_READY_INBOX == 1)
+/**@brief       Terminates a ready inbox list
+ * @details     A thread with NULL `inbox_next` member is not in any inbox.
+ */
+static char               g_inbox_end;
+#endif
+
+#if defined(__GNUC__)
+/**@brief       Bounds of thread definitions table
+ * @details     These symbols are provided by the linker. They are weak, so
+ *              they are NULL when no thread is defined.
+ */
+extern const struct nc_thread_define __start_nc_thread_defines[]
+    __attribute__((weak));
+extern const struct nc_thread_define __stop_nc_thread_defines[]
+    __attribute__((weak));
+#endif
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
 
-#define DIVISION_ROUNDUP(numerator, denominator)                            \
-    (((numerator) + (denominator) - 1u) / (denominator))
+static inline
+uint_fast8_t core_this(void)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    return (nc_cpu_id());
+#else
+    return (0u);
+#endif
+}
+
+
+
+static inline
+struct nc_sched * thread_sched(
+    const struct nc_thread *    thread)
+{
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    return (thread->sched);
+#else
+    (void)thread;
+
+    return (&g_sched[0]);
+#endif
+}
+
+
+
+static inline
+struct nc_context * thread_context(
+    const struct nc_thread *    thread)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    return (thread->context);
+#else
+    return (&thread_sched(thread)->context[0]);
+#endif
+}
+
+
+
+#if (CONFIG_NC_NUM_OF_THREADS != 0)
+static inline
+bool thread_is_pooled(
+    const struct nc_sched *     sched,
+    const struct nc_thread *    thread)
+{
+    return (((uintptr_t)thread >= (uintptr_t)&sched->threads[0]) &&
+        ((uintptr_t)thread <
+            (uintptr_t)&sched->threads[CONFIG_NC_NUM_OF_THREADS]));
+}
+#endif
+
+
+
+#if THREAD_HAS_COLD
+static inline
+struct nc_thread_cold * thread_cold(
+    const struct nc_thread *    thread)
+{
+# if (CONFIG_NC_THREAD_SPLIT == 1)
+    struct nc_sched *           sched;
+
+    sched = thread_sched(thread);
+
+    if (!thread_is_pooled(sched, thread)) {
+        return (&((struct nc_thread_static *)thread)->cold);
+    }
+
+    return (&sched->threads_cold[thread - &sched->threads[0]]);
+# else
+    return ((struct nc_thread_cold *)&thread->cold);
+# endif
+}
+#endif
+
+
+
+static
+void thread_init(
+    struct nc_sched *           sched,
+    struct nc_thread *          thread,
+    nc_thread_fn *              fn,
+    void *                      stack,
+    uint_fast8_t                priority)
+{
+#if (CONFIG_NC_NUM_OF_SCHEDULERS == 1) && (CONFIG_NC_NUM_OF_CORES == 1)
+    (void)sched;
+#endif
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    thread->sched    = sched;       /* Cold members are found through it */
+#endif
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    thread->context  = sched_context(sched);
+#endif
+    thread->next     = thread;      /* Init linked list pointers */
+    thread->prev     = thread;
+    thread->fn       = fn;
+    thread->stack    = stack;
+    thread->priority = priority;
+    thread->state    = NC_STATE_IDLE;
+    thread->lc       = 0u;
+#if (CONFIG_NC_WEIGHTED_RR == 1)
+    thread->weight   = 1u;
+    thread->credit   = 1u;
+#endif
+#if (CONFIG_NC_SCHED_EDF == 1)
+    thread->relative_deadline = 0u;
+    thread_cold(thread)->deadline_misses = 0u;
+#endif
+#if (CONFIG_NC_READY_INBOX == 1)
+    thread->inbox_next = NULL;
+#endif
+#if (CONFIG_NC_TIMER == 1)
+    nc_timer_init(&thread_cold(thread)->delay);
+#endif
+#if (CONFIG_NC_PROFILE == 1)
+    nc_thread_reset_stats(thread);
+#endif
+    thread_trace(thread, NC_TRACE_CREATE);
+}
+
+
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+static inline
+struct nc_context ** active_this(void)
+{
+# if defined(NCPU_THREAD_LOCAL)
+    return (&g_active);
+# else
+    return (&g_active[core_this()]);
+# endif
+}
+
+
+
+static inline
+bool sched_has_context(
+    const struct nc_sched *     sched,
+    const struct nc_context *   context)
+{
+    return (((uintptr_t)context >= (uintptr_t)&sched->context[0]) &&
+        ((uintptr_t)context <
+            (uintptr_t)&sched->context[CONFIG_NC_NUM_OF_CORES]));
+}
+#endif
+
+
+
+static inline
+struct nc_context * sched_context(
+    struct nc_sched *           sched)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1) && (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    struct nc_context *         context;
+
+    context = context_this();
+
+    if (!sched_has_context(sched, context)) {   /* Created by other instance */
+        context = sched->home;
+
+        if (context == NULL) {             /* The instance was never executed */
+            context = &sched->context[core_this()];
+        }
+    }
+
+    return (context);
+#else
+    return (&sched->context[core_this()]);
+#endif
+}
+
+
+
+static inline
+struct nc_context * context_this(void)
+{
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    struct nc_context *         context;
+
+    context = *active_this();
+
+    if (context == NULL) {          /* Outside of nc_sched_schedule() calls */
+        context = &g_sched[0].context[core_this()];
+    }
+
+    return (context);
+#else
+    return (&g_sched[0].context[core_this()]);
+#endif
+}
+
+
+
+static inline
+struct nc_context * context_lock_thread(
+    const struct nc_thread *    thread,
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    struct nc_context *         context;
+
+    /* The thread may be stolen by other core while we are waiting for the
+     * lock, so check the owner again after the lock is taken.
+     */
+    for (;;) {
+        context = thread->context;
+        context_lock(context, isr_context);
+
+        if (context == thread->context) {
+            return (context);
+        }
+        context_unlock(context, isr_context);
+    }
+#else
+    struct nc_context *         context;
+
+    context = thread_context(thread);
+    context_lock(context, isr_context);
+
+    return (context);
+#endif
+}
+
+
+
+static inline
+struct nc_context * context_relock_thread(
+    struct nc_context *         context,
+    const struct nc_thread *    thread,
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    if (context != NULL) {
+        if (context == thread->context) {   /* The owner can not change while */
+            return (context);               /* its context is locked.         */
+        }
+        context_unlock(context, isr_context);
+    }
+
+    return (context_lock_thread(thread, isr_context));
+#else
+    if (context == NULL) {
+        context = context_lock_thread(thread, isr_context);
+    }
+
+    return (context);
+#endif
+}
+
+
+
+static inline
+void context_lock(
+    struct nc_context *         context,
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&context->lock);
+#else
+    (void)context;
+#endif
+}
+
+
+
+static inline
+void context_unlock(
+    struct nc_context *         context,
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&context->lock);
+#else
+    (void)context;
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+
+
+static inline
+bool context_steal(
+    struct nc_sched *           sched,
+    struct nc_context *         context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_isr_lock                 isr_context;
+    uint_fast8_t                core;
+    uint_fast8_t                itr;
+
+    core = (uint_fast8_t)(context - &sched->context[0]);
+                                   /* Start from the next core to spread the */
+                                   /* stealing pressure among all cores.     */
+    for (itr = 1u; itr < CONFIG_NC_NUM_OF_CORES; itr++) {
+        struct nc_context *     victim;
+        struct nc_context *     first;
+        struct nc_context *     second;
+        bool                    is_stolen;
+
+        victim = &sched->context[(core + itr) % CONFIG_NC_NUM_OF_CORES];
+
+        if (ready_is_empty(victim)) {             /* Unlocked peek, checked */
+            continue;                             /* again under the lock.  */
+        }
+        first  = victim < context ? victim  : context;  /* Lock ordering to */
+        second = victim < context ? context : victim;   /* avoid deadlocks. */
+        nc_isr_lock_save(&isr_context);
+        nc_spin_lock(&first->lock);
+        nc_spin_lock(&second->lock);
+        is_stolen = false;
+
+        if (!ready_is_empty(victim)) {
+            struct nc_thread *  thread;
+
+            thread = ready_get_highest(victim);
+                                       /* Never steal a thread which is being */
+            if (thread != victim->current) {        /* executed by victim.  */
+                ready_remove(victim, thread);
+                thread->context = context;
+                ready_insert(context, thread);
+                is_stolen = true;
+            }
+        }
+        nc_spin_unlock(&second->lock);
+        nc_spin_unlock(&first->lock);
+        nc_isr_unlock(&isr_context);
+
+        if (is_stolen) {
+            return (true);
+        }
+    }
+#else
+    (void)sched;
+    (void)context;
+#endif
+
+    return (false);
+}
+
+
+
+#if (CONFIG_NC_SCHED_EDF == 1)
+static inline
+bool heap_is_before(
+    const struct nc_thread *    a,
+    const struct nc_thread *    b)
+{
+    if ((a->relative_deadline == 0u) != (b->relative_deadline == 0u)) {
+        return (a->relative_deadline != 0u);   /* Threads with deadline first */
+    }
+
+    if ((a->relative_deadline != 0u) && (a->deadline != b->deadline)) {
+        return ((int32_t)(a->deadline - b->deadline) < 0);
+    }
+
+    if (a->priority != b->priority) {
+        return (a->priority > b->priority);
+    }
+
+    return ((int32_t)(a->sequence - b->sequence) < 0);
+}
+
+
+
+static inline
+void heap_sift_up(
+    struct nc_context *         context,
+    size_t                      index)
+{
+    struct nc_thread *          thread;
+
+    thread = context->heap[index];
+
+    while (index != 0u) {
+        size_t                  parent;
+
+        parent = (index - 1u) / 2u;
+
+        if (!heap_is_before(thread, context->heap[parent])) {
+            break;
+        }
+        context->heap[index]             = context->heap[parent];
+        context->heap[index]->heap_index = index;
+        index                            = parent;
+    }
+    context->heap[index] = thread;
+    thread->heap_index   = index;
+}
+
+
+
+static inline
+void heap_sift_down(
+    struct nc_context *         context,
+    size_t                      index)
+{
+    struct nc_thread *          thread;
+
+    thread = context->heap[index];
+
+    for (;;) {
+        size_t                  child;
+
+        child = index * 2u + 1u;
+
+        if (child >= context->heap_size) {
+            break;
+        }
+
+        if (((child + 1u) < context->heap_size) &&
+            heap_is_before(context->heap[child + 1u], context->heap[child])) {
+            child++;                               /* Take the earlier child */
+        }
+
+        if (!heap_is_before(context->heap[child], thread)) {
+            break;
+        }
+        context->heap[index]             = context->heap[child];
+        context->heap[index]->heap_index = index;
+        index                            = child;
+    }
+    context->heap[index] = thread;
+    thread->heap_index   = index;
+}
+#endif
+
+
+
+static inline
+bool ready_is_empty(
+    const struct nc_context *   context)
+{
+#if (CONFIG_NC_SCHED_EDF == 1)
+    return (context->heap_size == 0u);
+#else
+    return (nc_bitmap_is_empty(&context->bitmap));
+#endif
+}
+
+
+
+static inline
+struct nc_thread * ready_get_highest(
+    const struct nc_context *   context)
+{
+#if (CONFIG_NC_SCHED_EDF == 1)
+    return (context->heap[0]);
+#else
+    return (context->ready[nc_bitmap_get_highest(&context->bitmap)]);
+#endif
+}
+
+
+
+static inline
+struct nc_thread * ready_take(
+    struct nc_context *         context)
+{
+    struct nc_thread *          thread;
+
+#if (CONFIG_NC_SCHED_EDF == 1)
+    thread           = context->heap[0];
+    thread->sequence = context->sequence++;   /* Behind other equal threads */
+    heap_sift_down(context, 0u);
+#else
+    uint_fast8_t                priority;
+                                                    /* Get the highest level */
+    priority = nc_bitmap_get_highest(&context->bitmap);
+    thread   = context->ready[priority];
+# if (CONFIG_NC_WEIGHTED_RR == 1)
+    if (--thread->credit == 0u) {        /* Rotate when its turn is used up */
+        thread->credit           = thread->weight;
+        context->ready[priority] = thread->next;
+    }
+# else
+                                              /* Round-robin for other tasks */
+    context->ready[priority] = thread->next;
+# endif
+#endif
+
+    return (thread);
+}
+
+
+
+static inline
+void ready_insert(
+    struct nc_context *         context,
+    struct nc_thread *          thread)
+{
+#if (CONFIG_NC_SCHED_EDF == 1)
+    context->heap[context->heap_size] = thread;
+    heap_sift_up(context, context->heap_size++);
+#else
+    uint_fast8_t                priority;
+
+    priority = thread->priority;
+# if (CONFIG_NC_WEIGHTED_RR == 1)
+    thread->credit = thread->weight;               /* Start with a full turn */
+# endif
+
+    if (context->ready[priority] == NULL) {     /* Is this the first thread? */
+        context->ready[priority] = thread;        /* Mark this level as used */
+        nc_bitmap_set(&context->bitmap, priority);
+    } else {
+        nc_thread *         sentinel = context->ready[priority];
+
+        thread->next         = sentinel;
+        thread->prev         = sentinel->prev;
+        sentinel->prev->next = thread;
+        sentinel->prev       = thread;
+    }
+#endif
+}
+
+
+
+static inline
+void ready_remove(
+    struct nc_context *         context,
+    struct nc_thread *          thread)
+{
+#if (CONFIG_NC_SCHED_EDF == 1)
+    size_t                      index;
+
+    index = thread->heap_index;
+    context->heap_size--;
+
+    if (index != context->heap_size) {       /* Fill the hole with the last */
+        context->heap[index]             = context->heap[context->heap_size];
+        context->heap[index]->heap_index = index;
+        heap_sift_up(context, index);
+        heap_sift_down(context, context->heap[index]->heap_index);
+    }
+#else
+    uint_fast8_t                priority;
+
+    priority = thread->priority;
+
+    if (thread->next == thread) {        /* Is this the last thread in list? */
+        context->ready[priority] = NULL;
+        nc_bitmap_clear(&context->bitmap, priority);
+    } else {
+        if (context->ready[priority] == thread) {
+            context->ready[priority] = thread->next;
+        }
+        thread->next->prev = thread->prev;
+        thread->prev->next = thread->next;
+        thread->next       = thread;
+        thread->prev       = thread;
+    }
+#endif
+}
+
+
+
+static inline
+void thread_make_ready(
+    struct nc_context *         context,
+    struct nc_thread *          thread)
+{
+    if (thread->state != NC_STATE_READY) {   /* Is the thread already ready? */
+#if (CONFIG_NC_SCHED_EDF == 1)
+        thread->deadline = nc_timer_get_ticks() + thread->relative_deadline;
+        thread->sequence = context->sequence++;       /* A new job release */
+#endif
+        ready_insert(context, thread);
+        thread->state = NC_STATE_READY;
+#if (CONFIG_NC_TIMER == 1)
+        {
+            struct nc_timer *   delay;
+                                    /* Made ready by something else than its */
+            delay = &thread_cold(thread)->delay;      /* own delay timer.    */
+
+            if (nc_timer_is_pending(delay)) {
+                nc_timer_cancel(delay);
+            }
+        }
+#endif
+#if (CONFIG_NC_PROFILE == 1)
+        thread_cold(thread)->ready_time = nc_cpu_cycles();
+#endif
+        thread_trace(thread, NC_TRACE_READY);
+    }
+}
+
+
+
+static inline
+void thread_make_blocked(
+    struct nc_context *         context,
+    struct nc_thread *          thread)
+{
+    if (thread->state == NC_STATE_READY) {   /* Only ready threads are linked */
+        ready_remove(context, thread);
+    }
+    thread->state = NC_STATE_BLOCKED;
+    thread_trace(thread, NC_TRACE_BLOCK);
+}
+
+
+
+static inline
+void thread_dispatch(
+    struct nc_thread *          thread)
+{
+#if (CONFIG_NC_PROFILE == 1)
+    struct nc_thread_cold *     cold;
+    struct nc_thread_stats *    stats;
+    uint64_t                    start;
+    uint64_t                    elapsed;
+
+    thread_trace(thread, NC_TRACE_DISPATCH_BEGIN);
+    cold  = thread_cold(thread);
+    stats = &cold->stats;
+    start = nc_cpu_cycles();
+    elapsed = start - cold->ready_time;            /* Ready to run latency */
+    stats->latency_total += elapsed;
+
+    if (stats->latency_max < elapsed) {
+        stats->latency_max = elapsed;
+    }
+    thread->fn(thread->stack);                         /* Execute the thread */
+    cold->ready_time = nc_cpu_cycles();     /* If it is still ready it waits */
+    elapsed = cold->ready_time - start;             /* from now on.          */
+    stats->dispatches++;
+    stats->exec_total += elapsed;
+
+    if (stats->exec_min > elapsed) {
+        stats->exec_min = elapsed;
+    }
+
+    if (stats->exec_max < elapsed) {
+        stats->exec_max = elapsed;
+    }
+#else
+    thread_trace(thread, NC_TRACE_DISPATCH_BEGIN);
+    thread->fn(thread->stack);                         /* Execute the thread */
+#endif
+#if (CONFIG_NC_SCHED_EDF == 1)
+    if ((thread->state != NC_STATE_READY) &&        /* Is the job finished  */
+        (thread->relative_deadline != 0u) &&        /* after its deadline?  */
+        ((int32_t)(nc_timer_get_ticks() - thread->deadline) > 0)) {
+        thread_cold(thread)->deadline_misses++;
+    }
+#endif
+    thread_trace(thread, NC_TRACE_DISPATCH_END);
+}
+
+
+
+static inline
+void thread_trace(
+    const struct nc_thread *    thread,
+    uint_fast8_t                event)
+{
+#if (CONFIG_NC_TRACE == 1)
+    uint32_t                    id;
+
+# if (CONFIG_NC_NUM_OF_THREADS != 0)
+    struct nc_sched *           sched;
+
+    sched = thread_sched(thread);                   /* Index in thread pool */
+
+    if (thread_is_pooled(sched, thread)) {
+        id = (uint32_t)((size_t)(sched - &g_sched[0]) *
+            CONFIG_NC_NUM_OF_THREADS + (size_t)(thread - &sched->threads[0]));
+    } else {
+        id = (uint32_t)(uintptr_t)thread;
+    }
+# else
+    id = (uint32_t)(uintptr_t)thread;
+# endif
+    nc_trace_write((nc_trace_event)event, id, thread->priority,
+        thread->state);
+#else
+    (void)thread;
+    (void)event;
+#endif
+}
+
+
+
+static inline
+void inbox_push(
+    struct nc_context *         context,
+    struct nc_thread *          thread)
+{
+#if (CONFIG_NC_READY_INBOX == 1)
+    void *                      head;
+
+    do {
+        head = nc_atomic_ptr_load(&context->inbox);
+        nc_atomic_ptr_store(&thread->inbox_next,
+            (head != NULL) ? head : &g_inbox_end);
+    } while (!nc_atomic_ptr_cas(&context->inbox, head, thread));
+#else
+    (void)context;
+    (void)thread;
+#endif
+}
+
+
+
+static inline
+void inbox_drain(
+    struct nc_context *         context)
+{
+#if (CONFIG_NC_READY_INBOX == 1)
+    void *                      batch;
+    void *                      reversed;
+
+    if (nc_atomic_ptr_load(&context->inbox) == NULL) {    /* Cheap check */
+        return;
+    }
+    batch    = nc_atomic_ptr_swap(&context->inbox, NULL);
+    reversed = &g_inbox_end;
+                                /* Pushes are LIFO ordered, reverse the batch */
+    while (batch != &g_inbox_end) {          /* to keep FIFO ready order.   */
+        struct nc_thread *      thread = batch;
+
+        batch    = nc_atomic_ptr_load(&thread->inbox_next);
+        nc_atomic_ptr_store(&thread->inbox_next, reversed);
+        reversed = thread;
+    }
+
+    while (reversed != &g_inbox_end) {
+        struct nc_thread *      thread = reversed;
+
+        reversed = nc_atomic_ptr_load(&thread->inbox_next);
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+        if (thread->context != context) {    /* Thread was stolen meanwhile, */
+            inbox_push(thread->context, thread); /* forward it to its owner. */
+
+            continue;
+        }
+# endif
+        nc_atomic_ptr_store(&thread->inbox_next, NULL);    /* Release it */
+        thread_make_ready(context, thread);
+    }
+#else
+    (void)context;
+#endif
+}
+
+
+
+static inline
+bool defer_is_due(
+    struct nc_context *         context)
+{
+#if (CONFIG_NC_DEFER == 1)
+    if (!nc_defer_is_pending()) {
+        return (false);
+    }
+#if (CONFIG_NC_DEFER_PRIO >= CONFIG_NC_NUM_OF_PRIO_LEVELS - 1)
+    (void)context;                  /* No thread has higher priority */
+
+    return (true);
+#else
+    return (ready_is_empty(context) ||
+        (ready_get_highest(context)->priority <= CONFIG_NC_DEFER_PRIO));
+#endif
+#else
+    (void)context;
+
+    return (false);
+#endif
+}
+
+
+
+static inline
+bool context_has_work(
+    struct nc_context *         context)
+{
+    nc_isr_lock                 isr_context;
+    bool                        has_work;
+
+    context_lock(context, &isr_context);
+    has_work = !ready_is_empty(context);
+    context_unlock(context, &isr_context);
+#if (CONFIG_NC_READY_INBOX == 1)
+    if (nc_atomic_ptr_load(&context->inbox) != NULL) {
+        has_work = true;
+    }
+#endif
+#if (CONFIG_NC_DEFER == 1)
+    if (nc_defer_is_pending()) {
+        has_work = true;
+    }
+#endif
+
+    return (has_work);
+}
+
+
+
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_TIMER == 1)
+static
+uint64_t idle_timer_sync(void)
+{
+    uint64_t                    now;
+    uint64_t                    elapsed;
+    nc_tick                     ticks;
+
+    now = nc_cpu_time_ns();
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_idle_lock);
+# endif
+    if (g_idle_tick_time == 0u) {                      /* The first call */
+        g_idle_tick_time = now;
+    }
+    ticks             = (nc_tick)((now - g_idle_tick_time) /
+        CONFIG_NC_TIMER_TICK_NS);
+    g_idle_tick_time += (uint64_t)ticks * CONFIG_NC_TIMER_TICK_NS;
+    elapsed           = now - g_idle_tick_time;
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_idle_lock);
+# endif
+    nc_timer_advance(ticks);
+
+    return (elapsed);
+}
+#endif
+
+
+
+
+static
+bool sched_run(
+    struct nc_sched *           sched,
+    uint32_t                    max_dispatches,
+    uint64_t                    max_ns)
+{
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
+    uint32_t                    dispatches;
+    bool                        has_work;
+#if defined(NCPU_TIME)
+    uint64_t                    start;
+#endif
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    struct nc_context *         active;
+#endif
+    context    = &sched->context[core_this()];
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+                              /* Make the instance visible to thread functions */
+    active         = *active_this();
+    *active_this() = context;
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    sched->home    = context;
+# endif
+#endif
+    dispatches = 0u;
+#if defined(NCPU_TIME)
+    start      = (max_ns != 0u) ? nc_cpu_time_ns() : 0u;
+#else
+    (void)max_ns;
+#endif
+
+    do {
+        context_lock(context, &isr_context);
+        inbox_drain(context);
+                                    /* While there are ready tasks in system */
+        while ((has_work = (defer_is_due(context) ||
+                !ready_is_empty(context)))) {
+            struct nc_thread *  new_thread;
+
+            if ((max_dispatches != 0u) && (dispatches == max_dispatches)) {
+                break;                             /* Budget is used up */
+            }
+#if defined(NCPU_TIME)
+            if ((max_ns != 0u) && (dispatches != 0u) &&
+                ((nc_cpu_time_ns() - start) >= max_ns)) {
+                break;
+            }
+#endif
+            dispatches++;
+
+            if (defer_is_due(context)) {    /* Deferred calls go first when */
+                context->current = NULL; /* no thread has higher priority. */
+                context_unlock(context, &isr_context);
+#if (CONFIG_NC_DEFER == 1)
+                nc_defer_run();
+#endif
+                context_lock(context, &isr_context);
+                inbox_drain(context);
+
+                continue;
+            }
+                                                       /* Fetch the new task */
+            new_thread       = ready_take(context);
+            context->current = new_thread;
+            context_unlock(context, &isr_context);
+            thread_dispatch(new_thread);
+            context_lock(context, &isr_context);
+            inbox_drain(context);
+        }
+        context->current = NULL; /* We are exiting the loop, no task active */
+        context_unlock(context, &isr_context);
+    } while (!has_work &&                   /* When idle help other cores */
+             context_steal(sched, context));
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+    *active_this() = active;
+#endif
+
+    return (has_work);
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1)
+nc_sched * nc_sched_create(void)
+{
+    nc_isr_lock                 isr_context;
+    nc_sched *                  sched;
+
+    sched = NULL;
+    nc_isr_lock_save(&isr_context);
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_sched_lock);
+# endif
+                             /* The first instance is always the default one */
+    for (size_t itr = 1u; itr < CONFIG_NC_NUM_OF_SCHEDULERS; itr++) {
+        if (!g_sched[itr].is_used) {
+            sched          = &g_sched[itr];
+            sched->is_used = true;
+            break;
+        }
+    }
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_sched_lock);
+# endif
+    nc_isr_unlock(&isr_context);
+
+    return (sched);
+}
+
+
+
+void nc_sched_destroy(
+    nc_sched *                  sched)
+{
+    nc_isr_lock                 isr_context;
+
+# if (CONFIG_NC_NUM_OF_THREADS == 0)
+    nc_slab_term(&sched->slab);          /* Return all thread memory at once */
+# endif
+    nc_isr_lock_save(&isr_context);
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_sched_lock);
+# endif
+    memset(sched, 0, sizeof(*sched));       /* Zero state is an empty instance */
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_sched_lock);
+# endif
+    nc_isr_unlock(&isr_context);
+}
+#endif
+
+
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0)
+void nc_sched_set_allocator(
+    nc_sched *                  sched,
+    const nc_allocator *        allocator)
+{
+    sched->allocator = allocator;
+}
+#endif
+
+
+
+nc_sched * nc_sched_get_default(void)
+{
+    return (&g_sched[0]);
+}
+
+
+
+nc_thread * nc_sched_thread_create(
+    nc_sched *                  sched,
+    nc_thread_fn *              fn,
+    void *                      stack,
+    uint_fast8_t                priority)
+{
+    nc_isr_lock                 isr_context;
+    nc_thread *                 new_thread;
+
+#if (CONFIG_NC_NUM_OF_THREADS != 0)
+    nc_isr_lock_save(&isr_context);
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&sched->threads_lock);
+# endif
+    new_thread = sched->threads_free;
+                                           /* Take a recycled thread first...*/
+    if (new_thread != NULL) {
+        sched->threads_free = new_thread->next;
+    } else if (sched->threads_used != CONFIG_NC_NUM_OF_THREADS) {
+        new_thread = &sched->threads[sched->threads_used++]; /* ...then new */
+    }
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&sched->threads_lock);
+# endif
+    nc_isr_unlock(&isr_context);
+#else
+    (void)isr_context;
+
+    if (sched->allocator != NULL) {
+        new_thread = sched->allocator->alloc(sched->allocator->context,
+            sizeof(nc_thread));
+    } else {
+        new_thread = nc_slab_allocator_alloc(&sched->slab, sizeof(nc_thread));
+    }
+#endif
+
+    if (new_thread != NULL) {
+        thread_init(sched, new_thread, fn, stack, priority);
+    }
+
+    return (new_thread);
+}
+
+
+
+nc_thread * nc_thread_create(
+    nc_thread_fn *              fn,
+    void *                      stack,
+    uint_fast8_t                priority)
+{
+    return (nc_sched_thread_create(&g_sched[0], fn, stack, priority));
+}
+
+
+
+#if defined(__GNUC__)
+void nc_thread_create_defined(void)
+{
+    const struct nc_thread_define * define;
+
+    for (define  = __start_nc_thread_defines;
+         define != __stop_nc_thread_defines;
+         define++) {
+        thread_init(&g_sched[0], define->thread, define->fn, define->stack,
+            define->priority);
+
+        if (define->autostart) {
+            nc_thread_ready(define->thread);
+        }
+    }
+}
+#endif
+
+
+
+void nc_thread_destroy(
+    nc_thread *                 thread)
+{
+    nc_thread_block(thread);
+#if (CONFIG_NC_TIMER == 1)
+    nc_timer_cancel(&thread_cold(thread)->delay);
+#endif
+    thread_trace(thread, NC_TRACE_DESTROY);
+#if (CONFIG_NC_NUM_OF_THREADS != 0)
+    {
+        nc_isr_lock             isr_context;
+        struct nc_sched *       sched;
+
+        sched = thread_sched(thread);
+        nc_isr_lock_save(&isr_context);
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+        nc_spin_lock(&sched->threads_lock);
+# endif
+        thread->state       = NC_STATE_UNINITIALIZED;    /* Mark it as free */
+        thread->next        = sched->threads_free;  /* and return it to pool */
+        sched->threads_free = thread;
+# if (CONFIG_NC_NUM_OF_CORES > 1)
+        nc_spin_unlock(&sched->threads_lock);
+# endif
+        nc_isr_unlock(&isr_context);
+    }
+#else
+    {
+        struct nc_sched *       sched;
+
+        sched = thread_sched(thread);
+
+        if (sched->allocator != NULL) {
+            sched->allocator->free(sched->allocator->context, thread);
+        } else {
+            nc_slab_free(&sched->slab, thread);
+        }
+    }
+#endif
+}
 
-#define BITMAP_GROUPS                                                       \
-    DIVISION_ROUNDUP(CONFIG_NC_NUM_OF_PRIO_LEVELS, NCPU_DATA_WIDTH)
 
-/*=====================================================  LOCAL DATA TYPES  ==*/
 
-struct nc_thread
+void nc_thread_ready(
+    nc_thread *                 thread)
 {
-    struct nc_thread *          next;
-    struct nc_thread *          prev;
-    void                     (* fn)(void *);
-    void *                      stack;
-    uint_fast8_t                priority;
-    nc_cpu_reg                  ref;
-};
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
 
-struct nc_bitmap
-{
-#if     (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
-    nc_cpu_reg                  group;
+    context = context_lock_thread(thread, &isr_context);
+
+    thread_make_ready(context, thread);
+    context_unlock(context, &isr_context);
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_NUM_OF_CORES > 1)
+    if (context != context_this()) {        /* Other core may be sleeping */
+        nc_cpu_idle_wake();
+    }
 #endif
-    nc_cpu_reg                  level[BITMAP_GROUPS];
-};
+}
 
-struct nc_context
-{
-    struct nc_bitmap            bitmap;
-    struct nc_thread *          current;
-    struct nc_thread *          ready[CONFIG_NC_NUM_OF_PRIO_LEVELS];
-};
 
-/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
 
+#if (CONFIG_NC_READY_INBOX == 1)
+void nc_thread_ready_async(
+    nc_thread *                 thread)
+{
+    struct nc_context *         context;
+                                     /* Claim the thread, if it is already   */
+                                     /* waiting in an inbox we are done.     */
+    if (!nc_atomic_ptr_cas(&thread->inbox_next, NULL, &g_inbox_end)) {
+        return;
+    }
+    context = thread_context(thread);
+    inbox_push(context, thread);
+# if (CONFIG_NC_IDLE == 1)
+    nc_cpu_idle_wake();
+# endif
+}
+#endif
 
-/**@brief       Set a bit corresponding to the the given priority
- */
-static inline
-void bitmap_set(
-    struct nc_bitmap *          bitmap,
-    uint_fast8_t                priority);
 
 
+void nc_thread_done(void)
+{
+    nc_thread_block(nc_thread_get_current());
+}
 
-/**@brief       Clear a bit corresponding to the the given priority
- */
-static inline
-void bitmap_clear(
-    struct nc_bitmap *          bitmap,
-    uint_fast8_t                priority);
 
 
+void nc_thread_block(
+    nc_thread *                 thread)
+{
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
 
-/**@brief       Get the highest set bit priority level
- */
-static inline
-uint_fast8_t bitmap_get_highest(
-    const struct nc_bitmap *    bitmap);
+    context = context_lock_thread(thread, &isr_context);
+    thread_make_blocked(context, thread);
+    context_unlock(context, &isr_context);
+}
 
 
 
-/**@brief       Is the bitmap empty?
- * @return
- * @retval      true  - no bit is set
- * @retval      false - at least one bit is set
- */
-static inline
-bool bitmap_is_empty(
-    const struct nc_bitmap *    bitmap);
+void nc_thread_ready_many(
+    nc_thread * const *         threads,
+    size_t                      count)
+{
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_NUM_OF_CORES > 1)
+    bool                        is_remote;
 
-/*======================================================  LOCAL VARIABLES  ==*/
+    is_remote = false;
+#endif
+    context   = NULL;
 
-#if (CONFIG_NC_NUM_OF_THREADS != 0)
-/**@brief       Pool memory for task structures which are allocated through
- *              nc_thread_create() function.
- */
-static struct nc_thread   g_threads[CONFIG_NC_NUM_OF_THREADS];
+    for (size_t itr = 0u; itr < count; itr++) {
+        context = context_relock_thread(context, threads[itr], &isr_context);
+        thread_make_ready(context, threads[itr]);
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_NUM_OF_CORES > 1)
+        is_remote |= (context != context_this());
 #endif
+    }
 
-/**@brief       Scheduler current context
- */
-static struct nc_context  g_context;
+    if (context != NULL) {
+        context_unlock(context, &isr_context);
+    }
+#if (CONFIG_NC_IDLE == 1) && (CONFIG_NC_NUM_OF_CORES > 1)
+    if (is_remote) {                       /* Other cores may be sleeping */
+        nc_cpu_idle_wake();
+    }
+#endif
+}
 
-/*=====================================================  GLOBAL VARIABLES  ==*/
-/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
 
 
-static inline
-void bitmap_set(
-    struct nc_bitmap *          bitmap,
-    uint_fast8_t                priority)
+void nc_thread_block_many(
+    nc_thread * const *         threads,
+    size_t                      count)
 {
-#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
-    uint_fast8_t                group;
-    uint_fast8_t                index;
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
 
-    index = priority &
-        ((uint_fast8_t)~0u >> (sizeof(priority) * 8u - LOG2_8(NCPU_DATA_WIDTH)));
-    group = priority >> LOG2_8(NCPU_DATA_WIDTH);
-    bitmap->group        |= nc_exp2(group);
-    bitmap->level[group] |= nc_exp2(index);
-#else
-    bitmap->level[0]     |= nc_exp2(priority);
-#endif
-}
+    context = NULL;
 
+    for (size_t itr = 0u; itr < count; itr++) {
+        context = context_relock_thread(context, threads[itr], &isr_context);
+        thread_make_blocked(context, threads[itr]);
+    }
 
+    if (context != NULL) {
+        context_unlock(context, &isr_context);
+    }
+}
 
-static inline
-void bitmap_clear(
-    struct nc_bitmap *          bitmap,
-    uint_fast8_t                priority)
-{
-#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
-    uint_fast8_t                group;
-    uint_fast8_t                index;
 
-    index = priority &
-        ((uint_fast8_t)~0u >> (sizeof(priority) * 8u - LOG2_8(NCPU_DATA_WIDTH)));
-    group = priority >> LOG2_8(NCPU_DATA_WIDTH);
-    bitmap->level[group] &= (nc_cpu_reg)~nc_exp2(index);
 
-    if (bitmap->level[group] == 0u) {  /* If this is the last bit cleared in */
-                                       /* this level group then clear group  */
-                                       /* bit indicator, too.                */
-        bitmap->group &= (nc_cpu_reg)~nc_exp2(group);
+bool nc_thread_group_add(
+    nc_thread_group *           group,
+    nc_thread *                 thread)
+{
+    if (group->count == group->capacity) {
+        return (false);
     }
-#else
-    bitmap->level[0]  &= (nc_cpu_reg)~nc_exp2(priority);
-#endif
+    group->threads[group->count++] = thread;
+
+    return (true);
 }
 
 
 
-static inline
-uint_fast8_t bitmap_get_highest(
-    const struct nc_bitmap *    bitmap)
+void nc_thread_group_remove(
+    nc_thread_group *           group,
+    nc_thread *                 thread)
 {
-#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
-    uint_fast8_t                group;
-    uint_fast8_t                index;
-
-    group = nc_log2(bitmap->group);
-    index = nc_log2(bitmap->level[group]);
+    for (size_t itr = 0u; itr < group->count; itr++) {
+        if (group->threads[itr] == thread) {    /* Move the last one here */
+            group->threads[itr] = group->threads[--group->count];
+            break;
+        }
+    }
+}
 
-    return ((uint_fast8_t)((group << LOG2_8(NCPU_DATA_WIDTH)) | index));
-#else
-    uint_fast8_t                index;
 
-    index = nc_log2(bitmap->level[0]);
 
-    return (index);
-#endif
+void nc_thread_group_ready(
+    const nc_thread_group *     group)
+{
+    nc_thread_ready_many(group->threads, group->count);
 }
 
 
 
-static inline
-bool bitmap_is_empty(
-    const struct nc_bitmap *    bitmap)
+void nc_thread_group_block(
+    const nc_thread_group *     group)
 {
-#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
-    if (bitmap->group == 0u) {
-        return (true);
-    } else {
-        return (false);
-    }
-#else
-    if (bitmap->level[0] == 0u) {
-        return (true);
-    } else {
-        return (false);
-    }
-#endif
+    nc_thread_block_many(group->threads, group->count);
 }
 
-/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
-/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
 
 
-nc_thread * nc_thread_create(
-    nc_thread_fn *              fn,
-    void *                      stack,
-    uint_fast8_t                priority)
+#if (CONFIG_NC_TIMER == 1)
+void nc_thread_delay(
+    nc_tick                     ticks)
 {
     nc_isr_lock                 isr_context;
-    nc_thread *                 new_thread;
+    struct nc_context *         context;
+    nc_thread *                 thread;
+
+    thread  = nc_thread_get_current();
+                                /* Block and start the delay at once, so the */
+                                /* thread can not be made ready in between   */
+                                /* without cancelling the delay.             */
+    context = context_lock_thread(thread, &isr_context);
+    thread_make_blocked(context, thread);
+    nc_timer_start(&thread_cold(thread)->delay, thread, ticks, 0u);
+    context_unlock(context, &isr_context);
+}
 
-    nc_isr_lock_save(&isr_context);
-#if (CONFIG_NC_NUM_OF_THREADS != 0)
-    new_thread = NULL;
-                                                          /* Find empty slot */
-    for (uint16_t itr = 0; itr < CONFIG_NC_NUM_OF_THREADS; itr++) { 
-        if (g_threads[itr].state == NC_STATE_UNINITIALIZED) {
-            new_thread = &g_threads[itr];             /* Initialize new task */
 
-            break;
-        }
-    }
-#else
-    new_thread = malloc(sizeof(nc_thread));
-#endif
-    nc_isr_unlock(&isr_context);
 
-    if (new_thread != NULL) {
-        new_thread->next     = new_thread;      /* Init linked list pointers */
-        new_thread->prev     = new_thread;
-        new_thread->fn       = fn;
-        new_thread->stack    = stack;
-        new_thread->priority = priority;
-        new_thread->state    = NC_STATE_IDLE;
+nc_tick nc_thread_delay_left(void)
+{
+    const struct nc_timer *     delay;
+    nc_tick                     left;
+
+    delay = &thread_cold(nc_thread_get_current())->delay;
+    left  = delay->expires + 1u - nc_timer_get_ticks();
+
+    if (left > ((nc_tick)~(nc_tick)0 >> 1)) {          /* Already expired */
+        left = 0u;
     }
 
-    return (new_thread);
+    return (left);
 }
+#endif
 
 
 
-void nc_thread_destroy(
-    nc_thread *                 thread)
+#if (CONFIG_NC_PROFILE == 1)
+void nc_thread_get_stats(
+    const nc_thread *           thread,
+    nc_thread_stats *           stats)
 {
-    nc_thread_block(thread);
-#if (CONFIG_NC_NUM_OF_THREADS != 0)
-    thread->state = NC_STATE_UNINITIALIZED;       /* Mark the thread as free */
-#else
-    free(thread);
-#endif
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
+
+    context = context_lock_thread(thread, &isr_context);
+    *stats  = thread_cold(thread)->stats;
+    context_unlock(context, &isr_context);
 }
 
 
 
-void nc_thread_ready(
+void nc_thread_reset_stats(
     nc_thread *                 thread)
 {
     nc_isr_lock                 isr_context;
-    uint_fast8_t                priority;
+    struct nc_context *         context;
+    struct nc_thread_stats *    stats;
+
+    context = context_lock_thread(thread, &isr_context);
+    stats   = &thread_cold(thread)->stats;
+    stats->fn            = thread->fn;
+    stats->dispatches    = 0u;
+    stats->exec_total    = 0u;
+    stats->exec_min      = UINT64_MAX;
+    stats->exec_max      = 0u;
+    stats->latency_total = 0u;
+    stats->latency_max   = 0u;
+    context_unlock(context, &isr_context);
+}
 
-    nc_isr_lock_save(&isr_context);
 
-    priority  = thread->priority;
 
-    if (g_context.ready[priority] == NULL) {    /* Is this the first thread? */
-        g_context.ready[priority] = thread;       /* Mark this level as used */
-        bitmap_set(&g_context.bitmap, priority);
-    } else {
-        nc_thread *         sentinel = g_context.ready[priority];
+# if (CONFIG_NC_NUM_OF_THREADS != 0)
+size_t nc_profile_snapshot(
+    nc_thread_stats *           stats,
+    size_t                      size)
+{
+    size_t                      count;
 
-        thread->next         = sentinel;
-        thread->prev         = sentinel->prev;
-        sentinel->prev->next = thread;
-        sentinel->prev       = thread;
+    count = 0u;
+
+    for (size_t sched = 0u; sched < CONFIG_NC_NUM_OF_SCHEDULERS; sched++) {
+        struct nc_thread *      threads = g_sched[sched].threads;
+
+        for (size_t itr = 0u;
+                (itr < g_sched[sched].threads_used) && (count < size);
+                itr++) {
+            if (threads[itr].state != NC_STATE_UNINITIALIZED) {
+                nc_thread_get_stats(&threads[itr], &stats[count]);
+                count++;
+            }
+        }
     }
-    thread->state = NC_STATE_READY;
-    nc_isr_unlock(&isr_context);
+
+    return (count);
 }
+# endif
+#endif
 
 
 
-void nc_thread_done(void)
+nc_thread * nc_thread_get_current(void)
 {
-    nc_thread_block(nc_thread_get_current());
+    return (context_this()->current);
 }
 
 
 
-void nc_thread_block(
-    nc_thread *                 thread)
+#if (CONFIG_NC_WEIGHTED_RR == 1)
+void nc_thread_set_weight(
+    nc_thread *                 thread,
+    uint_fast8_t                weight)
 {
     nc_isr_lock                 isr_context;
+    struct nc_context *         context;
+
+    if (weight == 0u) {
+        weight = 1u;
+    }
+    context = context_lock_thread(thread, &isr_context);
+    thread->weight = weight;
+
+    if (thread->credit > weight) {           /* Do not extend the current turn */
+        thread->credit = weight;
+    }
+    context_unlock(context, &isr_context);
+}
+#endif
 
-    nc_isr_lock_save(&isr_context);
 
-    if (thread->next == thread) {        /* Is this the last thread in list? */
-        uint_fast8_t        priority;
 
-        priority                  = thread->priority;
-        g_context.ready[priority] = NULL;
-        bitmap_clear(&g_context.bitmap, priority);
+#if (CONFIG_NC_SCHED_EDF == 1)
+void nc_thread_set_deadline(
+    nc_thread *                 thread,
+    nc_tick                     ticks)
+{
+    nc_isr_lock                 isr_context;
+    struct nc_context *         context;
+
+    context = context_lock_thread(thread, &isr_context);
+
+    if (thread->state == NC_STATE_READY) {   /* Reorder the current job too */
+        ready_remove(context, thread);
+        thread->relative_deadline = ticks;
+        thread->deadline          = nc_timer_get_ticks() + ticks;
+        ready_insert(context, thread);
     } else {
-        thread->next->prev = thread->prev;
-        thread->prev->next = thread->next;
+        thread->relative_deadline = ticks;
     }
-    thread->state = NC_STATE_BLOCKED;
-    nc_isr_unlock(&isr_context);
+    context_unlock(context, &isr_context);
 }
 
 
 
-nc_thread * nc_thread_get_current(void)
+uint32_t nc_thread_get_deadline_misses(
+    const nc_thread *           thread)
+{
+    return (thread_cold(thread)->deadline_misses);
+}
+#endif
+
+
+
+nc_lc * nc_thread_get_lc(void)
 {
-    return (g_context.current);
+    return (&context_this()->current->lc);
 }
 
 
@@ -344,7 +2017,7 @@ nc_thread * nc_thread_get_current(void)
 nc_thread_state nc_thread_get_state(
     const nc_thread *           thread)
 {
-    if (thread == g_context.current) {
+    if (thread == thread_context(thread)->current) {
         return NC_STATE_RUNNING;
     } else {
         return thread->state;
@@ -353,30 +2026,106 @@ nc_thread_state nc_thread_get_state(
 
 
 
+uint_fast8_t nc_thread_get_priority(
+    const nc_thread *           thread)
+{
+    return (thread->priority);
+}
+
+
+
+void nc_sched_schedule(
+    nc_sched *                  sched)
+{
+    (void)sched_run(sched, 0u, 0u);
+}
+
+
+
+bool nc_sched_schedule_for(
+    nc_sched *                  sched,
+    uint32_t                    max_dispatches,
+    uint64_t                    max_ns)
+{
+    return (sched_run(sched, max_dispatches, max_ns));
+}
+
+
+
 void nc_schedule(void)
 {
-    nc_isr_lock                 isr_context;
+    (void)sched_run(&g_sched[0], 0u, 0u);
+}
 
-    nc_isr_lock_save(&isr_context);
 
-                                    /* While there are ready tasks in system */
-    while (!bitmap_is_empty(&g_context.bitmap)) {
-        struct nc_thread *      new_thread;
-        uint_fast8_t            priority;
-                                                    /* Get the highest level */
-        priority = bitmap_get_highest(&g_context.bitmap);
-                                                       /* Fetch the new task */
-        new_thread                = g_context.ready[priority];
-        g_context.current         = new_thread;
-                                              /* Round-robin for other tasks */
-        g_context.ready[priority] = new_thread->next;
-        nc_isr_unlock(&isr_context);
-        new_thread->fn(new_thread->stack);             /* Execute the thread */
-        nc_isr_lock_save(&isr_context);
+
+bool nc_schedule_for(
+    uint32_t                    max_dispatches,
+    uint64_t                    max_ns)
+{
+    return (sched_run(&g_sched[0], max_dispatches, max_ns));
+}
+
+
+
+bool nc_schedule_one(void)
+{
+    return (sched_run(&g_sched[0], 1u, 0u));
+}
+
+#if (CONFIG_NC_IDLE == 1)
+void nc_sched_idle(
+    nc_sched *                  sched)
+{
+    uint32_t                    token;
+    uint64_t                    timeout_ns;
+
+    token      = nc_cpu_idle_prepare();  /* Wake-ups from now on are not lost */
+    timeout_ns = NCPU_IDLE_INFINITE;
+#if (CONFIG_NC_TIMER == 1)
+    {
+        uint64_t                elapsed_ns;
+        nc_tick                 ticks;
+                                         /* Expired timers may ready threads */
+        elapsed_ns = idle_timer_sync();
+        ticks      = nc_timer_idle_ticks();
+
+        if (ticks != NC_TIMER_INFINITE) {  /* Sleep until the tick with work */
+            timeout_ns = (uint64_t)ticks * CONFIG_NC_TIMER_TICK_NS - elapsed_ns;
+        }
     }
-    g_context.current = NULL;  /* We are exiting the loop, no task is active */
-    nc_isr_unlock(&isr_context);
+#endif
+
+#if (CONFIG_NC_IO == 1)
+    if (context_has_work(&sched->context[core_this()])) {
+        timeout_ns = 0u;                 /* Only poll, do not starve the I/O */
+    }
+    nc_io_idle_sleep(token, timeout_ns);
+#else
+    if (!context_has_work(&sched->context[core_this()])) {
+        nc_cpu_idle_sleep(token, timeout_ns);
+    }
+#endif
+#if (CONFIG_NC_TIMER == 1)
+    (void)idle_timer_sync();
+#endif
+}
+
+
+
+void nc_idle(void)
+{
+    nc_sched_idle(&g_sched[0]);
+}
+#endif
+
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+void nc_core_attach(
+    uint_fast8_t                core)
+{
+    nc_cpu_id_set(core);
 }
+#endif
 
 /*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
 
@@ -384,6 +2133,59 @@ void nc_schedule(void)
 # error "nanocoop: CONFIG_NUM_OF_PRIO_LEVELS is out of range, the number of priority levels is beyond hardware capability."
 #endif
 
+#if (CONFIG_NC_NUM_OF_CORES > 1) && !defined(NCPU_SMP)
+# error "nanocoop: CONFIG_NC_NUM_OF_CORES is out of range, the port does not support multiple cores."
+#endif
+
+#if (CONFIG_NC_READY_INBOX == 1) && !defined(NCPU_ATOMIC)
+# error "nanocoop: CONFIG_NC_READY_INBOX is enabled, but the port does not support atomic operations."
+#endif
+
+#if (CONFIG_NC_IDLE == 1) && !defined(NCPU_IDLE)
+# error "nanocoop: CONFIG_NC_IDLE is enabled, but the port does not support idle sleep."
+#endif
+
+#if (CONFIG_NC_IO == 1) && !defined(NCPU_IO)
+# error "nanocoop: CONFIG_NC_IO is enabled, but the port does not support I/O."
+#endif
+
+#if (CONFIG_NC_IO == 1) && (CONFIG_NC_IDLE == 0)
+# error "nanocoop: CONFIG_NC_IO requires CONFIG_NC_IDLE, descriptor events are collected by nc_idle()."
+#endif
+
+#if (CONFIG_NC_PROFILE == 1) && !defined(NCPU_PROFILE)
+# error "nanocoop: CONFIG_NC_PROFILE is enabled, but the port does not provide a cycle counter."
+#endif
+
+#if (CONFIG_NC_WEIGHTED_RR == 1) && (CONFIG_NC_SCHED_EDF == 1)
+# error "nanocoop: CONFIG_NC_WEIGHTED_RR can not be used with CONFIG_NC_SCHED_EDF."
+#endif
+
+#if (CONFIG_NC_SCHED_EDF == 1) && (CONFIG_NC_TIMER == 0)
+# error "nanocoop: CONFIG_NC_SCHED_EDF requires CONFIG_NC_TIMER, deadlines are measured in timer ticks."
+#endif
+
+#if (CONFIG_NC_SCHED_EDF == 1) && (CONFIG_NC_NUM_OF_THREADS == 0)
+# error "nanocoop: CONFIG_NC_SCHED_EDF requires a static thread pool, CONFIG_NC_NUM_OF_THREADS must not be 0."
+#endif
+
+#if (CONFIG_NC_THREAD_SPLIT == 1) && (CONFIG_NC_NUM_OF_THREADS == 0)
+# error "nanocoop: CONFIG_NC_THREAD_SPLIT requires a static thread pool, CONFIG_NC_NUM_OF_THREADS must not be 0."
+#endif
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS < 1)
+# error "nanocoop: CONFIG_NC_NUM_OF_SCHEDULERS is out of range, at least the default instance is needed."
+#endif
+
+#if (CONFIG_NC_NUM_OF_PRIO_LEVELS > 256)
+# error "nanocoop: CONFIG_NUM_OF_PRIO_LEVELS is out of range, thread priority is limited to uint_fast8_t range."
+#endif
+
+/**@brief       Compile time check that nc_thread_storage can hold a thread
+ */
+typedef char nc_thread_storage_check[
+    (sizeof(struct nc_thread_static) <= sizeof(nc_thread_storage)) ? 1 : -1];
+
 /** @endcond *//** @} *//******************************************************
  * END of ncsched.c
  ******************************************************************************/
@@ -31,8 +31,12 @@
 
 /*========================================================  INCLUDE FILES  ==*/
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "nc_config.h"
+
 /*==============================================================  MACRO's  ==*/
 
 /**@brief       Nanocoop version number
@@ -42,6 +46,75 @@
  */
 #define NC_VERSION                      0x010201
 
+/**@brief       Number of words in nc_thread_storage
+ * @details     An upper bound of the thread structure size, including the
+ *              members which are kept apart with `CONFIG_NC_THREAD_SPLIT`.
+ *              Each member takes at most one word, 64-bit members two.
+ */
+#define NC_THREAD_STORAGE_WORDS                                             \
+    (7u + 5u * CONFIG_NC_TIMER + 14u * CONFIG_NC_PROFILE +                  \
+     5u * CONFIG_NC_SCHED_EDF + 2u * CONFIG_NC_WEIGHTED_RR +                \
+     CONFIG_NC_READY_INBOX + ((CONFIG_NC_NUM_OF_CORES > 1) ? 1u : 0u) +    \
+     ((CONFIG_NC_NUM_OF_SCHEDULERS > 1) ? 1u : 0u))
+
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+/**@brief       Define a thread which is initialized at start-up
+ * @param       name
+ *              Name of thread pointer variable of type `nc_thread *`. It
+ *              points to statically allocated thread storage.
+ * @param       fn
+ *              Pointer to thread function.
+ * @param       stack
+ *              Thread stack pointer.
+ * @param       priority
+ *              Thread priority.
+ * @param       autostart
+ *              When true the thread is made ready after it is initialized.
+ * @details     The thread structure is not taken from the thread pool, it is
+ *              allocated statically next to the definition. The definition is
+ *              a constant record which is placed in the `nc_thread_defines`
+ *              linker section, so definitions from all translation units form
+ *              one table without any code. All defined threads are
+ *              initialized in a single pass by nc_thread_create_defined().
+ *              When a custom linker script is used it must keep this section
+ *              and provide `__start_nc_thread_defines` and
+ *              `__stop_nc_thread_defines` symbols, like GNU ld does by
+ *              default. Defined threads belong to the default instance and
+ *              they must not be destroyed.
+ * @note        Available only with GCC compatible compilers.
+ */
+#define NC_THREAD_DEFINE(name, fn, stack, priority, autostart)              \
+    static nc_thread_storage name ## _storage;                              \
+    nc_thread * name = (nc_thread *)&name ## _storage;                      \
+    static const struct nc_thread_define name ## _define                    \
+        __attribute__((section("nc_thread_defines"), used,                  \
+            aligned(sizeof(void *)))) =                                     \
+    {                                                                       \
+        (nc_thread *)&name ## _storage,                                     \
+        (fn),                                                               \
+        (stack),                                                            \
+        (priority),                                                         \
+        (autostart)                                                         \
+    }
+#endif
+
+/**@brief       Define a statically allocated thread group
+ * @param       name
+ *              Name of group variable of type nc_thread_group.
+ * @param       capacity
+ *              Maximum number of threads in the group.
+ * @details     The group and its storage are local to the translation unit,
+ *              pass a pointer to the group to share it.
+ */
+#define NC_THREAD_GROUP_DEFINE(name, capacity)                              \
+    static nc_thread * name ## _threads[(capacity)];                        \
+    static nc_thread_group name =                                           \
+    {                                                                       \
+        name ## _threads,                                                   \
+        (capacity),                                                         \
+        0u                                                                  \
+    }
+
 /*-----------------------------------------------------  C++ extern begin  --*/
 #ifdef __cplusplus
 extern "C" {
@@ -74,10 +147,194 @@ typedef void (nc_thread_fn)(void *);
  */
 typedef struct nc_thread nc_thread;
 
+/**@brief       Memory allocator interface
+ * @details     Used for thread descriptors when `CONFIG_NC_NUM_OF_THREADS` is
+ *              0, see nc_sched_set_allocator().
+ */
+struct nc_allocator
+{
+    void *                   (* alloc)(void * context, size_t size);
+    void                     (* free)(void * context, void * mem);
+    void *                      context;    /**<@brief Passed to functions   */
+};
+
+/**@brief       Memory allocator type
+ */
+typedef struct nc_allocator nc_allocator;
+
+/**@brief       Scheduler instance opaque type
+ * @details     Each instance has its own thread pool, ready bitmap and ready
+ *              lists. The global API works with the default instance.
+ */
+typedef struct nc_sched nc_sched;
+
+/**@brief       Timer tick type
+ */
+typedef uint32_t nc_tick;
+
+/**@brief       Local continuation type
+ * @details     Holds the resume point of a thread which is using nc_pt.h
+ *              macros. Value 0 means the beginning of thread function.
+ */
+typedef uint16_t nc_lc;
+
+/**@brief       Thread group structure
+ * @details     A group is a set of threads which are made ready or blocked
+ *              together. Use NC_THREAD_GROUP_DEFINE() to allocate a group.
+ *              Members of this structure are private.
+ */
+struct nc_thread_group
+{
+    nc_thread **                threads;
+    size_t                      capacity;
+    size_t                      count;
+};
+
+/**@brief       Thread group type
+ */
+typedef struct nc_thread_group nc_thread_group;
+
+/**@brief       Word of thread storage
+ */
+union nc_thread_word
+{
+    void *                      pointer;
+    size_t                      size;
+    uint32_t                    tick;
+#if (CONFIG_NC_PROFILE == 1)
+    uint64_t                    cycles;
+#endif
+};
+
+/**@brief       Storage for a statically allocated thread
+ * @details     Created by NC_THREAD_DEFINE() macro. Its size depends only on
+ *              the configuration, the thread structure stays private.
+ */
+struct nc_thread_storage
+{
+    union nc_thread_word        words[NC_THREAD_STORAGE_WORDS];
+};
+
+/**@brief       Thread storage type
+ */
+typedef struct nc_thread_storage nc_thread_storage;
+
+/**@brief       Thread definition record
+ * @details     Created by NC_THREAD_DEFINE() macro. Members of this structure
+ *              are private.
+ */
+struct nc_thread_define
+{
+    nc_thread *                 thread;
+    nc_thread_fn *              fn;
+    void *                      stack;
+    uint8_t                     priority;
+    bool                        autostart;
+};
+
+#if (CONFIG_NC_PROFILE == 1) || defined(__DOXYGEN__)
+/**@brief       Thread execution statistics
+ * @details     All times are in port cycle counter units, see nc_cpu_cycles().
+ */
+struct nc_thread_stats
+{
+    nc_thread_fn *              fn;         /**<@brief Thread function       */
+    uint32_t                    dispatches; /**<@brief Number of executions  */
+    uint64_t                    exec_total; /**<@brief Total execution time  */
+    uint64_t                    exec_min;   /**<@brief Shortest execution    */
+    uint64_t                    exec_max;   /**<@brief Longest execution     */
+    uint64_t                    latency_total; /**<@brief Total ready wait   */
+    uint64_t                    latency_max;   /**<@brief Longest ready wait */
+};
+
+/**@brief       Thread execution statistics type
+ */
+typedef struct nc_thread_stats nc_thread_stats;
+#endif
+
 /*=====================================================  GLOBAL VARIABLES  ==*/
 /*==================================================  FUNCTION PROTOTYPES  ==*/
 
 
+#if (CONFIG_NC_NUM_OF_SCHEDULERS > 1) || defined(__DOXYGEN__)
+/**@brief       Allocate a scheduler instance
+ * @return      Opaque pointer to scheduler instance.
+ * @retval      NULL - all `CONFIG_NC_NUM_OF_SCHEDULERS - 1` additional
+ *              instances are in use
+ * @details     Instances do not share any scheduler state, so each one may be
+ *              executed by its own OS thread or core without contention.
+ *              Timers, deferred calls and the trace recorder are still common
+ *              to all instances.
+ * @note        Available only when `CONFIG_NC_NUM_OF_SCHEDULERS` is greater
+ *              than 1.
+ */
+nc_sched *      nc_sched_create(void);
+
+
+
+/**@brief       Return a scheduler instance
+ * @param       sched
+ *              Instance allocated by nc_sched_create().
+ * @details     All threads of the instance must be destroyed before and the
+ *              instance must not be executed by nc_sched_schedule().
+ */
+void            nc_sched_destroy(
+    nc_sched *                  sched);
+#endif
+
+
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0) || defined(__DOXYGEN__)
+/**@brief       Set the allocator of thread descriptors
+ * @param       sched
+ *              Scheduler instance.
+ * @param       allocator
+ *              Allocator, NULL for the built-in slab of the instance.
+ * @details     Must be called before the first thread is created in the
+ *              instance. By default each instance allocates its threads from
+ *              its own slab, see @ref slab, which takes memory from the port
+ *              page allocator and never uses the general purpose heap when
+ *              the port has one. The allocator object must stay valid while
+ *              the instance has any threads.
+ * @note        Available only when `CONFIG_NC_NUM_OF_THREADS` is 0.
+ */
+void            nc_sched_set_allocator(
+    nc_sched *                  sched,
+    const nc_allocator *        allocator);
+#endif
+
+
+
+/**@brief       Get the default scheduler instance
+ * @details     This is the instance used by nc_thread_create() and
+ *              nc_schedule().
+ */
+nc_sched *      nc_sched_get_default(void);
+
+
+
+/**@brief       Create a new thread in a scheduler instance
+ * @param       sched
+ *              Scheduler instance which will execute the thread.
+ * @param       fn
+ *              Pointer to thread function
+ * @param       stack
+ *              Thread stack pointer
+ * @param       priority
+ *              Thread priority, see nc_thread_create().
+ * @return      Opaque pointer to thread structure.
+ * @retval      NULL - no memory for thread allocation
+ * @details     The thread stays in this instance for its lifetime. All other
+ *              thread functions find the instance through the thread.
+ */
+nc_thread *     nc_sched_thread_create(
+    nc_sched *                  sched,
+    nc_thread_fn *              fn,
+    void *                      stack,
+    uint_fast8_t                priority);
+
+
+
 /**@brief       Create a new thread
  * @param       fn
  *              Pointer to thread function
@@ -100,6 +357,19 @@ nc_thread *     nc_thread_create(
 
 
 
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+/**@brief       Initialize all threads defined by NC_THREAD_DEFINE()
+ * @details     This function should be called once, before the first
+ *              nc_schedule() call. Nothing is allocated, the statically
+ *              allocated threads are initialized and the ones defined with
+ *              autostart are linked into the ready lists.
+ * @note        Available only with GCC compatible compilers.
+ */
+void            nc_thread_create_defined(void);
+#endif
+
+
+
 /**@brief       Destroy a thread
  * @param       thread
  *              Thread identification opaque pointer.
@@ -119,6 +389,26 @@ void            nc_thread_ready(
 
 
 
+#if (CONFIG_NC_READY_INBOX == 1) || defined(__DOXYGEN__)
+/**@brief       Make a thread ready for execution from an ISR or other OS
+ *              thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @details     The thread is pushed into a lock-free ready inbox. Interrupts
+ *              are not disabled and no lock is taken. The scheduler moves all
+ *              threads from the inbox into ready lists at the beginning of
+ *              each nc_schedule() iteration. Calling this function several
+ *              times before the thread is moved has the same effect as calling
+ *              it once. The thread must not be destroyed while it is waiting
+ *              in the inbox.
+ * @note        Available only when `CONFIG_NC_READY_INBOX` is enabled.
+ */
+void            nc_thread_ready_async(
+    nc_thread *                 thread);
+#endif
+
+
+
 /**@brief       Make a thread blocked
  * @param       thread
  *              Thread identification opaque pointer.
@@ -128,6 +418,85 @@ void            nc_thread_block(
 
 
 
+/**@brief       Make many threads ready for execution
+ * @param       threads
+ *              Array of thread identification opaque pointers.
+ * @param       count
+ *              Number of threads in the array.
+ * @details     All threads are linked into ready lists in a single critical
+ *              section. Threads which are already ready are not affected.
+ *              When more cores are used the lock is switched only when the
+ *              next thread belongs to other core.
+ */
+void            nc_thread_ready_many(
+    nc_thread * const *         threads,
+    size_t                      count);
+
+
+
+/**@brief       Make many threads blocked
+ * @param       threads
+ *              Array of thread identification opaque pointers.
+ * @param       count
+ *              Number of threads in the array.
+ * @details     All threads are unlinked from ready lists in a single critical
+ *              section.
+ */
+void            nc_thread_block_many(
+    nc_thread * const *         threads,
+    size_t                      count);
+
+
+
+/**@brief       Add a thread into a group
+ * @param       group
+ *              Pointer to thread group.
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @return      Is the thread added?
+ * @retval      false - the group is full
+ * @details     Group members must not be changed while other group function
+ *              is using the group.
+ */
+bool            nc_thread_group_add(
+    nc_thread_group *           group,
+    nc_thread *                 thread);
+
+
+
+/**@brief       Remove a thread from a group
+ * @param       group
+ *              Pointer to thread group.
+ * @param       thread
+ *              Thread identification opaque pointer. The order of other
+ *              threads in the group may change.
+ */
+void            nc_thread_group_remove(
+    nc_thread_group *           group,
+    nc_thread *                 thread);
+
+
+
+/**@brief       Make all threads of a group ready
+ * @param       group
+ *              Pointer to thread group.
+ * @details     See nc_thread_ready_many().
+ */
+void            nc_thread_group_ready(
+    const nc_thread_group *     group);
+
+
+
+/**@brief       Make all threads of a group blocked
+ * @param       group
+ *              Pointer to thread group.
+ * @details     See nc_thread_block_many().
+ */
+void            nc_thread_group_block(
+    const nc_thread_group *     group);
+
+
+
 /**@brief       When a thread has finished its execution it needs to call this
  *              function in order to transit to IDLE state.
  */
@@ -141,6 +510,68 @@ nc_thread *     nc_thread_get_current(void);
 
 
 
+#if (CONFIG_NC_WEIGHTED_RR == 1) || defined(__DOXYGEN__)
+/**@brief       Set the round-robin weight of a thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @param       weight
+ *              Number of consecutive dispatches the thread gets before other
+ *              ready threads of the same priority get their turn. Default
+ *              weight is 1, value 0 is treated as 1.
+ * @details     Threads of the same priority share the CPU in proportion to
+ *              their weights. A thread which is blocked in the middle of its
+ *              turn starts with a full turn when it is made ready again.
+ * @note        Available only when `CONFIG_NC_WEIGHTED_RR` is enabled.
+ */
+void            nc_thread_set_weight(
+    nc_thread *                 thread,
+    uint_fast8_t                weight);
+#endif
+
+
+
+#if (CONFIG_NC_SCHED_EDF == 1) || defined(__DOXYGEN__)
+/**@brief       Set the relative deadline of a thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @param       ticks
+ *              Number of timer ticks from the moment the thread is made ready
+ *              until its job must be finished. Value 0 means no deadline,
+ *              such threads are executed only when no thread with a deadline
+ *              is ready.
+ * @details     Each time the thread is made ready its absolute deadline is
+ *              set to the current tick plus the relative deadline. Ready
+ *              threads are executed in earliest deadline first order, thread
+ *              priority is used only to order threads with equal deadlines.
+ *              The job is finished when the thread stops being ready, for
+ *              example by calling nc_thread_done().
+ * @note        Available only when `CONFIG_NC_SCHED_EDF` is enabled.
+ */
+void            nc_thread_set_deadline(
+    nc_thread *                 thread,
+    nc_tick                     ticks);
+
+
+
+/**@brief       Get the number of deadline misses of a thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @return      Number of jobs which were finished after their deadline.
+ * @note        Available only when `CONFIG_NC_SCHED_EDF` is enabled.
+ */
+uint32_t        nc_thread_get_deadline_misses(
+    const nc_thread *           thread);
+#endif
+
+
+
+/**@brief       Get the local continuation of the currently executing thread
+ * @details     This function is used by nc_pt.h macros.
+ */
+nc_lc *         nc_thread_get_lc(void);
+
+
+
 /**@brief       Get the current state of a thread
  * @param       thread
  *              Task identification opaque pointer.
@@ -154,11 +585,181 @@ nc_thread_state nc_thread_get_state(
 
 
 
+/**@brief       Get the priority of a thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ */
+uint_fast8_t    nc_thread_get_priority(
+    const nc_thread *           thread);
+
+
+
+#if (CONFIG_NC_PROFILE == 1) || defined(__DOXYGEN__)
+/**@brief       Get execution statistics of a thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @param       stats
+ *              Pointer to structure which receives the statistics.
+ * @note        Available only when `CONFIG_NC_PROFILE` is enabled.
+ */
+void            nc_thread_get_stats(
+    const nc_thread *           thread,
+    nc_thread_stats *           stats);
+
+
+
+/**@brief       Reset execution statistics of a thread
+ * @param       thread
+ *              Thread identification opaque pointer.
+ * @note        Available only when `CONFIG_NC_PROFILE` is enabled.
+ */
+void            nc_thread_reset_stats(
+    nc_thread *                 thread);
+#endif
+
+
+
+#if ((CONFIG_NC_PROFILE == 1) && (CONFIG_NC_NUM_OF_THREADS != 0)) ||          \
+    defined(__DOXYGEN__)
+/**@brief       Get execution statistics of all threads
+ * @param       stats
+ *              Array which receives the statistics of threads.
+ * @param       size
+ *              Number of elements in the array.
+ * @return      Number of threads written to the array.
+ * @details     Threads are reported in their pool order. Each thread record
+ *              is consistent, but the records are not taken at the same
+ *              moment.
+ * @note        Available only when `CONFIG_NC_PROFILE` is enabled and threads
+ *              are allocated from the static pool.
+ */
+size_t          nc_profile_snapshot(
+    nc_thread_stats *           stats,
+    size_t                      size);
+#endif
+
+
+
 /**@brief       Do the scheduling and execute the tasks.
  * @details     This function must be continiosly invoked.
  */
 void            nc_schedule(void);
 
+
+
+/**@brief       Execute ready threads within a budget
+ * @param       max_dispatches
+ *              Maximum number of thread dispatches, 0 - no limit. A batch of
+ *              deferred calls counts as one dispatch.
+ * @param       max_ns
+ *              Maximum time in nanoseconds, 0 - no limit. The time is checked
+ *              between dispatches, so the budget is exceeded by the duration
+ *              of the last dispatch. At least one dispatch is done. Ignored on
+ *              ports without monotonic time (`NCPU_TIME`).
+ * @return      Is there any ready work left?
+ * @retval      true - the budget is used up and threads are still ready, call
+ *              again after other work of the main loop is done
+ * @retval      false - no thread is ready, same as when nc_schedule() returns
+ * @details     Use this function instead of nc_schedule() to interleave the
+ *              scheduler with an external event loop and keep its latency
+ *              bounded under load.
+ */
+bool            nc_schedule_for(
+    uint32_t                    max_dispatches,
+    uint64_t                    max_ns);
+
+
+
+/**@brief       Execute one ready thread
+ * @return      Is there any ready work left?
+ * @details     Same as `nc_schedule_for(1, 0)`.
+ */
+bool            nc_schedule_one(void);
+
+
+
+/**@brief       Execute ready threads of a scheduler instance
+ * @param       sched
+ *              Scheduler instance.
+ * @details     Works as nc_schedule() for the given instance. Functions which
+ *              refer to the current thread, like nc_thread_done(), refer to
+ *              the thread of this instance while it is executed. Instances
+ *              executed at the same time by different OS threads need
+ *              `CONFIG_NC_NUM_OF_CORES` greater than 1 and a distinct
+ *              nc_core_attach() core number for each OS thread.
+ */
+void            nc_sched_schedule(
+    nc_sched *                  sched);
+
+
+
+/**@brief       Execute ready threads of a scheduler instance within a budget
+ * @param       sched
+ *              Scheduler instance.
+ * @param       max_dispatches
+ *              Maximum number of thread dispatches, 0 - no limit.
+ * @param       max_ns
+ *              Maximum time in nanoseconds, 0 - no limit.
+ * @return      Is there any ready work left?
+ * @details     Works as nc_schedule_for() for the given instance.
+ */
+bool            nc_sched_schedule_for(
+    nc_sched *                  sched,
+    uint32_t                    max_dispatches,
+    uint64_t                    max_ns);
+
+
+
+#if (CONFIG_NC_IDLE == 1) || defined(__DOXYGEN__)
+/**@brief       Sleep until there is some work for the scheduler
+ * @details     Call this function after nc_schedule() returns. The calling OS
+ *              thread sleeps until the next timer expiry or until a thread is
+ *              made ready from other OS thread. When timers are enabled they
+ *              are driven by the port monotonic clock with the period of
+ *              `CONFIG_NC_TIMER_TICK_NS` and nc_timer_tick() must not be
+ *              called by the application:
+ *
+ *                  while (true) {
+ *                      nc_schedule();
+ *                      nc_idle();
+ *                  }
+ *
+ * @note        Available only when `CONFIG_NC_IDLE` is enabled.
+ */
+void            nc_idle(void);
+
+
+
+/**@brief       Sleep until there is some work for a scheduler instance
+ * @param       sched
+ *              Scheduler instance.
+ * @details     Works as nc_idle() for the given instance.
+ * @note        Available only when `CONFIG_NC_IDLE` is enabled.
+ */
+void            nc_sched_idle(
+    nc_sched *                  sched);
+#endif
+
+
+
+#if (CONFIG_NC_NUM_OF_CORES > 1) || defined(__DOXYGEN__)
+/**@brief       Attach the calling OS thread to a scheduler core
+ * @param       core
+ *              Core number in range `0 <= core < CONFIG_NC_NUM_OF_CORES`.
+ * @details     Each core has its own ready bitmap and ready lists. Threads
+ *              are created on the core which calls nc_thread_create(). When a
+ *              core has no ready threads, nc_schedule() steals a thread from
+ *              the highest non-empty priority level of other core before it
+ *              returns. Other threads keep round-robin order on their core.
+ *              This function must be called before the first nc_schedule()
+ *              call in the OS thread. OS threads which are not attached are
+ *              using core 0.
+ * @note        Available only when `CONFIG_NC_NUM_OF_CORES` is greater than 1.
+ */
+void            nc_core_attach(
+    uint_fast8_t                core);
+#endif
+
 /*-------------------------------------------------------  C++ extern end  --*/
 #ifdef __cplusplus
 }
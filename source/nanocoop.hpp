@@ -0,0 +1,317 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       C++ front end header
+ * @defgroup    cpp C++ front end
+ * @brief       Header-only C++ layer over the scheduler
+ * @details     A thread object owns its context, which is any callable type.
+ *              The scheduler calls a per-type trampoline function which calls
+ *              the context directly, so the thread body is inlined into the
+ *              trampoline and there is no other indirection than the single
+ *              scheduler call. Thread priority is a template argument and it
+ *              is validated during the compile time:
+ *
+ *                  struct blinky
+ *                  {
+ *                      void operator()()
+ *                      {
+ *                          toggle(led);
+ *                          nc::done();
+ *                      }
+ *
+ *                      int led;
+ *                  };
+ *
+ *                  static nc::thread_table<
+ *                      nc::thread<blinky, 7>,
+ *                      nc::thread<blinky, 3>> g_threads{
+ *                          blinky{GREEN_LED}, blinky{RED_LED}};
+ *
+ *                  int main()
+ *                  {
+ *                      g_threads.create_all();
+ *                      g_threads.get<0>().ready();
+ *                      ...
+ *                  }
+ *
+ *              Requires C++14.
+ ********************************************************************//** @{ */
+
+#ifndef NANOCOOP_HPP
+#define NANOCOOP_HPP
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#include "nanocoop.h"
+
+/*==============================================================  MACRO's  ==*/
+/*===========================================================  DATA TYPES  ==*/
+
+namespace nc
+{
+
+/**@brief       Thread which owns a typed context
+ * @tparam      Callable
+ *              Context type. Its `operator()()` is the thread function.
+ * @tparam      Priority
+ *              Thread priority, `0 <= Priority < CONFIG_NC_NUM_OF_PRIO_LEVELS`.
+ * @details     Thread objects are not copyable nor movable since the scheduler
+ *              keeps a pointer to them. The thread is created by create() and
+ *              it is destroyed by destroy() or by the destructor.
+ */
+template<typename Callable, std::uint_fast8_t Priority>
+class thread
+{
+    static_assert(Priority < CONFIG_NC_NUM_OF_PRIO_LEVELS,
+        "nanocoop: thread priority is out of CONFIG_NC_NUM_OF_PRIO_LEVELS range");
+
+public:
+    /**@brief   Context type
+     */
+    using callable_type = Callable;
+
+    /**@brief   Thread priority
+     */
+    static constexpr std::uint_fast8_t priority = Priority;
+
+    /**@brief   Construct the context, the thread is not created yet
+     */
+    template<typename... Args>
+    constexpr explicit thread(Args &&... args)
+        : context_(std::forward<Args>(args)...), handle_(nullptr)
+    {
+    }
+
+    thread(const thread &) = delete;
+    thread & operator=(const thread &) = delete;
+
+    ~thread()
+    {
+        destroy();
+    }
+
+    /**@brief   Create the thread
+     * @return  Is the thread created?
+     */
+    bool create()
+    {
+        handle_ = nc_thread_create(&entry, this, Priority);
+
+        return (handle_ != nullptr);
+    }
+
+    /**@brief   Destroy the thread if it is created
+     */
+    void destroy()
+    {
+        if (handle_ != nullptr) {
+            nc_thread_destroy(handle_);
+            handle_ = nullptr;
+        }
+    }
+
+    /**@brief   Make the thread ready, see nc_thread_ready()
+     */
+    void ready()
+    {
+        nc_thread_ready(handle_);
+    }
+
+    /**@brief   Block the thread, see nc_thread_block()
+     */
+    void block()
+    {
+        nc_thread_block(handle_);
+    }
+
+    /**@brief   Get the thread state, see nc_thread_get_state()
+     */
+    nc_thread_state state() const
+    {
+        return (nc_thread_get_state(handle_));
+    }
+
+    /**@brief   Get the thread context
+     */
+    Callable & context()
+    {
+        return (context_);
+    }
+
+    /**@brief   Get the underlying C thread, NULL if it is not created
+     */
+    nc_thread * handle() const
+    {
+        return (handle_);
+    }
+
+private:
+    /* The scheduler calls this function. Since the context type is known here
+     * the call to operator() is direct and it is usually inlined.
+     */
+    static void entry(void * self)
+    {
+        static_cast<thread *>(self)->context_();
+    }
+
+    Callable                    context_;
+    nc_thread *                 handle_;
+};
+
+/**@brief       Compile-time table of threads
+ * @tparam      Threads
+ *              Thread types, instances of nc::thread.
+ * @details     The table owns the thread objects. It can be constant
+ *              initialized, so a static table costs nothing at start-up until
+ *              create_all() is called. The number of threads is validated
+ *              against the thread pool size during the compile time.
+ */
+template<typename... Threads>
+class thread_table
+{
+    static_assert((CONFIG_NC_NUM_OF_THREADS == 0) ||
+        (sizeof...(Threads) <= CONFIG_NC_NUM_OF_THREADS),
+        "nanocoop: thread table is larger than CONFIG_NC_NUM_OF_THREADS");
+
+public:
+    /**@brief   Number of threads in the table
+     */
+    static constexpr std::size_t size = sizeof...(Threads);
+
+    /**@brief   Construct all thread contexts
+     */
+    constexpr explicit thread_table(typename Threads::callable_type... contexts)
+        : threads_(std::move(contexts)...)
+    {
+    }
+
+    /**@brief   Get a thread by its index
+     */
+    template<std::size_t Index>
+    typename std::tuple_element<Index, std::tuple<Threads...>>::type & get()
+    {
+        return (std::get<Index>(threads_));
+    }
+
+    /**@brief   Create all threads
+     * @return  Are all threads created?
+     */
+    bool create_all()
+    {
+        return (create_all(std::index_sequence_for<Threads...>()));
+    }
+
+    /**@brief   Make all threads ready
+     */
+    void ready_all()
+    {
+        ready_all(std::index_sequence_for<Threads...>());
+    }
+
+    /**@brief   Get the priority of a thread by its index
+     */
+    static constexpr std::uint_fast8_t priority_of(std::size_t index)
+    {
+        constexpr std::uint_fast8_t priorities[] = {Threads::priority..., 0u};
+
+        return (priorities[index]);
+    }
+
+private:
+    template<std::size_t... Index>
+    bool create_all(std::index_sequence<Index...>)
+    {
+        bool                    is_created = true;
+        int                     unused[] =
+        {
+            0, ((is_created = std::get<Index>(threads_).create() &&
+                is_created), 0)...
+        };
+
+        (void)unused;
+
+        return (is_created);
+    }
+
+    template<std::size_t... Index>
+    void ready_all(std::index_sequence<Index...>)
+    {
+        int                     unused[] =
+        {
+            0, (std::get<Index>(threads_).ready(), 0)...
+        };
+
+        (void)unused;
+    }
+
+    std::tuple<Threads...>      threads_;
+};
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+/**@brief       Finish the current thread execution, see nc_thread_done()
+ */
+inline void done()
+{
+    nc_thread_done();
+}
+
+/**@brief       Execute ready threads, see nc_schedule()
+ */
+inline void schedule()
+{
+    nc_schedule();
+}
+
+/**@brief       Execute ready threads within a budget, see nc_schedule_for()
+ */
+inline bool schedule_for(std::uint32_t max_dispatches, std::uint64_t max_ns)
+{
+    return (nc_schedule_for(max_dispatches, max_ns));
+}
+
+/**@brief       Execute one ready thread, see nc_schedule_one()
+ */
+inline bool schedule_one()
+{
+    return (nc_schedule_one());
+}
+
+} /* namespace nc */
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (__cplusplus < 201402L)
+# error "nanocoop: nanocoop.hpp requires C++14 or newer."
+#endif
+
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nanocoop.hpp
+ *****************************************************************************/
+#endif /* NANOCOOP_HPP */
@@ -0,0 +1,191 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Priority bitmap header
+ * @defgroup    bitmap Priority bitmap
+ * @brief       One bit per priority level
+ * @details     Used by the scheduler ready lists and by modules which keep
+ *              priority ordered wait lists. When there are more priority
+ *              levels than bits in a CPU register a second level group word
+ *              is used, so the highest set bit is always found with two
+ *              bit-scans at most. This header is private to nanocoop modules.
+ ********************************************************************//** @{ */
+
+#ifndef NC_BITMAP_H
+#define NC_BITMAP_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nc_config.h"
+#include "nc_port.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Number of bits needed to index a bit in a CPU register
+ */
+#define NC_BITMAP_INDEX_BITS                                                \
+    (NCPU_DATA_WIDTH <=  8 ? 3u :                                           \
+     (NCPU_DATA_WIDTH <= 16 ? 4u :                                          \
+      (NCPU_DATA_WIDTH <= 32 ? 5u : 6u)))
+
+/**@brief       Number of level words in a bitmap
+ */
+#define NC_BITMAP_GROUPS                                                    \
+    ((CONFIG_NC_NUM_OF_PRIO_LEVELS + NCPU_DATA_WIDTH - 1u) / NCPU_DATA_WIDTH)
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Priority bitmap structure
+ * @details     A zero initialized bitmap is empty.
+ */
+struct nc_bitmap
+{
+#if     (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
+    nc_cpu_reg                  group;
+#endif
+    nc_cpu_reg                  level[NC_BITMAP_GROUPS];
+};
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Set a bit corresponding to the the given priority
+ */
+static inline
+void nc_bitmap_set(
+    struct nc_bitmap *          bitmap,
+    uint_fast8_t                priority)
+{
+#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
+    uint_fast8_t                group;
+    uint_fast8_t                index;
+
+    index = priority &
+        ((uint_fast8_t)~0u >> (sizeof(priority) * 8u - NC_BITMAP_INDEX_BITS));
+    group = priority >> NC_BITMAP_INDEX_BITS;
+    bitmap->group        |= nc_exp2(group);
+    bitmap->level[group] |= nc_exp2(index);
+#else
+    bitmap->level[0]     |= nc_exp2(priority);
+#endif
+}
+
+
+
+/**@brief       Clear a bit corresponding to the the given priority
+ */
+static inline
+void nc_bitmap_clear(
+    struct nc_bitmap *          bitmap,
+    uint_fast8_t                priority)
+{
+#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
+    uint_fast8_t                group;
+    uint_fast8_t                index;
+
+    index = priority &
+        ((uint_fast8_t)~0u >> (sizeof(priority) * 8u - NC_BITMAP_INDEX_BITS));
+    group = priority >> NC_BITMAP_INDEX_BITS;
+    bitmap->level[group] &= (nc_cpu_reg)~nc_exp2(index);
+
+    if (bitmap->level[group] == 0u) {  /* If this is the last bit cleared in */
+                                       /* this level group then clear group  */
+                                       /* bit indicator, too.                */
+        bitmap->group &= (nc_cpu_reg)~nc_exp2(group);
+    }
+#else
+    bitmap->level[0]  &= (nc_cpu_reg)~nc_exp2(priority);
+#endif
+}
+
+
+
+/**@brief       Get the highest set bit priority level
+ * @details     The bitmap must not be empty.
+ */
+static inline
+uint_fast8_t nc_bitmap_get_highest(
+    const struct nc_bitmap *    bitmap)
+{
+#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
+    uint_fast8_t                group;
+    uint_fast8_t                index;
+
+    group = nc_log2(bitmap->group);
+    index = nc_log2(bitmap->level[group]);
+
+    return ((uint_fast8_t)((group << NC_BITMAP_INDEX_BITS) | index));
+#else
+    uint_fast8_t                index;
+
+    index = nc_log2(bitmap->level[0]);
+
+    return (index);
+#endif
+}
+
+
+
+/**@brief       Is the bitmap empty?
+ * @return
+ * @retval      true  - no bit is set
+ * @retval      false - at least one bit is set
+ */
+static inline
+bool nc_bitmap_is_empty(
+    const struct nc_bitmap *    bitmap)
+{
+#if   (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
+    if (bitmap->group == 0u) {
+        return (true);
+    } else {
+        return (false);
+    }
+#else
+    if (bitmap->level[0] == 0u) {
+        return (true);
+    } else {
+        return (false);
+    }
+#endif
+}
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_bitmap.h
+ *****************************************************************************/
+#endif /* NC_BITMAP_H */
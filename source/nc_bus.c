@@ -0,0 +1,387 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Event bus Implementation
+ * @addtogroup  bus
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "nc_bus.h"
+#include "nc_config.h"
+
+/*========================================================  LOCAL MACRO's  ==*/
+/*=====================================================  LOCAL DATA TYPES  ==*/
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Lock event buses
+ */
+static inline
+void bus_lock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock event buses
+ */
+static inline
+void bus_unlock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Get the bitmap word of a subscriber slot in a topic
+ */
+static inline
+nc_cpu_reg * bus_word(
+    const nc_bus *              bus,
+    uint_fast16_t               topic,
+    uint_fast16_t               slot);
+
+
+
+/**@brief       Queue an event to a subscriber
+ * @return      Is the event queued?
+ */
+static inline
+bool subscriber_push(
+    nc_bus_subscriber *         subscriber,
+    nc_event *                  event);
+
+
+
+/**@brief       Dequeue an event from a subscriber
+ * @return      Pointer to event or NULL when the queue is empty
+ */
+static inline
+nc_event * subscriber_pop(
+    nc_bus_subscriber *         subscriber);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+/**@brief       Lock protecting all event buses when more cores are used
+ */
+static nc_spinlock        g_bus_lock;
+#endif
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+void bus_lock(
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_bus_lock);
+#endif
+}
+
+
+
+static inline
+void bus_unlock(
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_bus_lock);
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+
+
+static inline
+nc_cpu_reg * bus_word(
+    const nc_bus *              bus,
+    uint_fast16_t               topic,
+    uint_fast16_t               slot)
+{
+    return (&bus->map[topic * NC_BUS_WORDS(bus->size) +
+        slot / NCPU_DATA_WIDTH]);
+}
+
+
+
+static inline
+bool subscriber_push(
+    nc_bus_subscriber *         subscriber,
+    nc_event *                  event)
+{
+    if ((subscriber->tail - subscriber->head) > subscriber->mask) {
+        subscriber->overruns++;
+
+        return (false);
+    }
+    subscriber->queue[subscriber->tail & subscriber->mask] = event;
+    subscriber->tail++;
+
+    return (true);
+}
+
+
+
+static inline
+nc_event * subscriber_pop(
+    nc_bus_subscriber *         subscriber)
+{
+    nc_event *                  event;
+
+    if (subscriber->head == subscriber->tail) {
+        return (NULL);
+    }
+    event = subscriber->queue[subscriber->head & subscriber->mask];
+    subscriber->head++;
+
+    return (event);
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_event_init(
+    nc_event *                  event,
+    nc_event_free_fn *          free)
+{
+    event->free  = free;
+    event->refs  = 0u;
+    event->topic = 0u;
+}
+
+
+
+uint_fast16_t nc_event_get_topic(
+    const nc_event *            event)
+{
+    return (event->topic);
+}
+
+
+
+bool nc_bus_attach(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber,
+    nc_thread *                 thread)
+{
+    nc_isr_lock                 isr_context;
+    bool                        is_attached;
+
+    is_attached = false;
+    bus_lock(&isr_context);
+
+    for (uint_fast16_t slot = 0u; slot < bus->size; slot++) {
+
+        if (bus->slots[slot] == NULL) {
+            bus->slots[slot]   = subscriber;
+            subscriber->slot   = (uint16_t)slot;
+            subscriber->thread = thread;
+            is_attached        = true;
+            break;
+        }
+    }
+    bus_unlock(&isr_context);
+
+    return (is_attached);
+}
+
+
+
+void nc_bus_detach(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber)
+{
+    nc_isr_lock                 isr_context;
+    nc_cpu_reg                  bit;
+
+    bit = nc_exp2((uint_fast8_t)(subscriber->slot % NCPU_DATA_WIDTH));
+    bus_lock(&isr_context);
+
+    if ((subscriber->slot >= bus->size) ||     /* Not attached to this bus */
+        (bus->slots[subscriber->slot] != subscriber)) {
+        bus_unlock(&isr_context);
+
+        return;
+    }
+
+    for (uint_fast16_t topic = 0u; topic < bus->topics; topic++) {
+        *bus_word(bus, topic, subscriber->slot) &= (nc_cpu_reg)~bit;
+    }
+    bus->slots[subscriber->slot] = NULL;
+    subscriber->thread           = NULL;
+    bus_unlock(&isr_context);
+
+    for (;;) {                            /* Release events nobody will read */
+        nc_event *              event;
+
+        bus_lock(&isr_context);
+        event = subscriber_pop(subscriber);
+        bus_unlock(&isr_context);
+
+        if (event == NULL) {
+            break;
+        }
+        nc_event_release(event);
+    }
+}
+
+
+
+void nc_bus_subscribe(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber,
+    uint_fast16_t               topic)
+{
+    nc_isr_lock                 isr_context;
+    nc_cpu_reg                  bit;
+
+    bit = nc_exp2((uint_fast8_t)(subscriber->slot % NCPU_DATA_WIDTH));
+    bus_lock(&isr_context);
+    *bus_word(bus, topic, subscriber->slot) |= bit;
+    bus_unlock(&isr_context);
+}
+
+
+
+void nc_bus_unsubscribe(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber,
+    uint_fast16_t               topic)
+{
+    nc_isr_lock                 isr_context;
+    nc_cpu_reg                  bit;
+
+    bit = nc_exp2((uint_fast8_t)(subscriber->slot % NCPU_DATA_WIDTH));
+    bus_lock(&isr_context);
+    *bus_word(bus, topic, subscriber->slot) &= (nc_cpu_reg)~bit;
+    bus_unlock(&isr_context);
+}
+
+
+
+size_t nc_bus_publish(
+    nc_bus *                    bus,
+    uint_fast16_t               topic,
+    nc_event *                  event)
+{
+    nc_isr_lock                 isr_context;
+    const nc_cpu_reg *          map;
+    size_t                      words;
+    size_t                      received;
+
+    words        = NC_BUS_WORDS(bus->size);
+    map          = &bus->map[topic * words];
+    received     = 0u;
+    event->topic = (uint16_t)topic;
+    bus_lock(&isr_context);
+
+    for (size_t word = 0u; word < words; word++) {
+        nc_thread *             threads[NCPU_DATA_WIDTH];
+        nc_cpu_reg              bits;
+        size_t                  count;
+
+        bits  = map[word];
+        count = 0u;
+
+        while (bits != 0u) {
+            nc_bus_subscriber * subscriber;
+            uint_fast8_t        index;
+
+            index      = nc_log2(bits);
+            bits      &= (nc_cpu_reg)~nc_exp2(index);
+            subscriber = bus->slots[word * NCPU_DATA_WIDTH + index];
+
+            if (subscriber_push(subscriber, event)) {
+                threads[count++] = subscriber->thread;
+            }
+        }
+        event->refs += (uint32_t)count;  /* Releases wait for the lock */
+        received    += count;
+
+        if (count != 0u) {          /* One ready call for the whole word */
+            nc_thread_ready_many(threads, count);
+        }
+    }
+    bus_unlock(&isr_context);
+
+    if ((received == 0u) && (event->free != NULL)) {
+        event->free(event);
+    }
+
+    return (received);
+}
+
+
+
+nc_event * nc_bus_receive(
+    nc_bus_subscriber *         subscriber)
+{
+    nc_isr_lock                 isr_context;
+    nc_event *                  event;
+
+    bus_lock(&isr_context);
+    event = subscriber_pop(subscriber);
+
+    if (event == NULL) {              /* Also when the subscriber is detached */
+        nc_thread_block(nc_thread_get_current());
+    }
+    bus_unlock(&isr_context);
+
+    return (event);
+}
+
+
+
+void nc_event_release(
+    nc_event *                  event)
+{
+    nc_isr_lock                 isr_context;
+    bool                        is_last;
+
+    bus_lock(&isr_context);
+    is_last = (--event->refs == 0u);
+    bus_unlock(&isr_context);
+
+    if (is_last && (event->free != NULL)) {
+        event->free(event);
+    }
+}
+
+
+
+uint32_t nc_bus_get_overruns(
+    const nc_bus_subscriber *   subscriber)
+{
+    return (subscriber->overruns);
+}
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_bus.c
+ ******************************************************************************/
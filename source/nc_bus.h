@@ -0,0 +1,299 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Event bus header
+ * @defgroup    bus Event bus
+ * @brief       Topic based publish/subscribe with shared events
+ * @details     A bus, its topics and its subscriber slots are allocated during
+ *              the compile time by NC_BUS_DEFINE() macro. Each topic has a
+ *              bitmap of subscriber slots. A published event is not copied:
+ *              a pointer to it is put into the queue of each subscriber and
+ *              the event is reference counted. All subscriber threads are made
+ *              ready with one nc_thread_ready_many() call per bitmap word.
+ *              When the last subscriber releases the event its free function
+ *              is called.
+ ********************************************************************//** @{ */
+
+#ifndef NC_BUS_H
+#define NC_BUS_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocoop.h"
+#include "nc_port.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Number of bitmap words needed for the given number of
+ *              subscribers
+ */
+#define NC_BUS_WORDS(subscribers)                                           \
+    (((subscribers) + NCPU_DATA_WIDTH - 1u) / NCPU_DATA_WIDTH)
+
+/**@brief       Define a statically allocated event bus
+ * @param       name
+ *              Name of bus variable of type nc_bus.
+ * @param       topics
+ *              Number of topics.
+ * @param       subscribers
+ *              Maximum number of attached subscribers.
+ * @details     The bus and its storage are local to the translation unit. Pass
+ *              a pointer to the bus to share it.
+ */
+#define NC_BUS_DEFINE(name, topics, subscribers)                            \
+    static nc_cpu_reg name ## _map[(topics) * NC_BUS_WORDS(subscribers)];   \
+    static struct nc_bus_subscriber * name ## _slots[(subscribers)];        \
+    static nc_bus name =                                                    \
+    {                                                                       \
+        name ## _map,                                                       \
+        name ## _slots,                                                     \
+        (topics),                                                           \
+        (subscribers)                                                       \
+    }
+
+/**@brief       Define a statically allocated subscriber
+ * @param       name
+ *              Name of subscriber variable of type nc_bus_subscriber.
+ * @param       capacity
+ *              Maximum number of pending events, must be a power of 2.
+ * @details     The subscriber is local to the translation unit, like the bus.
+ */
+#define NC_BUS_SUBSCRIBER_DEFINE(name, capacity)                            \
+    static struct nc_event * name ## _queue[(capacity) &&                   \
+        (((capacity) & ((capacity) - 1u)) == 0u) ? (long)(capacity) : -1];  \
+    static nc_bus_subscriber name =                                         \
+    {                                                                       \
+        name ## _queue,                                                     \
+        (capacity) - 1u,                                                    \
+        0u,                                                                 \
+        0u,                                                                 \
+        0u,                                                                 \
+        0u,                                                                 \
+        NULL                                                                \
+    }
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+struct nc_event;
+
+/**@brief       Function which frees an event after its last release
+ */
+typedef void (nc_event_free_fn)(struct nc_event *);
+
+/**@brief       Event header
+ * @details     Place this structure as the first member of application event
+ *              structure and initialize it by nc_event_init(). Members of this
+ *              structure are private.
+ */
+struct nc_event
+{
+    nc_event_free_fn *          free;
+    uint32_t                    refs;       /**<@brief Pending subscribers   */
+    uint16_t                    topic;
+};
+
+/**@brief       Event type
+ */
+typedef struct nc_event nc_event;
+
+/**@brief       Subscriber structure
+ * @details     Members of this structure are private, use
+ *              NC_BUS_SUBSCRIBER_DEFINE() to allocate a subscriber.
+ */
+struct nc_bus_subscriber
+{
+    struct nc_event **          queue;
+    size_t                      mask;       /**<@brief Capacity - 1          */
+    size_t                      head;       /**<@brief Received events count */
+    size_t                      tail;       /**<@brief Queued events count   */
+    uint32_t                    overruns;   /**<@brief Dropped events count  */
+    uint16_t                    slot;
+    nc_thread *                 thread;     /**<@brief NULL when detached    */
+};
+
+/**@brief       Subscriber type
+ */
+typedef struct nc_bus_subscriber nc_bus_subscriber;
+
+/**@brief       Event bus structure
+ * @details     Members of this structure are private, use NC_BUS_DEFINE() to
+ *              allocate a bus.
+ */
+struct nc_bus
+{
+    nc_cpu_reg *                map;        /**<@brief Subscribers by topic  */
+    struct nc_bus_subscriber ** slots;
+    uint16_t                    topics;
+    uint16_t                    size;       /**<@brief Number of slots       */
+};
+
+/**@brief       Event bus type
+ */
+typedef struct nc_bus nc_bus;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Initialize an event
+ * @param       event
+ *              Pointer to event header.
+ * @param       free
+ *              Function which is called after the last subscriber released
+ *              the event, or NULL for events which are not freed, for example
+ *              constant events.
+ */
+void            nc_event_init(
+    nc_event *                  event,
+    nc_event_free_fn *          free);
+
+
+
+/**@brief       Get the topic an event was published to
+ */
+uint_fast16_t   nc_event_get_topic(
+    const nc_event *            event);
+
+
+
+/**@brief       Attach a subscriber to a bus
+ * @param       bus
+ *              Pointer to bus.
+ * @param       subscriber
+ *              Pointer to subscriber.
+ * @param       thread
+ *              Thread which is made ready when events are published to topics
+ *              it subscribed to.
+ * @return      Is the subscriber attached?
+ * @retval      false - all subscriber slots are used
+ */
+bool            nc_bus_attach(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber,
+    nc_thread *                 thread);
+
+
+
+/**@brief       Detach a subscriber from a bus
+ * @details     The subscriber is removed from all topics and its pending events
+ *              are released. If the subscriber is not attached to this bus
+ *              this function has no effect.
+ */
+void            nc_bus_detach(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber);
+
+
+
+/**@brief       Subscribe to a topic
+ * @param       bus
+ *              Pointer to bus.
+ * @param       subscriber
+ *              Pointer to attached subscriber.
+ * @param       topic
+ *              Topic, `0 <= topic < topics`.
+ */
+void            nc_bus_subscribe(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber,
+    uint_fast16_t               topic);
+
+
+
+/**@brief       Unsubscribe from a topic
+ */
+void            nc_bus_unsubscribe(
+    nc_bus *                    bus,
+    nc_bus_subscriber *         subscriber,
+    uint_fast16_t               topic);
+
+
+
+/**@brief       Publish an event
+ * @param       bus
+ *              Pointer to bus.
+ * @param       topic
+ *              Topic, `0 <= topic < topics`.
+ * @param       event
+ *              Pointer to initialized event which is not published yet.
+ * @return      Number of subscribers which received the event.
+ * @details     The event is queued to each subscriber of the topic and the
+ *              subscriber threads are made ready. A subscriber whose queue is
+ *              full does not receive the event and its overrun counter is
+ *              incremented. When no subscriber receives the event it is freed
+ *              before this function returns. May be called from ISRs.
+ */
+size_t          nc_bus_publish(
+    nc_bus *                    bus,
+    uint_fast16_t               topic,
+    nc_event *                  event);
+
+
+
+/**@brief       Receive the next event
+ * @param       subscriber
+ *              Pointer to subscriber.
+ * @return      Pointer to event which must be released by nc_event_release()
+ *              after it is processed.
+ * @retval      NULL - there are no pending events. In this case the calling
+ *              subscriber thread is blocked and it should return. It is made
+ *              ready again on the next publish.
+ * @details     This function must be called only from subscriber thread.
+ */
+nc_event *      nc_bus_receive(
+    nc_bus_subscriber *         subscriber);
+
+
+
+/**@brief       Release a received event
+ * @details     The event free function is called by the last release.
+ */
+void            nc_event_release(
+    nc_event *                  event);
+
+
+
+/**@brief       Get the number of events which were dropped since subscriber
+ *              queue was full
+ */
+uint32_t        nc_bus_get_overruns(
+    const nc_bus_subscriber *   subscriber);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_bus.h
+ *****************************************************************************/
+#endif /* NC_BUS_H */
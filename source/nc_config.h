@@ -30,9 +30,101 @@
 /*=========================================================  INCLUDE FILES  ==*/
 /*===============================================================  MACRO's  ==*/
 
+#if !defined(CONFIG_NC_NUM_OF_THREADS)
 #define CONFIG_NC_NUM_OF_THREADS            10
+#endif
 
+#if !defined(CONFIG_NC_NUM_OF_PRIO_LEVELS)
 #define CONFIG_NC_NUM_OF_PRIO_LEVELS        32
+#endif
+
+#if !defined(CONFIG_NC_NUM_OF_CORES)
+#define CONFIG_NC_NUM_OF_CORES              1
+#endif
+
+#if !defined(CONFIG_NC_NUM_OF_SCHEDULERS)
+#define CONFIG_NC_NUM_OF_SCHEDULERS         1
+#endif
+
+#if !defined(CONFIG_NC_THREAD_SPLIT)
+#define CONFIG_NC_THREAD_SPLIT              0
+#endif
+
+#if !defined(CONFIG_NC_CACHE_LINE_SIZE)
+#define CONFIG_NC_CACHE_LINE_SIZE           64
+#endif
+
+#if !defined(CONFIG_NC_SLAB_CHUNK_SIZE)
+#define CONFIG_NC_SLAB_CHUNK_SIZE           4096
+#endif
+
+#if !defined(CONFIG_NC_READY_INBOX)
+#define CONFIG_NC_READY_INBOX               0
+#endif
+
+#if !defined(CONFIG_NC_TIMER)
+#define CONFIG_NC_TIMER                     0
+#endif
+
+#if !defined(CONFIG_NC_TIMER_WHEEL_BITS)
+#define CONFIG_NC_TIMER_WHEEL_BITS          4
+#endif
+
+#if !defined(CONFIG_NC_TIMER_WHEEL_LEVELS)
+#define CONFIG_NC_TIMER_WHEEL_LEVELS        4
+#endif
+
+#if !defined(CONFIG_NC_TIMER_TICK_NS)
+#define CONFIG_NC_TIMER_TICK_NS             1000000
+#endif
+
+#if !defined(CONFIG_NC_IDLE)
+#define CONFIG_NC_IDLE                      0
+#endif
+
+#if !defined(CONFIG_NC_SCHED_EDF)
+#define CONFIG_NC_SCHED_EDF                 0
+#endif
+
+#if !defined(CONFIG_NC_WEIGHTED_RR)
+#define CONFIG_NC_WEIGHTED_RR               0
+#endif
+
+#if !defined(CONFIG_NC_DEFER)
+#define CONFIG_NC_DEFER                     0
+#endif
+
+#if !defined(CONFIG_NC_DEFER_SIZE)
+#define CONFIG_NC_DEFER_SIZE                16
+#endif
+
+#if !defined(CONFIG_NC_DEFER_PRIO)
+#define CONFIG_NC_DEFER_PRIO                (CONFIG_NC_NUM_OF_PRIO_LEVELS - 1)
+#endif
+
+#if !defined(CONFIG_NC_DEFER_BATCH)
+#define CONFIG_NC_DEFER_BATCH               8
+#endif
+
+#if !defined(CONFIG_NC_IO)
+#define CONFIG_NC_IO                        0
+#endif
+
+#if !defined(CONFIG_NC_IO_BATCH)
+#define CONFIG_NC_IO_BATCH                  32
+#endif
+
+#if !defined(CONFIG_NC_PROFILE)
+#define CONFIG_NC_PROFILE                   0
+#endif
+
+#if !defined(CONFIG_NC_TRACE)
+#define CONFIG_NC_TRACE                     0
+#endif
+
+#if !defined(CONFIG_NC_TRACE_SIZE)
+#define CONFIG_NC_TRACE_SIZE                1024
+#endif
 
 /*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
 /** @endcond *//** @} *//******************************************************
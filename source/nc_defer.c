@@ -0,0 +1,283 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Deferred call queue Implementation
+ * @addtogroup  defer
+ * @details     The queue is a bounded ring where each slot carries a sequence
+ *              number. Sequences are kept relative to the round of the ring,
+ *              `round = position - position % size`: a slot is free for
+ *              position `n` when its sequence is `round(n)` and it holds a
+ *              call when its sequence is `round(n) + 1`. A zero initialized
+ *              queue is therefore empty and needs no initialization. A
+ *              producer claims a free slot by advancing `head`, writes the
+ *              call and publishes it by storing the sequence, so a consumer
+ *              never sees a half written slot and producers never wait for
+ *              each other.
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+
+#include "nc_defer.h"
+#include "nc_config.h"
+#include "nc_port.h"
+
+#if (CONFIG_NC_DEFER == 1)
+/*========================================================  LOCAL MACRO's  ==*/
+
+#define DEFER_MASK                      ((uint32_t)CONFIG_NC_DEFER_SIZE - 1u)
+
+#define DEFER_ROUND(position)           ((uint32_t)(position) & ~DEFER_MASK)
+
+/*=====================================================  LOCAL DATA TYPES  ==*/
+
+/**@brief       Deferred call slot
+ */
+struct defer_slot
+{
+    volatile uint32_t           sequence;   /**<@brief Slot state            */
+    nc_defer_fn *               fn;
+    void *                      arg;
+};
+
+/**@brief       Deferred call queue
+ */
+struct defer_queue
+{
+    volatile uint32_t           head;       /**<@brief Next position to post */
+    volatile uint32_t           tail;       /**<@brief Next position to run  */
+    volatile uint32_t           overruns;
+    struct defer_slot           slots[CONFIG_NC_DEFER_SIZE];
+};
+
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Put a call into the queue
+ */
+static inline
+bool defer_push(
+    nc_defer_fn *               fn,
+    void *                      arg);
+
+
+
+/**@brief       Take a call from the queue
+ */
+static inline
+bool defer_pop(
+    nc_defer_fn **              fn,
+    void **                     arg);
+
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+/**@brief       Deferred call queue
+ */
+static struct defer_queue       g_defer;
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+bool defer_push(
+    nc_defer_fn *               fn,
+    void *                      arg)
+{
+    struct defer_slot *         slot;
+#if defined(NCPU_ATOMIC)
+    uint32_t                    position;
+
+    position = nc_atomic_u32_load(&g_defer.head);
+
+    for (;;) {
+        int32_t                 diff;
+
+        slot = &g_defer.slots[position & DEFER_MASK];
+        diff = (int32_t)(nc_atomic_u32_load(&slot->sequence) -
+            DEFER_ROUND(position));
+
+        if (diff == 0) {                                 /* Slot is free */
+            if (nc_atomic_u32_cas(&g_defer.head, position, position + 1u)) {
+                break;
+            }
+        } else if (diff < 0) {         /* Slot still holds a call, full queue */
+            nc_atomic_u32_fetch_add(&g_defer.overruns, 1u);
+
+            return (false);
+        }
+        position = nc_atomic_u32_load(&g_defer.head); /* Someone was faster */
+    }
+    slot->fn  = fn;
+    slot->arg = arg;
+    nc_atomic_u32_store(&slot->sequence, DEFER_ROUND(position) + 1u);
+
+    return (true);
+#else
+    nc_isr_lock                 isr_context;
+    bool                        is_posted;
+
+    nc_isr_lock_save(&isr_context);
+    slot = &g_defer.slots[g_defer.head & DEFER_MASK];
+
+    if (slot->sequence == DEFER_ROUND(g_defer.head)) {
+        slot->fn       = fn;
+        slot->arg      = arg;
+        slot->sequence = DEFER_ROUND(g_defer.head) + 1u;
+        g_defer.head++;
+        is_posted      = true;
+    } else {
+        g_defer.overruns++;
+        is_posted      = false;
+    }
+    nc_isr_unlock(&isr_context);
+
+    return (is_posted);
+#endif
+}
+
+
+
+static inline
+bool defer_pop(
+    nc_defer_fn **              fn,
+    void **                     arg)
+{
+    struct defer_slot *         slot;
+#if defined(NCPU_ATOMIC)
+    uint32_t                    position;
+
+    position = nc_atomic_u32_load(&g_defer.tail);
+
+    for (;;) {
+        int32_t                 diff;
+
+        slot = &g_defer.slots[position & DEFER_MASK];
+        diff = (int32_t)(nc_atomic_u32_load(&slot->sequence) -
+            (DEFER_ROUND(position) + 1u));
+
+        if (diff == 0) {                               /* Slot holds a call */
+            if (nc_atomic_u32_cas(&g_defer.tail, position, position + 1u)) {
+                break;
+            }
+        } else if (diff < 0) {                              /* Queue is empty */
+            return (false);
+        }
+        position = nc_atomic_u32_load(&g_defer.tail);
+    }
+    *fn  = slot->fn;
+    *arg = slot->arg;
+                                         /* Free the slot for the next round */
+    nc_atomic_u32_store(&slot->sequence,
+        DEFER_ROUND(position) + CONFIG_NC_DEFER_SIZE);
+
+    return (true);
+#else
+    nc_isr_lock                 isr_context;
+    bool                        is_taken;
+
+    nc_isr_lock_save(&isr_context);
+    slot = &g_defer.slots[g_defer.tail & DEFER_MASK];
+
+    if (slot->sequence == DEFER_ROUND(g_defer.tail) + 1u) {
+        *fn            = slot->fn;
+        *arg           = slot->arg;
+        slot->sequence = DEFER_ROUND(g_defer.tail) + CONFIG_NC_DEFER_SIZE;
+        g_defer.tail++;
+        is_taken       = true;
+    } else {
+        is_taken       = false;
+    }
+    nc_isr_unlock(&isr_context);
+
+    return (is_taken);
+#endif
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+bool nc_defer_post(
+    nc_defer_fn *               fn,
+    void *                      arg)
+{
+    if (!defer_push(fn, arg)) {
+        return (false);
+    }
+#if (CONFIG_NC_IDLE == 1)
+    nc_cpu_idle_wake();
+#endif
+
+    return (true);
+}
+
+
+
+uint32_t nc_defer_get_overruns(void)
+{
+    return (g_defer.overruns);
+}
+
+
+
+bool nc_defer_is_pending(void)
+{
+    uint32_t                    position;
+                     /* Head is advanced before the slot is published, so the
+                      * slot at the tail is checked the same way as in
+                      * defer_pop(). */
+#if defined(NCPU_ATOMIC)
+    position = nc_atomic_u32_load(&g_defer.tail);
+
+    return (nc_atomic_u32_load(&g_defer.slots[position & DEFER_MASK].sequence)
+        == DEFER_ROUND(position) + 1u);
+#else
+    position = g_defer.tail;
+
+    return (g_defer.slots[position & DEFER_MASK].sequence ==
+        DEFER_ROUND(position) + 1u);
+#endif
+}
+
+
+
+void nc_defer_run(void)
+{
+    for (uint_fast16_t itr = 0u; itr < CONFIG_NC_DEFER_BATCH; itr++) {
+        nc_defer_fn *           fn;
+        void *                  arg;
+
+        if (!defer_pop(&fn, &arg)) {
+            break;
+        }
+        fn(arg);
+    }
+}
+
+#endif /* (CONFIG_NC_DEFER == 1) */
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_defer.c
+ ******************************************************************************/
@@ -0,0 +1,119 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Deferred call queue header
+ * @defgroup    defer Deferred calls
+ * @brief       Work moved out of interrupt context
+ * @details     An ISR posts a function and its argument into a statically
+ *              sized queue and returns. The call is executed later by
+ *              nc_schedule() in thread context, in batches of
+ *              `CONFIG_NC_DEFER_BATCH` calls. Pending calls are executed
+ *              before any ready thread with priority lower than or equal to
+ *              `CONFIG_NC_DEFER_PRIO`, so threads with higher priority still
+ *              preempt the deferred work between batches.
+ *
+ *              Posting does not take the scheduler lock. On ports with
+ *              atomic operations it is lock-free, on other ports interrupts
+ *              are disabled only for the few instructions which claim the
+ *              slot.
+ ********************************************************************//** @{ */
+
+#ifndef NC_DEFER_H
+#define NC_DEFER_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nc_config.h"
+
+/*==============================================================  MACRO's  ==*/
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Deferred function type
+ */
+typedef void (nc_defer_fn)(void *);
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Post a deferred call
+ * @param       fn
+ *              Function to call.
+ * @param       arg
+ *              Argument which is passed to the function.
+ * @return      Is the call queued?
+ * @retval      false - the queue is full, the call is dropped and the overrun
+ *              counter is incremented
+ * @details     May be called from ISRs and threads. Calls posted from one
+ *              context are executed in the order they were posted.
+ */
+bool            nc_defer_post(
+    nc_defer_fn *               fn,
+    void *                      arg);
+
+
+
+/**@brief       Get the number of calls which were dropped since the queue was
+ *              full
+ */
+uint32_t        nc_defer_get_overruns(void);
+
+
+
+/**@brief       Are there any deferred calls waiting?
+ */
+bool            nc_defer_is_pending(void);
+
+
+
+/**@brief       Execute one batch of deferred calls
+ * @details     This function is called by nc_schedule(), the application does
+ *              not need to call it. With more cores calls may be executed in
+ *              parallel on different cores.
+ */
+void            nc_defer_run(void);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if ((CONFIG_NC_DEFER_SIZE & (CONFIG_NC_DEFER_SIZE - 1)) != 0) ||           \
+    (CONFIG_NC_DEFER_SIZE < 2)
+# error "nanocoop: CONFIG_NC_DEFER_SIZE must be a power of 2."
+#endif
+
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_defer.h
+ *****************************************************************************/
+#endif /* NC_DEFER_H */
@@ -0,0 +1,261 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Event flags Implementation
+ * @addtogroup  flags
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+
+#include "nc_flags.h"
+#include "nc_config.h"
+
+/*========================================================  LOCAL MACRO's  ==*/
+/*=====================================================  LOCAL DATA TYPES  ==*/
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Lock event flags
+ */
+static inline
+void flags_lock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock event flags
+ */
+static inline
+void flags_unlock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Is the waiter condition met by the given bits?
+ */
+static inline
+bool is_met(
+    nc_cpu_reg                  bits,
+    nc_cpu_reg                  mask,
+    nc_flags_mode               mode);
+
+
+
+/**@brief       Remove a waiting waiter from the wait list
+ */
+static inline
+void waiter_remove(
+    nc_flags *                  flags,
+    nc_flags_waiter *           waiter);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+/**@brief       Lock protecting all event flags when more cores are used
+ */
+static nc_spinlock        g_flags_lock;
+#endif
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+void flags_lock(
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_flags_lock);
+#endif
+}
+
+
+
+static inline
+void flags_unlock(
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_flags_lock);
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+
+
+static inline
+bool is_met(
+    nc_cpu_reg                  bits,
+    nc_cpu_reg                  mask,
+    nc_flags_mode               mode)
+{
+    if (mode == NC_FLAGS_ALL) {
+        return ((bits & mask) == mask);
+    } else {
+        return ((bits & mask) != 0u);
+    }
+}
+
+
+
+static inline
+void waiter_remove(
+    nc_flags *                  flags,
+    nc_flags_waiter *           waiter)
+{
+    struct nc_flags_waiter **   link;
+
+    link = &flags->waiters;
+
+    while (*link != waiter) {
+        link = &(*link)->next;
+    }
+    *link              = waiter->next;
+    waiter->is_waiting = false;
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_flags_init(
+    nc_flags *                  flags)
+{
+    flags->flags    = 0u;
+    flags->interest = 0u;
+    flags->waiters  = NULL;
+}
+
+
+
+void nc_flags_set(
+    nc_flags *                  flags,
+    nc_cpu_reg                  bits)
+{
+    nc_isr_lock                 isr_context;
+
+    flags_lock(&isr_context);
+    flags->flags |= bits;
+                                     /* Skip the waiters when no one is      */
+    if ((bits & flags->interest) != 0u) {  /* interested in these bits.      */
+        struct nc_flags_waiter ** link;
+        nc_cpu_reg              interest;
+
+        link     = &flags->waiters;
+        interest = 0u;
+
+        while (*link != NULL) {
+            struct nc_flags_waiter * waiter = *link;
+
+            if (is_met(flags->flags, waiter->mask, waiter->mode)) {
+                *link              = waiter->next;
+                waiter->is_waiting = false;
+                nc_thread_ready(waiter->thread);
+            } else {
+                interest |= waiter->mask;
+                link      = &waiter->next;
+            }
+        }
+        flags->interest = interest;
+    }
+    flags_unlock(&isr_context);
+}
+
+
+
+void nc_flags_clear(
+    nc_flags *                  flags,
+    nc_cpu_reg                  bits)
+{
+    nc_isr_lock                 isr_context;
+
+    flags_lock(&isr_context);
+    flags->flags &= (nc_cpu_reg)~bits;
+    flags_unlock(&isr_context);
+}
+
+
+
+nc_cpu_reg nc_flags_get(
+    const nc_flags *            flags)
+{
+    return (flags->flags);
+}
+
+
+
+bool nc_flags_wait(
+    nc_flags *                  flags,
+    nc_flags_waiter *           waiter,
+    nc_cpu_reg                  mask,
+    nc_flags_mode               mode)
+{
+    nc_isr_lock                 isr_context;
+    bool                        is_ready;
+
+    flags_lock(&isr_context);
+    is_ready = is_met(flags->flags, mask, mode);
+
+    if (!is_ready) {
+        waiter->thread = nc_thread_get_current();
+        waiter->mask   = mask;
+        waiter->mode   = mode;
+
+        if (!waiter->is_waiting) {      /* Otherwise it is already queued and */
+            waiter->is_waiting = true;  /* it was made ready by something else */
+            waiter->next       = flags->waiters;
+            flags->waiters     = waiter;
+        }
+        flags->interest |= mask;
+        nc_thread_block(waiter->thread);
+    } else if (waiter->is_waiting) {  /* Met by a new mask of a stray waiter */
+        waiter_remove(flags, waiter);
+    }
+    flags_unlock(&isr_context);
+
+    return (is_ready);
+}
+
+
+
+void nc_flags_cancel(
+    nc_flags *                  flags,
+    nc_flags_waiter *           waiter)
+{
+    nc_isr_lock                 isr_context;
+
+    flags_lock(&isr_context);
+
+    if (waiter->is_waiting) {
+        waiter_remove(flags, waiter);
+    }
+    flags_unlock(&isr_context);
+}
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_flags.c
+ ******************************************************************************/
@@ -0,0 +1,189 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Event flags header
+ * @defgroup    flags Event flags
+ * @brief       Event flag groups
+ * @details     An event flags object is a CPU register wide word of bits.
+ *              Threads wait for any or all bits of a mask. A thread which is
+ *              waiting is blocked and it is made ready when its condition is
+ *              met.
+ ********************************************************************//** @{ */
+
+#ifndef NC_FLAGS_H
+#define NC_FLAGS_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+
+#include "nanocoop.h"
+#include "nc_port.h"
+
+/*==============================================================  MACRO's  ==*/
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Wait condition
+ */
+enum nc_flags_mode
+{
+    NC_FLAGS_ANY,                           /**<@brief Any bit of the mask   */
+    NC_FLAGS_ALL                            /**<@brief All bits of the mask  */
+};
+
+/**@brief       Wait condition type
+ */
+typedef enum nc_flags_mode nc_flags_mode;
+
+/**@brief       Waiter structure
+ * @details     Each waiting thread needs its own waiter structure, usually it
+ *              is placed in thread stack structure. Members of this structure
+ *              are private.
+ */
+struct nc_flags_waiter
+{
+    struct nc_flags_waiter *    next;
+    nc_thread *                 thread;
+    nc_cpu_reg                  mask;
+    nc_flags_mode               mode;
+    bool                        is_waiting;
+};
+
+/**@brief       Waiter type
+ */
+typedef struct nc_flags_waiter nc_flags_waiter;
+
+/**@brief       Event flags structure
+ * @details     A statically allocated event flags object does not need
+ *              initialization, others must be initialized by nc_flags_init().
+ *              Members of this structure are private.
+ */
+struct nc_flags
+{
+    nc_cpu_reg                  flags;
+    nc_cpu_reg                  interest;   /**<@brief Union of waiter masks */
+    struct nc_flags_waiter *    waiters;
+};
+
+/**@brief       Event flags type
+ */
+typedef struct nc_flags nc_flags;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Initialize an event flags object
+ * @param       flags
+ *              Pointer to event flags.
+ */
+void            nc_flags_init(
+    nc_flags *                  flags);
+
+
+
+/**@brief       Set bits
+ * @param       flags
+ *              Pointer to event flags.
+ * @param       bits
+ *              Bits to set.
+ * @details     All waiters whose condition is met are made ready. May be
+ *              called from ISRs.
+ */
+void            nc_flags_set(
+    nc_flags *                  flags,
+    nc_cpu_reg                  bits);
+
+
+
+/**@brief       Clear bits
+ * @param       flags
+ *              Pointer to event flags.
+ * @param       bits
+ *              Bits to clear.
+ */
+void            nc_flags_clear(
+    nc_flags *                  flags,
+    nc_cpu_reg                  bits);
+
+
+
+/**@brief       Get current bits
+ * @param       flags
+ *              Pointer to event flags.
+ */
+nc_cpu_reg      nc_flags_get(
+    const nc_flags *            flags);
+
+
+
+/**@brief       Wait for a condition
+ * @param       flags
+ *              Pointer to event flags.
+ * @param       waiter
+ *              Pointer to waiter structure owned by the calling thread.
+ * @param       mask
+ *              Bits to wait for.
+ * @param       mode
+ *              Wait for any (NC_FLAGS_ANY) or all (NC_FLAGS_ALL) bits.
+ * @return      Is the condition met?
+ * @retval      true  - the condition is met, the thread continues.
+ * @retval      false - the calling thread is blocked and it should return. It
+ *              is made ready when the condition is met and then it should call
+ *              this function again.
+ */
+bool            nc_flags_wait(
+    nc_flags *                  flags,
+    nc_flags_waiter *           waiter,
+    nc_cpu_reg                  mask,
+    nc_flags_mode               mode);
+
+
+
+/**@brief       Stop waiting
+ * @param       flags
+ *              Pointer to event flags.
+ * @param       waiter
+ *              Pointer to waiter structure. If the waiter is not waiting this
+ *              function has no effect.
+ * @details     The thread is not made ready.
+ */
+void            nc_flags_cancel(
+    nc_flags *                  flags,
+    nc_flags_waiter *           waiter);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_flags.h
+ *****************************************************************************/
+#endif /* NC_FLAGS_H */
@@ -0,0 +1,197 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       I/O watcher Implementation
+ * @addtogroup  io
+ * @details     Descriptors are armed for one event at a time with the watcher
+ *              as the port tag, so the poller gets the watcher directly and
+ *              no descriptor table is needed. A one-shot event is returned to
+ *              exactly one scheduler core, which readies the thread. The low
+ *              bits of the tag carry the wait sequence, so an event of an
+ *              older wait of the same watcher is recognized.
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nc_io.h"
+#include "nc_config.h"
+
+#if (CONFIG_NC_IO == 1)
+/*========================================================  LOCAL MACRO's  ==*/
+
+/**@brief       Bits of port tag which hold the wait sequence
+ * @details     Watchers hold a pointer, so they are at least 4 bytes aligned.
+ */
+#define WATCH_TAG_MASK                  0x3u
+
+/*=====================================================  LOCAL DATA TYPES  ==*/
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Claim an armed wait
+ * @param       sequence
+ *              Wait sequence of the armed wait.
+ * @return      Is the wait claimed by the caller?
+ */
+static inline
+bool watch_claim(
+    nc_io_watch *               watch,
+    uint32_t                    sequence);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+bool watch_claim(
+    nc_io_watch *               watch,
+    uint32_t                    sequence)
+{
+    if ((sequence & 0x1u) == 0u) {                         /* Not armed */
+        return (false);
+    }
+
+    return (nc_atomic_u32_cas(&watch->sequence, sequence, sequence - 1u));
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+bool nc_io_init(void)
+{
+    return (nc_cpu_io_init());
+}
+
+
+
+void nc_io_watch_init(
+    nc_io_watch *               watch,
+    int                         fd)
+{
+    watch->thread     = NULL;
+    watch->fd         = fd;
+    watch->events     = 0u;
+    watch->sequence   = 0u;
+}
+
+
+
+bool nc_io_wait(
+    nc_io_watch *               watch,
+    uint32_t                    events)
+{
+    uint32_t                    sequence;
+    void *                      tag;
+
+    watch->thread = nc_thread_get_current();
+    watch->events = 0u;
+    sequence      = (nc_atomic_u32_load(&watch->sequence) | 0x1u) + 2u;
+    tag           = (void *)((uintptr_t)watch |
+        ((sequence >> 1) & WATCH_TAG_MASK));
+    nc_atomic_u32_store(&watch->sequence, sequence);
+                        /* Block before arming: the event may arrive on other */
+    nc_thread_block(watch->thread);         /* core as soon as it is armed. */
+
+    if (!nc_cpu_io_arm(watch->fd, events, tag)) {
+        nc_atomic_u32_store(&watch->sequence, sequence - 1u);
+        nc_thread_ready(watch->thread);
+
+        return (false);
+    }
+
+    return (true);
+}
+
+
+
+uint32_t nc_io_get_events(
+    const nc_io_watch *         watch)
+{
+    return (watch->events);
+}
+
+
+
+bool nc_io_cancel(
+    nc_io_watch *               watch)
+{
+    if (!watch_claim(watch, nc_atomic_u32_load(&watch->sequence))) {
+        return (false);            /* Not waiting or claimed by the poller */
+    }
+    nc_cpu_io_disarm(watch->fd);
+
+    return (true);
+}
+
+
+
+void nc_io_poll(void)
+{
+    nc_io_idle_sleep(nc_cpu_idle_prepare(), 0u);
+}
+
+
+
+void nc_io_idle_sleep(
+    uint32_t                    token,
+    uint64_t                    timeout_ns)
+{
+    struct nc_cpu_io_event      events[CONFIG_NC_IO_BATCH];
+    nc_thread *                 threads[CONFIG_NC_IO_BATCH];
+    size_t                      received;
+    size_t                      count;
+
+    received = nc_cpu_io_wait(token, timeout_ns, events, CONFIG_NC_IO_BATCH);
+    count    = 0u;
+
+    for (size_t itr = 0u; itr < received; itr++) {
+        nc_io_watch *           watch;
+        uintptr_t               tag;
+        uint32_t                sequence;
+
+        tag      = (uintptr_t)events[itr].tag;
+        watch    = (nc_io_watch *)(tag & ~(uintptr_t)WATCH_TAG_MASK);
+        sequence = nc_atomic_u32_load(&watch->sequence);
+                                /* Drop events of cancelled and older waits */
+        if ((((sequence >> 1) & WATCH_TAG_MASK) == (tag & WATCH_TAG_MASK)) &&
+            watch_claim(watch, sequence)) {
+            watch->events    = events[itr].events;
+            threads[count++] = watch->thread;
+        }
+    }
+
+    if (count != 0u) {
+        nc_thread_ready_many(threads, count);
+    }
+}
+
+#endif /* (CONFIG_NC_IO == 1) */
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_io.c
+ ******************************************************************************/
@@ -0,0 +1,225 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       I/O watcher header
+ * @defgroup    io I/O watchers
+ * @brief       Threads waiting for file descriptor events
+ * @details     A thread which would block on a file descriptor registers
+ *              interest in it with nc_io_wait() and returns. The scheduler
+ *              idle path waits for timers, wake-ups and descriptor events
+ *              with one system call and makes all threads whose descriptors
+ *              became ready ready in one batch. Many connections are served
+ *              by one OS thread:
+ *
+ *                  static void conn_fn(void * stack)
+ *                  {
+ *                      struct conn * conn = stack;
+ *
+ *                      if (read(conn->fd, ...) == -1 && errno == EAGAIN) {
+ *                          nc_io_wait(&conn->watch, NC_IO_READ);
+ *                          return;
+ *                      }
+ *                      ...
+ *                  }
+ *
+ *              Descriptors should be in non-blocking mode. Requires a port
+ *              with I/O support, currently only `gcc-x86-linux/x86-64`.
+ ********************************************************************//** @{ */
+
+#ifndef NC_IO_H
+#define NC_IO_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nanocoop.h"
+#include "nc_port.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Descriptor is readable
+ */
+#define NC_IO_READ                      NCPU_IO_READ
+
+/**@brief       Descriptor is writable
+ */
+#define NC_IO_WRITE                     NCPU_IO_WRITE
+
+/**@brief       Peer closed the connection, always reported
+ */
+#define NC_IO_HANGUP                    NCPU_IO_HANGUP
+
+/**@brief       Error condition, always reported
+ */
+#define NC_IO_ERROR                     NCPU_IO_ERROR
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Watcher structure
+ * @details     Each waiting thread needs its own watcher structure, usually
+ *              it is placed in thread stack structure. It must be initialized
+ *              by nc_io_watch_init(). Members of this structure are private.
+ */
+struct nc_io_watch
+{
+    nc_thread *                 thread;
+    int                         fd;
+    uint32_t                    events;     /**<@brief Events which woke up  */
+    /**@brief   Wait sequence, odd while armed. The poller or nc_io_cancel()
+     *          claims an armed wait by CAS.
+     */
+    volatile uint32_t           sequence;
+};
+
+/**@brief       Watcher type
+ */
+typedef struct nc_io_watch nc_io_watch;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Initialize I/O watching
+ * @return      Is the port event poller created?
+ * @details     Call once before the scheduler cores are started.
+ */
+bool            nc_io_init(void);
+
+
+
+/**@brief       Initialize a watcher
+ * @param       watch
+ *              Pointer to watcher.
+ * @param       fd
+ *              Watched file descriptor.
+ */
+void            nc_io_watch_init(
+    nc_io_watch *               watch,
+    int                         fd);
+
+
+
+/**@brief       Wait for descriptor events
+ * @param       watch
+ *              Pointer to watcher owned by the calling thread.
+ * @param       events
+ *              NC_IO_READ and/or NC_IO_WRITE bits.
+ * @return      Is the calling thread waiting?
+ * @retval      true  - the calling thread is blocked and it should return. It
+ *              is made ready by the first event and then nc_io_get_events()
+ *              returns the events.
+ * @retval      false - the descriptor could not be watched, the thread is not
+ *              blocked.
+ * @details     Each call waits for one event only.
+ */
+bool            nc_io_wait(
+    nc_io_watch *               watch,
+    uint32_t                    events);
+
+
+
+/**@brief       Get the events which made the thread ready
+ * @param       watch
+ *              Pointer to watcher.
+ * @return      NC_IO_* bits, 0 when no event was received yet.
+ */
+uint32_t        nc_io_get_events(
+    const nc_io_watch *         watch);
+
+
+
+/**@brief       Stop waiting
+ * @param       watch
+ *              Pointer to watcher. If the watcher is not waiting this
+ *              function has no effect.
+ * @return      Is the wait cancelled?
+ * @retval      true  - the descriptor is disarmed and the thread will not be
+ *              made ready by this wait.
+ * @retval      false - the watcher was not waiting or the event was already
+ *              received, the thread is or will be made ready as usual.
+ * @details     The thread is not made ready. Call this function before the
+ *              descriptor is closed by other thread than the waiting one. It
+ *              may be called from any OS thread: the wait is claimed
+ *              atomically either by this function or by the scheduler core
+ *              which received the event, and only the winner makes the thread
+ *              ready.
+ * @note        A scheduler core may have received the event of a cancelled
+ *              wait just before the wait was cancelled. It checks the watcher
+ *              and drops the event before its nc_idle() or nc_io_poll() call
+ *              returns, so the watcher memory must stay valid until the calls
+ *              which are in progress on other cores return. The watcher may
+ *              wait again right away, a stale event does not match the new
+ *              wait.
+ */
+bool            nc_io_cancel(
+    nc_io_watch *               watch);
+
+
+
+/**@brief       Make threads with pending events ready without sleeping
+ * @details     nc_idle() polls for events, this function is needed only when
+ *              nc_idle() is not used or when the scheduler is rarely idle.
+ */
+void            nc_io_poll(void);
+
+
+
+/**@brief       Sleep until timeout, wake-up or descriptor event
+ * @param       token
+ *              Value returned by nc_cpu_idle_prepare().
+ * @param       timeout_ns
+ *              Relative timeout in nanoseconds, NCPU_IDLE_INFINITE or 0 to
+ *              only poll.
+ * @details     This function is called by nc_idle(), the application does not
+ *              need to call it.
+ */
+void            nc_io_idle_sleep(
+    uint32_t                    token,
+    uint64_t                    timeout_ns);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if !defined(NCPU_IO)
+# error "nanocoop: I/O watchers are used, but the port does not support I/O."
+#endif
+
+#if !defined(NCPU_ATOMIC)
+# error "nanocoop: I/O watchers require a port with atomic operations."
+#endif
+
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_io.h
+ *****************************************************************************/
+#endif /* NC_IO_H */
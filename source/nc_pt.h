@@ -0,0 +1,163 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Resumable threads header
+ * @defgroup    pt Resumable threads
+ * @brief       Protothread style resume points
+ * @details     These macros let a thread function return in the middle of its
+ *              code and continue from the same place on the next dispatch.
+ *              The resume point is a switch case label which is stored in the
+ *              thread descriptor, so no stack is needed:
+ *
+ *                  static void worker_fn(void * stack)
+ *                  {
+ *                      struct worker * worker = stack;
+ *
+ *                      NC_BEGIN();
+ *
+ *                      for (worker->i = 0; worker->i < 1000; worker->i++) {
+ *                          process(worker->i);
+ *                          NC_YIELD();
+ *                      }
+ *                      NC_WAIT_UNTIL(nc_flags_wait(&g_flags, &worker->wait,
+ *                          DONE_FLAG, NC_FLAGS_ANY));
+ *                      NC_DELAY(10);
+ *                      NC_END();
+ *                  }
+ *
+ *              Local variables are not preserved between dispatches, keep the
+ *              state in thread stack structure. The macros must be used in
+ *              the thread function itself and resume points must not be put
+ *              inside of other switch statements.
+ ********************************************************************//** @{ */
+
+#ifndef NC_PT_H
+#define NC_PT_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include "nanocoop.h"
+
+#if (CONFIG_NC_TIMER == 1)
+#include "nc_timer.h"
+#endif
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Begin of resumable thread body
+ * @details     Continues the execution from the last resume point.
+ */
+#define NC_BEGIN()                                                          \
+    {                                                                       \
+        nc_lc * nc_lc_ = nc_thread_get_lc();                                \
+                                                                            \
+        switch (*nc_lc_) {                                                  \
+            case 0u:
+
+/**@brief       End of resumable thread body
+ * @details     The thread enters IDLE state. When it is made ready again it
+ *              starts from the beginning.
+ */
+#define NC_END()                                                            \
+        }                                                                   \
+        NC_EXIT();                                                          \
+    }
+
+/**@brief       Finish the thread execution
+ * @details     The thread enters IDLE state. When it is made ready again it
+ *              starts from the beginning.
+ */
+#define NC_EXIT()                                                           \
+    do {                                                                    \
+        *nc_lc_ = 0u;                                                       \
+        nc_thread_done();                                                   \
+        return;                                                             \
+    } while (0)
+
+/**@brief       Return and continue from here on the next dispatch
+ * @details     The thread stays ready, so other ready threads of the same
+ *              priority are executed first.
+ */
+#define NC_YIELD()                                                          \
+    do {                                                                    \
+        *nc_lc_ = (nc_lc)__LINE__;                                          \
+        return;                                                             \
+        case __LINE__:;                                                     \
+    } while (0)
+
+/**@brief       Return until the condition is true
+ * @param       condition
+ *              Condition which is evaluated on each dispatch. When a blocking
+ *              call such as nc_flags_wait() or nc_queue_peek() is used as the
+ *              condition the thread is blocked until it is made ready by the
+ *              object, otherwise it stays ready and the condition is polled.
+ */
+#define NC_WAIT_UNTIL(condition)                                            \
+    do {                                                                    \
+        *nc_lc_ = (nc_lc)__LINE__;                                          \
+        if (0) {                          /* Entered only on resume */      \
+            case __LINE__:;                                                 \
+        }                                                                   \
+        if (!(condition)) {                                                 \
+            return;                                                         \
+        }                                                                   \
+    } while (0)
+
+#if (CONFIG_NC_TIMER == 1) || defined(__DOXYGEN__)
+/**@brief       Block for a number of ticks and continue from here
+ * @param       ticks
+ *              Number of ticks, see nc_thread_delay().
+ * @details     When the thread is made ready before the delay expires it
+ *              delays again for the rest of the ticks.
+ */
+#define NC_DELAY(ticks)                                                     \
+    do {                                                                    \
+        *nc_lc_ = (nc_lc)__LINE__;                                          \
+        nc_thread_delay(ticks);                                             \
+        return;                                                             \
+        case __LINE__:                                                      \
+        if (nc_thread_delay_left() != 0u) {         /* Made ready early */  \
+            nc_thread_delay(nc_thread_delay_left());                        \
+            return;                                                         \
+        }                                                                   \
+    } while (0)
+#endif
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_pt.h
+ *****************************************************************************/
+#endif /* NC_PT_H */
@@ -0,0 +1,193 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Message queue Implementation
+ * @addtogroup  queue
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+
+#include "nc_queue.h"
+#include "nc_config.h"
+#include "nc_port.h"
+
+/*========================================================  LOCAL MACRO's  ==*/
+/*=====================================================  LOCAL DATA TYPES  ==*/
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Lock queues
+ */
+static inline
+void queue_lock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock queues
+ */
+static inline
+void queue_unlock(
+    nc_isr_lock *               isr_context);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+/**@brief       Lock protecting all queues when more cores are used
+ */
+static nc_spinlock        g_queue_lock;
+#endif
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+void queue_lock(
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_queue_lock);
+#endif
+}
+
+
+
+static inline
+void queue_unlock(
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_queue_lock);
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_queue_attach(
+    nc_queue *                  queue,
+    nc_thread *                 consumer)
+{
+    queue->consumer = consumer;
+}
+
+
+
+void * nc_queue_reserve(
+    nc_queue *                  queue)
+{
+    nc_isr_lock                 isr_context;
+    void *                      slot;
+
+    queue_lock(&isr_context);
+
+    if ((queue->reserved - queue->released) > queue->mask) {  /* Is full? */
+        slot = NULL;
+    } else {
+        slot = &queue->storage[
+            (queue->reserved & queue->mask) * queue->item_size];
+        queue->reserved++;
+        queue->writers++;
+    }
+    queue_unlock(&isr_context);
+
+    return (slot);
+}
+
+
+
+void nc_queue_commit(
+    nc_queue *                  queue)
+{
+    nc_isr_lock                 isr_context;
+
+    queue_lock(&isr_context);
+    queue->writers--;
+
+    if (queue->writers == 0u) {     /* Publish when no writer is in progress */
+        queue->committed = queue->reserved;
+
+        if (queue->consumer != NULL) {
+            nc_thread_ready(queue->consumer);
+        }
+    }
+    queue_unlock(&isr_context);
+}
+
+
+
+void * nc_queue_peek(
+    nc_queue *                  queue,
+    size_t *                    count)
+{
+    nc_isr_lock                 isr_context;
+    void *                      message;
+    size_t                      available;
+
+    queue_lock(&isr_context);
+    available = queue->committed - queue->released;
+
+    if (available == 0u) {                   /* Block while holding the lock */
+        nc_thread_block(nc_thread_get_current());  /* so no commit is lost. */
+        message = NULL;
+    } else {
+        size_t                  index;
+        size_t                  contiguous;
+
+        index      = queue->released & queue->mask;
+        contiguous = queue->mask + 1u - index;  /* Slots until ring wraps */
+        message    = &queue->storage[index * queue->item_size];
+
+        if (available > contiguous) {
+            available = contiguous;
+        }
+    }
+    queue_unlock(&isr_context);
+    *count = available;
+
+    return (message);
+}
+
+
+
+void nc_queue_release(
+    nc_queue *                  queue,
+    size_t                      count)
+{
+    nc_isr_lock                 isr_context;
+
+    queue_lock(&isr_context);
+    queue->released += count;
+    queue_unlock(&isr_context);
+}
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_queue.c
+ ******************************************************************************/
@@ -0,0 +1,181 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Message queue header
+ * @defgroup    queue Message queue
+ * @brief       Fixed capacity zero-copy message queues
+ * @details     A queue is a ring of fixed size message slots which is
+ *              allocated during the compile time by NC_QUEUE_DEFINE() macro.
+ *              Producers reserve a slot, write the message directly into it
+ *              and commit it. The consumer thread reads messages in place, in
+ *              batches, and releases them. Messages are never copied by the
+ *              queue.
+ ********************************************************************//** @{ */
+
+#ifndef NC_QUEUE_H
+#define NC_QUEUE_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocoop.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Define a statically allocated message queue
+ * @param       name
+ *              Name of queue variable of type nc_queue.
+ * @param       type
+ *              Type of message.
+ * @param       capacity
+ *              Maximum number of messages in the queue, must be a power of 2.
+ * @details     The queue and its storage are local to the translation unit,
+ *              so the same name may be used in other files. Pass a pointer to
+ *              the queue to share it.
+ */
+#define NC_QUEUE_DEFINE(name, type, capacity)                               \
+    static type name ## _storage[(capacity) &&                              \
+        (((capacity) & ((capacity) - 1u)) == 0u) ? (long)(capacity) : -1];  \
+    static nc_queue name =                                                  \
+    {                                                                       \
+        (uint8_t *)name ## _storage,                                        \
+        sizeof(type),                                                       \
+        (capacity) - 1u,                                                    \
+        0u,                                                                 \
+        0u,                                                                 \
+        0u,                                                                 \
+        0u,                                                                 \
+        NULL                                                                \
+    }
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Message queue structure
+ * @details     Members of this structure are private, use NC_QUEUE_DEFINE()
+ *              to allocate a queue.
+ */
+struct nc_queue
+{
+    uint8_t *                   storage;
+    size_t                      item_size;
+    size_t                      mask;       /**<@brief Capacity - 1          */
+    size_t                      reserved;   /**<@brief Reserved slots count  */
+    size_t                      committed;  /**<@brief Visible to consumer   */
+    size_t                      released;   /**<@brief Consumed slots count  */
+    uint_fast8_t                writers;    /**<@brief Pending reservations  */
+    nc_thread *                 consumer;
+};
+
+/**@brief       Message queue type
+ */
+typedef struct nc_queue nc_queue;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Set the consumer thread of a queue
+ * @param       queue
+ *              Pointer to queue.
+ * @param       consumer
+ *              Thread which is made ready when messages are committed.
+ */
+void            nc_queue_attach(
+    nc_queue *                  queue,
+    nc_thread *                 consumer);
+
+
+
+/**@brief       Reserve a message slot
+ * @param       queue
+ *              Pointer to queue.
+ * @return      Pointer to message slot where the message should be written.
+ * @retval      NULL - the queue is full
+ * @details     May be called from threads or ISRs. Each reservation must be
+ *              followed by nc_queue_commit(). Reservations which are nested,
+ *              for example from an ISR, become visible together when the last
+ *              one is committed.
+ */
+void *          nc_queue_reserve(
+    nc_queue *                  queue);
+
+
+
+/**@brief       Commit a previously reserved message slot
+ * @param       queue
+ *              Pointer to queue.
+ * @details     The consumer thread is made ready.
+ */
+void            nc_queue_commit(
+    nc_queue *                  queue);
+
+
+
+/**@brief       Get committed messages
+ * @param       queue
+ *              Pointer to queue.
+ * @param       count
+ *              Pointer to variable which receives the number of messages
+ *              which are stored contiguously from the returned pointer.
+ * @return      Pointer to the first message.
+ * @retval      NULL - the queue is empty. In this case the calling consumer
+ *              thread is blocked and it should return. It is made ready again
+ *              on the next commit.
+ * @details     This function must be called only from consumer thread. A
+ *              single call may return many messages, use nc_queue_release()
+ *              to free them after they are processed.
+ */
+void *          nc_queue_peek(
+    nc_queue *                  queue,
+    size_t *                    count);
+
+
+
+/**@brief       Release processed messages
+ * @param       queue
+ *              Pointer to queue.
+ * @param       count
+ *              Number of messages to release, at most the count returned by
+ *              nc_queue_peek().
+ */
+void            nc_queue_release(
+    nc_queue *                  queue,
+    size_t                      count);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_queue.h
+ *****************************************************************************/
+#endif /* NC_QUEUE_H */
@@ -0,0 +1,330 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Counting semaphore Implementation
+ * @addtogroup  sem
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+
+#include "nc_sem.h"
+#include "nc_config.h"
+
+/*========================================================  LOCAL MACRO's  ==*/
+/*=====================================================  LOCAL DATA TYPES  ==*/
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Lock semaphores
+ */
+static inline
+void sem_lock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock semaphores
+ */
+static inline
+void sem_unlock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Append a waiter to the wait list of its priority level
+ */
+static inline
+void waiter_push(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter);
+
+
+
+/**@brief       Remove the first waiter of the highest priority level
+ */
+static inline
+nc_sem_waiter * waiter_pop(
+    nc_sem *                    sem);
+
+
+
+/**@brief       Remove a waiter from its wait list
+ */
+static inline
+void waiter_remove(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter);
+
+
+
+/**@brief       Hand the unit over to a waiter or count it
+ */
+static inline
+void sem_give(
+    nc_sem *                    sem);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+/**@brief       Lock protecting all semaphores when more cores are used
+ */
+static nc_spinlock        g_sem_lock;
+#endif
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+void sem_lock(
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_sem_lock);
+#endif
+}
+
+
+
+static inline
+void sem_unlock(
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_sem_lock);
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+
+
+static inline
+void waiter_push(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter)
+{
+    nc_sem_waiter *             tail;
+
+    tail = sem->tail[waiter->priority];
+
+    if (tail == NULL) {                     /* Is this the first waiter? */
+        waiter->next = waiter;
+        nc_bitmap_set(&sem->waiting, waiter->priority);
+    } else {
+        waiter->next = tail->next;
+        tail->next   = waiter;
+    }
+    sem->tail[waiter->priority] = waiter;
+}
+
+
+
+static inline
+nc_sem_waiter * waiter_pop(
+    nc_sem *                    sem)
+{
+    uint_fast8_t                priority;
+    nc_sem_waiter *             tail;
+    nc_sem_waiter *             head;
+
+    priority = nc_bitmap_get_highest(&sem->waiting);
+    tail     = sem->tail[priority];
+    head     = tail->next;
+
+    if (head == tail) {                     /* Is this the last waiter? */
+        sem->tail[priority] = NULL;
+        nc_bitmap_clear(&sem->waiting, priority);
+    } else {
+        tail->next = head->next;
+    }
+
+    return (head);
+}
+
+
+
+static inline
+void waiter_remove(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter)
+{
+    nc_sem_waiter *             prev;
+
+    prev = sem->tail[waiter->priority];
+
+    while (prev->next != waiter) {
+        prev = prev->next;
+    }
+
+    if (prev == waiter) {                   /* Is this the last waiter? */
+        sem->tail[waiter->priority] = NULL;
+        nc_bitmap_clear(&sem->waiting, waiter->priority);
+    } else {
+        prev->next = waiter->next;
+
+        if (sem->tail[waiter->priority] == waiter) {
+            sem->tail[waiter->priority] = prev;
+        }
+    }
+}
+
+
+
+static inline
+void sem_give(
+    nc_sem *                    sem)
+{
+    if (nc_bitmap_is_empty(&sem->waiting)) {
+        sem->count++;
+    } else {
+        nc_sem_waiter *         waiter;
+
+        waiter             = waiter_pop(sem);
+        waiter->is_waiting = false;
+        waiter->is_granted = true;
+        nc_thread_ready(waiter->thread);
+    }
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_sem_init(
+    nc_sem *                    sem,
+    uint32_t                    count)
+{
+    sem->count = count;
+
+    for (uint_fast8_t itr = 0u; itr < NC_BITMAP_GROUPS; itr++) {
+        sem->waiting.level[itr] = 0u;
+    }
+#if (CONFIG_NC_NUM_OF_PRIO_LEVELS > NCPU_DATA_WIDTH)
+    sem->waiting.group = 0u;
+#endif
+
+    for (uint_fast16_t itr = 0u; itr < CONFIG_NC_NUM_OF_PRIO_LEVELS; itr++) {
+        sem->tail[itr] = NULL;
+    }
+}
+
+
+
+bool nc_sem_take(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter)
+{
+    nc_isr_lock                 isr_context;
+    bool                        is_taken;
+
+    sem_lock(&isr_context);
+
+    if (waiter->is_granted) {               /* A unit was handed over */
+        waiter->is_granted = false;
+        is_taken           = true;
+    } else if (sem->count != 0u) {
+        sem->count--;
+        is_taken = true;
+    } else {
+        is_taken = false;
+
+        if (!waiter->is_waiting) {    /* Otherwise it is already in the list */
+            waiter->thread     = nc_thread_get_current();
+            waiter->priority   = (uint8_t)nc_thread_get_priority(
+                waiter->thread);
+            waiter->is_waiting = true;
+            waiter_push(sem, waiter);
+        }
+        nc_thread_block(waiter->thread);
+    }
+    sem_unlock(&isr_context);
+
+    return (is_taken);
+}
+
+
+
+bool nc_sem_try_take(
+    nc_sem *                    sem)
+{
+    nc_isr_lock                 isr_context;
+    bool                        is_taken;
+
+    sem_lock(&isr_context);
+    is_taken = sem->count != 0u;
+
+    if (is_taken) {
+        sem->count--;
+    }
+    sem_unlock(&isr_context);
+
+    return (is_taken);
+}
+
+
+
+void nc_sem_give(
+    nc_sem *                    sem)
+{
+    nc_isr_lock                 isr_context;
+
+    sem_lock(&isr_context);
+    sem_give(sem);
+    sem_unlock(&isr_context);
+}
+
+
+
+uint32_t nc_sem_get_count(
+    const nc_sem *              sem)
+{
+    return (sem->count);
+}
+
+
+
+void nc_sem_cancel(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter)
+{
+    nc_isr_lock                 isr_context;
+
+    sem_lock(&isr_context);
+
+    if (waiter->is_waiting) {
+        waiter_remove(sem, waiter);
+        waiter->is_waiting = false;
+    } else if (waiter->is_granted) {        /* Pass the unit to other waiter */
+        waiter->is_granted = false;
+        sem_give(sem);
+    }
+    sem_unlock(&isr_context);
+}
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_sem.c
+ ******************************************************************************/
@@ -0,0 +1,177 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Counting semaphore header
+ * @defgroup    sem Counting semaphores
+ * @brief       Resource counters with priority ordered waiters
+ * @details     A thread which takes a unit of an empty semaphore is blocked
+ *              and it is put into the wait list of its priority level. A
+ *              priority bitmap marks the levels with waiters, so giving a unit
+ *              finds the highest priority waiter in constant time. The unit
+ *              is handed over to the waiter directly, other threads can not
+ *              take it before the waiter is executed. Waiters of the same
+ *              priority are served in FIFO order.
+ ********************************************************************//** @{ */
+
+#ifndef NC_SEM_H
+#define NC_SEM_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nanocoop.h"
+#include "nc_bitmap.h"
+
+/*==============================================================  MACRO's  ==*/
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Waiter structure
+ * @details     Each waiting thread needs its own waiter structure, usually it
+ *              is placed in thread stack structure. A zero initialized waiter
+ *              is valid. Members of this structure are private.
+ */
+struct nc_sem_waiter
+{
+    struct nc_sem_waiter *      next;
+    nc_thread *                 thread;
+    uint8_t                     priority;
+    bool                        is_waiting;
+    bool                        is_granted; /**<@brief Unit was handed over  */
+};
+
+/**@brief       Waiter type
+ */
+typedef struct nc_sem_waiter nc_sem_waiter;
+
+/**@brief       Semaphore structure
+ * @details     A statically allocated semaphore with no units does not need
+ *              initialization, others must be initialized by nc_sem_init().
+ *              Members of this structure are private.
+ */
+struct nc_sem
+{
+    uint32_t                    count;
+    struct nc_bitmap            waiting;    /**<@brief Levels with waiters   */
+    /**@brief   Last waiter of each level, wait lists are circular */
+    struct nc_sem_waiter *      tail[CONFIG_NC_NUM_OF_PRIO_LEVELS];
+};
+
+/**@brief       Semaphore type
+ */
+typedef struct nc_sem nc_sem;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Initialize a semaphore
+ * @param       sem
+ *              Pointer to semaphore.
+ * @param       count
+ *              Initial number of units.
+ */
+void            nc_sem_init(
+    nc_sem *                    sem,
+    uint32_t                    count);
+
+
+
+/**@brief       Take a unit
+ * @param       sem
+ *              Pointer to semaphore.
+ * @param       waiter
+ *              Pointer to waiter structure owned by the calling thread.
+ * @return      Is a unit taken?
+ * @retval      true  - the unit is taken, the thread continues.
+ * @retval      false - the calling thread is blocked and it should return. It
+ *              is made ready when a unit is given to it and then it should
+ *              call this function again.
+ */
+bool            nc_sem_take(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter);
+
+
+
+/**@brief       Take a unit if one is available
+ * @param       sem
+ *              Pointer to semaphore.
+ * @return      Is a unit taken? The calling thread is never blocked.
+ */
+bool            nc_sem_try_take(
+    nc_sem *                    sem);
+
+
+
+/**@brief       Give a unit
+ * @param       sem
+ *              Pointer to semaphore.
+ * @details     When threads are waiting the unit is handed over to the
+ *              highest priority waiter which is made ready, otherwise the
+ *              unit is counted. Executes in constant time. May be called from
+ *              ISRs.
+ */
+void            nc_sem_give(
+    nc_sem *                    sem);
+
+
+
+/**@brief       Get the number of available units
+ * @param       sem
+ *              Pointer to semaphore.
+ */
+uint32_t        nc_sem_get_count(
+    const nc_sem *              sem);
+
+
+
+/**@brief       Stop waiting
+ * @param       sem
+ *              Pointer to semaphore.
+ * @param       waiter
+ *              Pointer to waiter structure. If the waiter is not waiting this
+ *              function has no effect.
+ * @details     The thread is not made ready. A unit which was already handed
+ *              over to the waiter is given back to the semaphore.
+ */
+void            nc_sem_cancel(
+    nc_sem *                    sem,
+    nc_sem_waiter *             waiter);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_sem.h
+ *****************************************************************************/
+#endif /* NC_SEM_H */
@@ -0,0 +1,401 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Arena and slab allocator Implementation
+ * @addtogroup  slab
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdint.h>
+
+#include "nc_slab.h"
+#include "nc_config.h"
+
+#if !defined(NCPU_PAGE)
+#include <stdlib.h>
+#endif
+
+/*========================================================  LOCAL MACRO's  ==*/
+
+#define ROUNDUP(value, align)                                               \
+    (((value) + (align) - 1u) / (align) * (align))
+
+/**@brief       Alignment of arena allocations
+ */
+#define ARENA_ALIGN                     sizeof(union arena_align)
+
+/**@brief       Offset of chunk payload from chunk start
+ */
+#define CHUNK_HEADER                                                        \
+    ROUNDUP(sizeof(struct nc_arena_chunk), ARENA_ALIGN)
+
+/*=====================================================  LOCAL DATA TYPES  ==*/
+
+/**@brief       Union of the types with the strictest alignment
+ */
+union arena_align
+{
+    void *                      pointer;
+    void                     (* function)(void);
+    uint64_t                    integer;
+    long double                 floating;
+};
+
+/**@brief       Arena chunk header, the payload follows it
+ */
+struct nc_arena_chunk
+{
+    struct nc_arena_chunk *     next;
+    size_t                      size;       /**<@brief Size of payload       */
+};
+
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Get a new chunk from the page allocator
+ */
+static
+struct nc_arena_chunk * chunk_alloc(
+    size_t                      payload);
+
+
+
+/**@brief       Return a chunk to the page allocator
+ */
+static
+void chunk_free(
+    struct nc_arena_chunk *     chunk);
+
+
+
+/**@brief       Take an object from a locked slab
+ */
+static inline
+void * slab_take(
+    nc_slab *                   slab);
+
+
+
+/**@brief       Lock a slab
+ */
+static inline
+void slab_lock(
+    nc_slab *                   slab,
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock a slab
+ */
+static inline
+void slab_unlock(
+    nc_slab *                   slab,
+    nc_isr_lock *               isr_context);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static
+struct nc_arena_chunk * chunk_alloc(
+    size_t                      payload)
+{
+    struct nc_arena_chunk *     chunk;
+    size_t                      size;
+
+#if defined(NCPU_PAGE)
+    size  = ROUNDUP(CHUNK_HEADER + payload, NCPU_PAGE_SIZE);
+    chunk = nc_cpu_page_alloc(size);
+#else
+    size  = CHUNK_HEADER + payload;
+    chunk = malloc(size);
+#endif
+
+    if (chunk != NULL) {
+        chunk->next = NULL;
+        chunk->size = size - CHUNK_HEADER;
+    }
+
+    return (chunk);
+}
+
+
+
+static
+void chunk_free(
+    struct nc_arena_chunk *     chunk)
+{
+#if defined(NCPU_PAGE)
+    nc_cpu_page_free(chunk, CHUNK_HEADER + chunk->size);
+#else
+    free(chunk);
+#endif
+}
+
+
+
+static inline
+void * slab_take(
+    nc_slab *                   slab)
+{
+    void *                      mem;
+
+    mem = slab->free;
+
+    if (mem != NULL) {                      /* Take a freed object first... */
+        slab->free = *(void **)mem;
+    } else {                                /* ...then carve a new one.     */
+        size_t                  size;
+
+        size = slab->item_size;
+
+        if (size < sizeof(void *)) {         /* Room for the free list link */
+            size = sizeof(void *);
+        }
+        mem = nc_arena_alloc(&slab->arena, size);
+    }
+
+    return (mem);
+}
+
+
+
+static inline
+void slab_lock(
+    nc_slab *                   slab,
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&slab->lock);
+#else
+    (void)slab;
+#endif
+}
+
+
+
+static inline
+void slab_unlock(
+    nc_slab *                   slab,
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&slab->lock);
+#else
+    (void)slab;
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_arena_init(
+    nc_arena *                  arena,
+    size_t                      chunk_size)
+{
+    arena->first      = NULL;
+    arena->current    = NULL;
+    arena->used       = 0u;
+    arena->chunk_size = chunk_size;
+}
+
+
+
+void * nc_arena_alloc(
+    nc_arena *                  arena,
+    size_t                      size)
+{
+    struct nc_arena_chunk *     chunk;
+    void *                      mem;
+
+    size  = ROUNDUP(size, ARENA_ALIGN);
+    chunk = arena->current;
+
+    if ((chunk == NULL) || ((chunk->size - arena->used) < size)) {
+        struct nc_arena_chunk * next;
+
+        next = (chunk != NULL) ? chunk->next : arena->first;
+                                     /* Reuse a chunk kept by the last reset */
+        if ((next == NULL) || (next->size < size)) {
+            size_t              payload;
+
+            payload = (arena->chunk_size != 0u) ?
+                arena->chunk_size : CONFIG_NC_SLAB_CHUNK_SIZE;
+            payload = (payload > CHUNK_HEADER) ? payload - CHUNK_HEADER : 0u;
+
+            if (payload < size) {                   /* Oversized allocation */
+                payload = size;
+            }
+            next = chunk_alloc(payload);
+
+            if (next == NULL) {
+                return (NULL);
+            }
+
+            if (chunk != NULL) {        /* Link it after the current chunk */
+                next->next  = chunk->next;
+                chunk->next = next;
+            } else {
+                next->next   = arena->first;
+                arena->first = next;
+            }
+        }
+        chunk          = next;
+        arena->current = chunk;
+        arena->used    = 0u;
+    }
+    mem          = (uint8_t *)chunk + CHUNK_HEADER + arena->used;
+    arena->used += size;
+
+    return (mem);
+}
+
+
+
+void nc_arena_reset(
+    nc_arena *                  arena)
+{
+    arena->current = NULL;
+    arena->used    = 0u;
+}
+
+
+
+void nc_arena_term(
+    nc_arena *                  arena)
+{
+    while (arena->first != NULL) {
+        struct nc_arena_chunk * chunk = arena->first;
+
+        arena->first = chunk->next;
+        chunk_free(chunk);
+    }
+    nc_arena_reset(arena);
+}
+
+
+
+void nc_slab_init(
+    nc_slab *                   slab,
+    size_t                      item_size,
+    size_t                      chunk_size)
+{
+    nc_arena_init(&slab->arena, chunk_size);
+    slab->item_size = item_size;
+    slab->free      = NULL;
+}
+
+
+
+void * nc_slab_alloc(
+    nc_slab *                   slab)
+{
+    nc_isr_lock                 isr_context;
+    void *                      mem;
+
+    slab_lock(slab, &isr_context);
+    mem = slab_take(slab);
+    slab_unlock(slab, &isr_context);
+
+    return (mem);
+}
+
+
+
+void nc_slab_free(
+    nc_slab *                   slab,
+    void *                      mem)
+{
+    nc_isr_lock                 isr_context;
+
+    slab_lock(slab, &isr_context);
+    *(void **)mem = slab->free;
+    slab->free    = mem;
+    slab_unlock(slab, &isr_context);
+}
+
+
+
+void nc_slab_reset(
+    nc_slab *                   slab)
+{
+    nc_isr_lock                 isr_context;
+
+    slab_lock(slab, &isr_context);
+    slab->free = NULL;
+    nc_arena_reset(&slab->arena);
+    slab_unlock(slab, &isr_context);
+}
+
+
+
+void nc_slab_term(
+    nc_slab *                   slab)
+{
+    nc_isr_lock                 isr_context;
+
+    slab_lock(slab, &isr_context);
+    slab->free = NULL;
+    nc_arena_term(&slab->arena);
+    slab_unlock(slab, &isr_context);
+}
+
+
+
+void * nc_slab_allocator_alloc(
+    void *                      slab_,
+    size_t                      size)
+{
+    nc_slab *                   slab = slab_;
+    nc_isr_lock                 isr_context;
+    void *                      mem;
+
+    slab_lock(slab, &isr_context);
+
+    if (slab->item_size == 0u) {        /* The first allocation sets the size */
+        slab->item_size = size;
+    }
+    mem = (size <= slab->item_size) ? slab_take(slab) : NULL;
+    slab_unlock(slab, &isr_context);
+
+    return (mem);
+}
+
+
+
+void nc_slab_allocator_free(
+    void *                      slab,
+    void *                      mem)
+{
+    nc_slab_free(slab, mem);
+}
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_slab.c
+ ******************************************************************************/
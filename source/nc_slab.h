@@ -0,0 +1,244 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Arena and slab allocator header
+ * @defgroup    slab Arena and slab allocator
+ * @brief       Heap-free allocation of fixed size objects
+ * @details     An arena hands out memory from chunks which are taken from the
+ *              port page allocator, or from `malloc()` on ports without one,
+ *              and it never returns single allocations. All allocations of an
+ *              arena are released at once by nc_arena_reset() in constant
+ *              time; the chunks are kept and reused by later allocations.
+ *
+ *              A slab keeps a free list of fixed size objects on top of an
+ *              arena, so objects can also be freed one by one. Allocation and
+ *              freeing take constant time and may be called from ISRs, except
+ *              when the arena needs a new chunk.
+ *
+ *              Zero initialized arenas and slabs are valid. They use
+ *              `CONFIG_NC_SLAB_CHUNK_SIZE` chunks and a slab with object size
+ *              0 takes the size of its first allocation.
+ ********************************************************************//** @{ */
+
+#ifndef NC_SLAB_H
+#define NC_SLAB_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+
+#include "nanocoop.h"
+#include "nc_port.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Initializer of nc_allocator which uses a slab
+ * @param       slab
+ *              Pointer to slab.
+ */
+#define NC_SLAB_ALLOCATOR(slab)                                             \
+    {                                                                       \
+        nc_slab_allocator_alloc,                                            \
+        nc_slab_allocator_free,                                             \
+        (slab)                                                              \
+    }
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Arena structure
+ * @details     Members of this structure are private.
+ */
+struct nc_arena
+{
+    struct nc_arena_chunk *     first;
+    struct nc_arena_chunk *     current;    /**<@brief NULL after reset      */
+    size_t                      used;       /**<@brief Used bytes of current */
+    size_t                      chunk_size;
+};
+
+/**@brief       Arena type
+ */
+typedef struct nc_arena nc_arena;
+
+/**@brief       Slab structure
+ * @details     Members of this structure are private.
+ */
+struct nc_slab
+{
+    struct nc_arena             arena;
+    size_t                      item_size;
+    void *                      free;       /**<@brief Freed objects list    */
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spinlock                 lock;
+#endif
+};
+
+/**@brief       Slab type
+ */
+typedef struct nc_slab nc_slab;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Initialize an arena
+ * @param       arena
+ *              Pointer to arena.
+ * @param       chunk_size
+ *              Size of chunks taken from the page allocator, 0 for
+ *              `CONFIG_NC_SLAB_CHUNK_SIZE`.
+ */
+void            nc_arena_init(
+    nc_arena *                  arena,
+    size_t                      chunk_size);
+
+
+
+/**@brief       Allocate memory from an arena
+ * @param       arena
+ *              Pointer to arena.
+ * @param       size
+ *              Size in bytes.
+ * @return      Pointer to memory aligned for any object type.
+ * @retval      NULL - no memory for a new chunk
+ * @details     Arenas are not locked, use a slab when allocations are made
+ *              from more contexts.
+ */
+void *          nc_arena_alloc(
+    nc_arena *                  arena,
+    size_t                      size);
+
+
+
+/**@brief       Release all allocations of an arena in constant time
+ * @param       arena
+ *              Pointer to arena.
+ * @details     Chunks are kept and reused by the following allocations.
+ */
+void            nc_arena_reset(
+    nc_arena *                  arena);
+
+
+
+/**@brief       Release all allocations and return chunks to the page
+ *              allocator
+ * @param       arena
+ *              Pointer to arena.
+ */
+void            nc_arena_term(
+    nc_arena *                  arena);
+
+
+
+/**@brief       Initialize a slab
+ * @param       slab
+ *              Pointer to slab.
+ * @param       item_size
+ *              Size of objects, 0 to take the size of the first allocation.
+ * @param       chunk_size
+ *              Size of arena chunks, 0 for `CONFIG_NC_SLAB_CHUNK_SIZE`.
+ */
+void            nc_slab_init(
+    nc_slab *                   slab,
+    size_t                      item_size,
+    size_t                      chunk_size);
+
+
+
+/**@brief       Allocate an object from a slab
+ * @param       slab
+ *              Pointer to slab.
+ * @return      Pointer to object.
+ * @retval      NULL - no memory for a new chunk
+ */
+void *          nc_slab_alloc(
+    nc_slab *                   slab);
+
+
+
+/**@brief       Return an object to a slab
+ * @param       slab
+ *              Pointer to slab.
+ * @param       mem
+ *              Object allocated by nc_slab_alloc().
+ */
+void            nc_slab_free(
+    nc_slab *                   slab,
+    void *                      mem);
+
+
+
+/**@brief       Release all objects of a slab in constant time
+ * @param       slab
+ *              Pointer to slab.
+ * @details     Used to tear down a whole subsystem at once. The objects must
+ *              not be used anymore, for example threads must not be ready or
+ *              waiting on timers.
+ */
+void            nc_slab_reset(
+    nc_slab *                   slab);
+
+
+
+/**@brief       Release all objects and return chunks to the page allocator
+ * @param       slab
+ *              Pointer to slab.
+ */
+void            nc_slab_term(
+    nc_slab *                   slab);
+
+
+
+/**@brief       Allocation function of nc_allocator interface
+ * @param       slab
+ *              Pointer to slab.
+ * @param       size
+ *              Requested size, must not be greater than slab object size.
+ */
+void *          nc_slab_allocator_alloc(
+    void *                      slab,
+    size_t                      size);
+
+
+
+/**@brief       Free function of nc_allocator interface
+ */
+void            nc_slab_allocator_free(
+    void *                      slab,
+    void *                      mem);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_slab.h
+ *****************************************************************************/
+#endif /* NC_SLAB_H */
@@ -0,0 +1,441 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Timer Implementation
+ * @addtogroup  timer
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "nc_timer.h"
+#include "nc_config.h"
+#include "nc_port.h"
+
+#if (CONFIG_NC_TIMER == 1)
+/*========================================================  LOCAL MACRO's  ==*/
+
+#define WHEEL_SLOTS                     (1u << CONFIG_NC_TIMER_WHEEL_BITS)
+
+#define WHEEL_MASK                      (WHEEL_SLOTS - 1u)
+
+/**@brief       Slot index of the given tick on the given wheel level
+ */
+#define WHEEL_INDEX(tick, level)                                            \
+    (((tick) >> ((level) * CONFIG_NC_TIMER_WHEEL_BITS)) & WHEEL_MASK)
+
+/*=====================================================  LOCAL DATA TYPES  ==*/
+
+/**@brief       Hierarchical timing wheel
+ * @details     Level 0 holds timers which expire within next `WHEEL_SLOTS`
+ *              ticks, one slot per tick. Each next level slot covers all
+ *              slots of the previous level. When level 0 wraps around, the
+ *              current slot of level 1 is cascaded down, and so on.
+ */
+struct nc_wheel
+{
+    nc_tick                     base;   /**<@brief Next tick to be processed */
+    struct nc_timer *           slot[CONFIG_NC_TIMER_WHEEL_LEVELS][WHEEL_SLOTS];
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spinlock                 lock;
+#endif
+};
+
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Lock the timing wheel
+ */
+static inline
+void wheel_lock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Unlock the timing wheel
+ */
+static inline
+void wheel_unlock(
+    nc_isr_lock *               isr_context);
+
+
+
+/**@brief       Insert a timer into the wheel slot matching its expiry
+ */
+static
+void wheel_insert(
+    struct nc_timer *           timer);
+
+
+
+/**@brief       Remove a timer from the wheel
+ */
+static inline
+void wheel_remove(
+    struct nc_timer *           timer);
+
+
+
+/**@brief       Move all timers from the given slot to lower levels
+ * @return      Slot index which was cascaded
+ */
+static
+uint_fast8_t wheel_cascade(
+    uint_fast8_t                level,
+    uint_fast8_t                index);
+
+
+
+/**@brief       Get the number of ticks after `base` tick until the wheel has
+ *              some work to do
+ * @return      Number of ticks which can be skipped, or NC_TIMER_INFINITE
+ * @details     A timer in higher level is cascaded before it expires, so its
+ *              cascading point is taken as its lower bound.
+ */
+static
+nc_tick wheel_next_event(void);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+/**@brief       Timing wheel
+ */
+static struct nc_wheel    g_wheel;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+void wheel_lock(
+    nc_isr_lock *               isr_context)
+{
+    nc_isr_lock_save(isr_context);
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_lock(&g_wheel.lock);
+#endif
+}
+
+
+
+static inline
+void wheel_unlock(
+    nc_isr_lock *               isr_context)
+{
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    nc_spin_unlock(&g_wheel.lock);
+#endif
+    nc_isr_unlock(isr_context);
+}
+
+
+
+static
+void wheel_insert(
+    struct nc_timer *           timer)
+{
+    struct nc_timer **          slot;
+    nc_tick                     delta;
+    uint_fast8_t                level;
+
+    delta = timer->expires - g_wheel.base;
+
+    if (delta > ((nc_tick)~(nc_tick)0 >> 1)) {   /* Already expired, expire */
+        slot = &g_wheel.slot[0][WHEEL_INDEX(g_wheel.base, 0u)];  /* on next */
+    } else {                                                     /* tick.   */
+        nc_tick                 expires;
+
+        expires = timer->expires;
+
+        if (delta > NC_TIMER_MAX_TICKS) {          /* Park too long timeouts */
+            delta   = NC_TIMER_MAX_TICKS;          /* in the last level.     */
+            expires = g_wheel.base + NC_TIMER_MAX_TICKS;
+        }
+        level = 0u;
+
+        while ((delta >> ((level + 1u) * CONFIG_NC_TIMER_WHEEL_BITS)) != 0u) {
+            level++;
+        }
+        slot = &g_wheel.slot[level][WHEEL_INDEX(expires, level)];
+    }
+    timer->next  = *slot;
+    timer->pprev = slot;
+
+    if (*slot != NULL) {
+        (*slot)->pprev = &timer->next;
+    }
+    *slot = timer;
+}
+
+
+
+static inline
+void wheel_remove(
+    struct nc_timer *           timer)
+{
+    *timer->pprev = timer->next;
+
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->pprev = NULL;
+}
+
+
+
+static
+uint_fast8_t wheel_cascade(
+    uint_fast8_t                level,
+    uint_fast8_t                index)
+{
+    struct nc_timer *           timer;
+
+    timer = g_wheel.slot[level][index];
+    g_wheel.slot[level][index] = NULL;
+
+    while (timer != NULL) {
+        struct nc_timer *       next;
+
+        next = timer->next;
+        wheel_insert(timer);
+        timer = next;
+    }
+
+    return (index);
+}
+
+
+
+static
+nc_tick wheel_next_event(void)
+{
+    nc_tick                     next;
+    nc_tick                     index;
+    uint_fast8_t                level;
+
+    next  = NC_TIMER_INFINITE;
+    index = WHEEL_INDEX(g_wheel.base, 0u);
+
+    for (nc_tick offset = 0u; offset < WHEEL_SLOTS; offset++) {
+        if (g_wheel.slot[0][(index + offset) & WHEEL_MASK] != NULL) {
+            next = offset;
+
+            break;
+        }
+    }
+
+    for (level = 1u; level < CONFIG_NC_TIMER_WHEEL_LEVELS; level++) {
+        nc_tick                 current;
+        nc_tick                 first;
+
+        current = g_wheel.base >> (level * CONFIG_NC_TIMER_WHEEL_BITS);
+                                    /* When base is at the level boundary the */
+                                    /* current slot is not cascaded yet.      */
+        first   = ((current << (level * CONFIG_NC_TIMER_WHEEL_BITS)) ==
+            g_wheel.base) ? 0u : 1u;
+
+        for (nc_tick offset = first; offset < (first + WHEEL_SLOTS); offset++) {
+            nc_tick             cascade;
+
+            cascade = ((current + offset) << (level * CONFIG_NC_TIMER_WHEEL_BITS))
+                - g_wheel.base;
+
+            if (cascade >= next) {        /* Further slots are even later */
+                break;
+            }
+
+            if (g_wheel.slot[level][(current + offset) & WHEEL_MASK] != NULL) {
+                next = cascade;
+
+                break;
+            }
+        }
+    }
+
+    return (next);
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_timer_init(
+    nc_timer *                  timer)
+{
+    timer->next   = NULL;
+    timer->pprev  = NULL;
+    timer->thread = NULL;
+}
+
+
+
+void nc_timer_start(
+    nc_timer *                  timer,
+    nc_thread *                 thread,
+    nc_tick                     ticks,
+    nc_tick                     period)
+{
+    nc_isr_lock                 isr_context;
+
+    if (ticks == 0u) {
+        ticks = 1u;
+    }
+    wheel_lock(&isr_context);
+
+    if (timer->pprev != NULL) {                      /* Restart the timer */
+        wheel_remove(timer);
+    }
+    timer->thread  = thread;
+    timer->expires = g_wheel.base + ticks - 1u;
+    timer->period  = period;
+    wheel_insert(timer);
+    wheel_unlock(&isr_context);
+}
+
+
+
+void nc_timer_cancel(
+    nc_timer *                  timer)
+{
+    nc_isr_lock                 isr_context;
+
+    wheel_lock(&isr_context);
+
+    if (timer->pprev != NULL) {
+        wheel_remove(timer);
+    }
+    wheel_unlock(&isr_context);
+}
+
+
+
+bool nc_timer_is_pending(
+    const nc_timer *            timer)
+{
+    return (timer->pprev != NULL);
+}
+
+
+
+void nc_timer_tick(void)
+{
+    nc_isr_lock                 isr_context;
+    struct nc_timer *           expired;
+    uint_fast8_t                index;
+
+    wheel_lock(&isr_context);
+    index = WHEEL_INDEX(g_wheel.base, 0u);
+
+    if (index == 0u) {            /* Level 0 wrapped, cascade higher levels */
+        uint_fast8_t            level;
+
+        level = 1u;
+
+        while ((level < CONFIG_NC_TIMER_WHEEL_LEVELS) &&
+               (wheel_cascade(level, WHEEL_INDEX(g_wheel.base, level)) == 0u)) {
+            level++;
+        }
+    }
+    g_wheel.base++;
+    expired = g_wheel.slot[0][index];    /* Detach the slot so periodic     */
+    g_wheel.slot[0][index] = NULL;       /* timers can be inserted into it. */
+
+    if (expired != NULL) {
+        expired->pprev = &expired;
+    }
+
+    while (expired != NULL) {                 /* Expire all timers in slot */
+        struct nc_timer *       timer;
+        nc_thread *             thread;
+
+        timer = expired;
+        wheel_remove(timer);
+
+        if (timer->period != 0u) {
+            timer->expires += timer->period;
+            wheel_insert(timer);
+        }
+        thread = timer->thread;
+        wheel_unlock(&isr_context);     /* Making a thread ready may cancel */
+        nc_thread_ready(thread);        /* its delay timer.                 */
+        wheel_lock(&isr_context);
+    }
+    wheel_unlock(&isr_context);
+}
+
+
+
+nc_tick nc_timer_get_ticks(void)
+{
+    return (g_wheel.base);
+}
+
+
+
+nc_tick nc_timer_idle_ticks(void)
+{
+    nc_isr_lock                 isr_context;
+    nc_tick                     ticks;
+
+    wheel_lock(&isr_context);
+    ticks = wheel_next_event();
+    wheel_unlock(&isr_context);
+
+    if (ticks != NC_TIMER_INFINITE) {
+        ticks++;                  /* Offset 0 is processed by the next tick */
+    }
+
+    return (ticks);
+}
+
+
+
+void nc_timer_advance(
+    nc_tick                     ticks)
+{
+    while (ticks != 0u) {
+        nc_isr_lock             isr_context;
+        nc_tick                 skip;
+
+        wheel_lock(&isr_context);
+        skip = wheel_next_event();
+
+        if (skip >= ticks) {          /* Nothing happens in this interval */
+            g_wheel.base += ticks;
+            wheel_unlock(&isr_context);
+
+            break;
+        }
+        g_wheel.base += skip;        /* Skip empty ticks, then process the */
+        wheel_unlock(&isr_context);  /* tick which has some work.          */
+        nc_timer_tick();
+        ticks -= skip + 1u;
+    }
+}
+
+#endif /* (CONFIG_NC_TIMER == 1) */
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_timer.c
+ ******************************************************************************/
@@ -0,0 +1,212 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Timer header
+ * @defgroup    timer Timer
+ * @brief       Software timers
+ * @details     Timers are kept in a hierarchical timing wheel which is driven
+ *              by nc_timer_tick(). Starting, cancelling and expiring a timer
+ *              are constant time operations and pending timers cost nothing
+ *              until they expire. On expiry a timer makes its thread ready.
+ ********************************************************************//** @{ */
+
+#ifndef NC_TIMER_H
+#define NC_TIMER_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nanocoop.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Maximum number of ticks a timer can wait in one run
+ * @details     Timers with longer timeouts are parked in the last wheel level
+ *              and are cascaded down until they expire.
+ */
+#define NC_TIMER_MAX_TICKS                                                  \
+    (((nc_tick)1u << (CONFIG_NC_TIMER_WHEEL_BITS *                          \
+        CONFIG_NC_TIMER_WHEEL_LEVELS)) - 1u)
+
+/**@brief       Returned by nc_timer_idle_ticks() when no timer is pending
+ */
+#define NC_TIMER_INFINITE               ((nc_tick)~(nc_tick)0)
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Timer structure
+ * @details     Timer structures are allocated by the application. A timer
+ *              which is statically allocated does not need initialization,
+ *              others must be initialized by nc_timer_init() before use.
+ *              Members of this structure are private.
+ */
+struct nc_timer
+{
+    struct nc_timer *           next;
+    struct nc_timer **          pprev;      /**<@brief NULL when not pending */
+    nc_thread *                 thread;
+    nc_tick                     expires;
+    nc_tick                     period;
+};
+
+/**@brief       Timer type
+ */
+typedef struct nc_timer nc_timer;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Initialize a timer structure
+ * @param       timer
+ *              Pointer to timer structure.
+ */
+void            nc_timer_init(
+    nc_timer *                  timer);
+
+
+
+/**@brief       Start a timer
+ * @param       timer
+ *              Pointer to timer structure. If the timer is already pending it
+ *              is restarted.
+ * @param       thread
+ *              Thread which is made ready when the timer expires.
+ * @param       ticks
+ *              Number of ticks until the timer expires. Value 0 is treated as
+ *              1, so the timer expires on the next tick.
+ * @param       period
+ *              Number of ticks between following expiries. Use 0 for one-shot
+ *              timers.
+ */
+void            nc_timer_start(
+    nc_timer *                  timer,
+    nc_thread *                 thread,
+    nc_tick                     ticks,
+    nc_tick                     period);
+
+
+
+/**@brief       Cancel a timer
+ * @param       timer
+ *              Pointer to timer structure. Cancelling a timer which is not
+ *              pending has no effect.
+ */
+void            nc_timer_cancel(
+    nc_timer *                  timer);
+
+
+
+/**@brief       Is a timer pending?
+ * @param       timer
+ *              Pointer to timer structure.
+ */
+bool            nc_timer_is_pending(
+    const nc_timer *            timer);
+
+
+
+/**@brief       Advance timers by one tick
+ * @details     This function is usually called from a periodic interrupt. All
+ *              timers which expire on this tick make their threads ready.
+ */
+void            nc_timer_tick(void);
+
+
+
+/**@brief       Advance timers by a number of ticks at once
+ * @param       ticks
+ *              Number of ticks which have elapsed.
+ * @details     Used after the system was sleeping for several ticks. Empty
+ *              ticks are skipped, so the cost depends only on the number of
+ *              timers which expire and not on the number of ticks.
+ */
+void            nc_timer_advance(
+    nc_tick                     ticks);
+
+
+
+/**@brief       Get the number of ticks since start
+ */
+nc_tick         nc_timer_get_ticks(void);
+
+
+
+/**@brief       Get the number of ticks until the timers have some work
+ * @return      Number of ticks after which a timer may expire. The system may
+ *              sleep one tick less than returned without missing a timer.
+ * @retval      NC_TIMER_INFINITE - no timer is pending
+ * @details     This is used by tickless idle to decide how long to sleep. The
+ *              returned value may be shorter than the actual expiry when a
+ *              long timer needs to be cascaded first.
+ */
+nc_tick         nc_timer_idle_ticks(void);
+
+
+
+/**@brief       Block the current thread for a number of ticks
+ * @param       ticks
+ *              Number of ticks after which the thread is made ready again.
+ * @details     The thread must return after this call. It is dispatched again
+ *              when the delay expires. When the thread is made ready earlier
+ *              by other means, for example by a semaphore or a queue, the
+ *              delay is cancelled and it does not make the thread ready later.
+ *              Use nc_thread_delay_left() to find out whether the delay has
+ *              expired.
+ */
+void            nc_thread_delay(
+    nc_tick                     ticks);
+
+
+
+/**@brief       Get the number of ticks left of the last delay of the current
+ *              thread
+ * @return      Number of ticks until the delay would have expired, 0 when
+ *              the delay has expired.
+ * @details     A thread which is made ready before its delay expired may
+ *              delay again for the returned number of ticks.
+ */
+nc_tick         nc_thread_delay_left(void);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if ((CONFIG_NC_TIMER_WHEEL_BITS * CONFIG_NC_TIMER_WHEEL_LEVELS) > 31)
+# error "nanocoop: CONFIG_NC_TIMER_WHEEL_BITS and CONFIG_NC_TIMER_WHEEL_LEVELS are out of range, the wheel must cover less than 2^31 ticks."
+#endif
+
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_timer.h
+ *****************************************************************************/
+#endif /* NC_TIMER_H */
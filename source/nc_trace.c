@@ -0,0 +1,134 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Trace recorder Implementation
+ * @addtogroup  trace
+ ********************************************************************//** @{ */
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include "nc_trace.h"
+#include "nc_config.h"
+#include "nc_port.h"
+
+#if (CONFIG_NC_TRACE == 1)
+/*========================================================  LOCAL MACRO's  ==*/
+/*=====================================================  LOCAL DATA TYPES  ==*/
+/*============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Claim the next record sequence number
+ */
+static inline
+uint32_t trace_claim(void);
+
+/*======================================================  LOCAL VARIABLES  ==*/
+
+/**@brief       Trace buffer
+ * @details     The header is initialized statically, so the recording works
+ *              from the first scheduler call even when nc_trace_init() is not
+ *              called.
+ */
+static nc_trace_buffer          g_trace =
+{
+    NC_TRACE_MAGIC,
+    NC_TRACE_VERSION,
+    sizeof(struct nc_trace_record),
+    CONFIG_NC_TRACE_SIZE,
+    0u,
+    0u,
+    {{0u, 0u, 0u, 0u, 0u, 0u}}
+};
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*===========================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+uint32_t trace_claim(void)
+{
+#if defined(NCPU_ATOMIC)
+    return (nc_atomic_u32_fetch_add(&g_trace.head, 1u));
+#else
+    nc_isr_lock                 isr_context;
+    uint32_t                    sequence;
+
+    nc_isr_lock_save(&isr_context);
+    sequence = g_trace.head++;
+    nc_isr_unlock(&isr_context);
+
+    return (sequence);
+#endif
+}
+
+/*==================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*===================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+void nc_trace_init(
+    uint64_t                    clock_hz)
+{
+    g_trace.clock_hz = clock_hz;
+    g_trace.head     = 0u;
+}
+
+
+
+void nc_trace_write(
+    nc_trace_event              event,
+    uint32_t                    thread,
+    uint_fast8_t                priority,
+    uint_fast8_t                state)
+{
+    struct nc_trace_record *    record;
+
+    record = &g_trace.records[trace_claim() & (CONFIG_NC_TRACE_SIZE - 1u)];
+    record->timestamp = nc_cpu_cycles();
+    record->thread    = thread;
+    record->event     = (uint8_t)event;
+    record->priority  = (uint8_t)priority;
+#if (CONFIG_NC_NUM_OF_CORES > 1)
+    record->core      = (uint8_t)nc_cpu_id();
+#else
+    record->core      = 0u;
+#endif
+    record->state     = (uint8_t)state;
+}
+
+
+
+const nc_trace_buffer * nc_trace_get_buffer(void)
+{
+    return (&g_trace);
+}
+
+#endif /* (CONFIG_NC_TRACE == 1) */
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_TRACE == 1) && !defined(NCPU_PROFILE)
+# error "nanocoop: CONFIG_NC_TRACE is enabled, but the port does not provide a cycle counter."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of nc_trace.c
+ ******************************************************************************/
@@ -0,0 +1,170 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Trace recorder header
+ * @defgroup    trace Trace recorder
+ * @brief       Binary scheduler trace recorder
+ * @details     The scheduler writes fixed size binary records into a static
+ *              ring buffer. When the buffer is full the oldest records are
+ *              overwritten. The buffer is dumped as it is, for example by
+ *              writing the memory returned by nc_trace_get_buffer() into a
+ *              file or by reading it with a debugger, and it is converted on
+ *              the host by `tools/nc_trace2chrome.py` into Chrome trace JSON.
+ ********************************************************************//** @{ */
+
+#ifndef NC_TRACE_H
+#define NC_TRACE_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdint.h>
+
+#include "nc_config.h"
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Trace buffer magic number, "NCTR" in little endian
+ */
+#define NC_TRACE_MAGIC                  0x5254434eu
+
+/**@brief       Trace buffer format version
+ */
+#define NC_TRACE_VERSION                1u
+
+/*-----------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================  DATA TYPES  ==*/
+
+/**@brief       Trace event identifiers
+ */
+enum nc_trace_event
+{
+    NC_TRACE_DISPATCH_BEGIN = 1,            /**<@brief Thread starts running */
+    NC_TRACE_DISPATCH_END,                  /**<@brief Thread has returned   */
+    NC_TRACE_READY,                         /**<@brief Thread is made ready  */
+    NC_TRACE_BLOCK,                         /**<@brief Thread is blocked     */
+    NC_TRACE_CREATE,                        /**<@brief Thread is created     */
+    NC_TRACE_DESTROY                        /**<@brief Thread is destroyed   */
+};
+
+/**@brief       Trace event identifier type
+ */
+typedef enum nc_trace_event nc_trace_event;
+
+/**@brief       Trace record
+ * @details     Records have fixed size of 16 bytes and are stored in the CPU
+ *              native byte order.
+ */
+struct nc_trace_record
+{
+    uint64_t                    timestamp;  /**<@brief Port cycle counter    */
+    uint32_t                    thread;     /**<@brief Thread identifier     */
+    uint8_t                     event;      /**<@brief See nc_trace_event    */
+    uint8_t                     priority;   /**<@brief Thread priority       */
+    uint8_t                     core;       /**<@brief Scheduler core        */
+    uint8_t                     state;      /**<@brief Thread state after    */
+};
+
+/**@brief       Trace record type
+ */
+typedef struct nc_trace_record nc_trace_record;
+
+/**@brief       Trace buffer
+ * @details     The layout of this structure is the dump file format. Record
+ *              with sequence number `n` is stored at index
+ *              `n % capacity`. When `head` is greater than `capacity` the
+ *              oldest `head - capacity` records were overwritten.
+ */
+struct nc_trace_buffer
+{
+    uint32_t                    magic;      /**<@brief NC_TRACE_MAGIC        */
+    uint16_t                    version;    /**<@brief NC_TRACE_VERSION      */
+    uint16_t                    record_size;/**<@brief Size of one record    */
+    uint32_t                    capacity;   /**<@brief Number of records     */
+    volatile uint32_t           head;       /**<@brief Records written       */
+    uint64_t                    clock_hz;   /**<@brief Timestamp frequency   */
+    struct nc_trace_record      records[CONFIG_NC_TRACE_SIZE];
+};
+
+/**@brief       Trace buffer type
+ */
+typedef struct nc_trace_buffer nc_trace_buffer;
+
+/*=====================================================  GLOBAL VARIABLES  ==*/
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Set the timestamp frequency and start recording from empty
+ *              buffer
+ * @param       clock_hz
+ *              Frequency of the port cycle counter in Hz. It is stored in the
+ *              buffer header and used by the converter. Use 0 if it is not
+ *              known, the converter then needs it as an argument.
+ */
+void            nc_trace_init(
+    uint64_t                    clock_hz);
+
+
+
+/**@brief       Write a trace record
+ * @param       event
+ *              Event identifier.
+ * @param       thread
+ *              Thread identifier.
+ * @param       priority
+ *              Thread priority.
+ * @param       state
+ *              Thread state after the event.
+ * @details     The record slot is claimed by a single atomic increment, no
+ *              lock is taken. This function is called by the scheduler.
+ */
+void            nc_trace_write(
+    nc_trace_event              event,
+    uint32_t                    thread,
+    uint_fast8_t                priority,
+    uint_fast8_t                state);
+
+
+
+/**@brief       Get the trace buffer for dumping
+ */
+const nc_trace_buffer * nc_trace_get_buffer(void);
+
+/*-------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if ((CONFIG_NC_TRACE_SIZE & (CONFIG_NC_TRACE_SIZE - 1)) != 0)
+# error "nanocoop: CONFIG_NC_TRACE_SIZE must be a power of 2."
+#endif
+
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_trace.h
+ *****************************************************************************/
+#endif /* NC_TRACE_H */
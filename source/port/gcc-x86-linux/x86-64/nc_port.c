@@ -0,0 +1,350 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Port Implementation
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stddef.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nc_port.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+/**@brief       Maximum number of events returned by one epoll_wait() call
+ */
+#define IO_MAX_EVENTS                   64u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+
+/**@brief       Convert nanosecond timeout to epoll_wait() milliseconds
+ */
+static inline
+int io_timeout_ms(
+    uint64_t                    timeout_ns);
+
+
+
+/**@brief       Convert epoll event bits to NCPU_IO_* bits
+ */
+static inline
+uint32_t io_events(
+    uint32_t                    epoll_events);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+/**@brief       Futex word, incremented on each wake-up
+ */
+static uint32_t                 g_idle_sequence;
+
+/**@brief       Number of OS threads sleeping on the futex
+ */
+static uint32_t                 g_idle_sleepers;
+
+/**@brief       Event poller used by nc_cpu_io_wait(), -1 when not created
+ */
+static int                      g_io_poll = -1;
+
+/**@brief       Event counter written by nc_cpu_idle_wake() to wake the poller
+ */
+static int                      g_io_wake = -1;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+
+__thread uint_fast8_t           g_cpu_id;
+
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+
+static inline
+int io_timeout_ms(
+    uint64_t                    timeout_ns)
+{
+    uint64_t                    timeout_ms;
+
+    if (timeout_ns == NCPU_IDLE_INFINITE) {
+        return (-1);
+    }
+    timeout_ms = (timeout_ns + 999999u) / 1000000u;  /* Never wake up early */
+
+    return (timeout_ms < (uint64_t)INT_MAX ? (int)timeout_ms : INT_MAX);
+}
+
+
+
+static inline
+uint32_t io_events(
+    uint32_t                    epoll_events)
+{
+    uint32_t                    events;
+
+    events = 0u;
+
+    if ((epoll_events & EPOLLIN) != 0u) {
+        events |= NCPU_IO_READ;
+    }
+
+    if ((epoll_events & EPOLLOUT) != 0u) {
+        events |= NCPU_IO_WRITE;
+    }
+
+    if ((epoll_events & (EPOLLHUP | EPOLLRDHUP)) != 0u) {
+        events |= NCPU_IO_HANGUP;
+    }
+
+    if ((epoll_events & EPOLLERR) != 0u) {
+        events |= NCPU_IO_ERROR;
+    }
+
+    return (events);
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+
+uint64_t nc_cpu_time_ns(void)
+{
+    struct timespec             time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return ((uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec);
+}
+
+
+
+uint32_t nc_cpu_idle_prepare(void)
+{
+    return (__atomic_load_n(&g_idle_sequence, __ATOMIC_SEQ_CST));
+}
+
+
+
+void nc_cpu_idle_sleep(
+    uint32_t                    token,
+    uint64_t                    timeout_ns)
+{
+    struct timespec             timeout;
+    struct timespec *           p_timeout;
+
+    p_timeout = NULL;
+
+    if (timeout_ns != NCPU_IDLE_INFINITE) {
+        timeout.tv_sec  = (time_t)(timeout_ns / 1000000000u);
+        timeout.tv_nsec = (long)(timeout_ns % 1000000000u);
+        p_timeout       = &timeout;
+    }
+    __atomic_add_fetch(&g_idle_sleepers, 1u, __ATOMIC_SEQ_CST);
+                            /* Returns immediately if the sequence was changed */
+    syscall(SYS_futex, &g_idle_sequence, FUTEX_WAIT_PRIVATE, token, p_timeout,
+        NULL, 0);
+    __atomic_sub_fetch(&g_idle_sleepers, 1u, __ATOMIC_SEQ_CST);
+}
+
+
+
+void nc_cpu_idle_wake(void)
+{
+    __atomic_add_fetch(&g_idle_sequence, 1u, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&g_idle_sleepers, __ATOMIC_SEQ_CST) != 0u) {
+        syscall(SYS_futex, &g_idle_sequence, FUTEX_WAKE_PRIVATE, INT_MAX, NULL,
+            NULL, 0);
+
+        if (g_io_wake != -1) {               /* Some may sleep in the poller */
+            eventfd_write(g_io_wake, 1u);
+        }
+    }
+}
+
+
+
+bool nc_cpu_io_init(void)
+{
+    struct epoll_event          event;
+    int                         poll;
+    int                         wake;
+
+    if (g_io_poll != -1) {
+        return (true);
+    }
+    poll = epoll_create1(EPOLL_CLOEXEC);
+    wake = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+                          /* The counter is level triggered, so all sleepers */
+    event.events   = EPOLLIN;           /* see it until the last one drains it */
+    event.data.ptr = &g_io_wake;
+
+    if ((poll == -1) || (wake == -1) ||
+        (epoll_ctl(poll, EPOLL_CTL_ADD, wake, &event) == -1)) {
+
+        if (poll != -1) {
+            close(poll);
+        }
+
+        if (wake != -1) {
+            close(wake);
+        }
+
+        return (false);
+    }
+    g_io_wake = wake;
+    __atomic_store_n(&g_io_poll, poll, __ATOMIC_RELEASE);
+
+    return (true);
+}
+
+
+
+bool nc_cpu_io_arm(
+    int                         fd,
+    uint32_t                    events,
+    void *                      tag)
+{
+    struct epoll_event          event;
+
+    event.events   = EPOLLONESHOT | EPOLLRDHUP;
+    event.data.ptr = tag;
+
+    if ((events & NCPU_IO_READ) != 0u) {
+        event.events |= EPOLLIN;
+    }
+
+    if ((events & NCPU_IO_WRITE) != 0u) {
+        event.events |= EPOLLOUT;
+    }
+                                /* A disarmed descriptor stays registered */
+    if (epoll_ctl(g_io_poll, EPOLL_CTL_MOD, fd, &event) == 0) {
+        return (true);
+    }
+
+    return ((errno == ENOENT) &&
+        (epoll_ctl(g_io_poll, EPOLL_CTL_ADD, fd, &event) == 0));
+}
+
+
+
+void nc_cpu_io_disarm(
+    int                         fd)
+{
+    epoll_ctl(g_io_poll, EPOLL_CTL_DEL, fd, NULL);
+}
+
+
+
+size_t nc_cpu_io_wait(
+    uint32_t                    token,
+    uint64_t                    timeout_ns,
+    struct nc_cpu_io_event *    events,
+    size_t                      size)
+{
+    struct epoll_event          ready[IO_MAX_EVENTS];
+    int                         timeout_ms;
+    int                         count;
+    size_t                      returned;
+    bool                        is_sleeping;
+
+    if (__atomic_load_n(&g_io_poll, __ATOMIC_ACQUIRE) == -1) {
+
+        if (timeout_ns != 0u) {
+            nc_cpu_idle_sleep(token, timeout_ns);
+        }
+
+        return (0u);
+    }
+    timeout_ms  = io_timeout_ms(timeout_ns);
+    is_sleeping = timeout_ms != 0;
+
+    if (is_sleeping) {
+        __atomic_add_fetch(&g_idle_sleepers, 1u, __ATOMIC_SEQ_CST);
+
+        if (__atomic_load_n(&g_idle_sequence, __ATOMIC_SEQ_CST) != token) {
+            timeout_ms = 0;                   /* A wake-up is already pending */
+        }
+    }
+
+    if (size > IO_MAX_EVENTS) {
+        size = IO_MAX_EVENTS;
+    }
+    count = epoll_wait(g_io_poll, ready, (int)size, timeout_ms);
+
+    if (is_sleeping &&
+        (__atomic_sub_fetch(&g_idle_sleepers, 1u, __ATOMIC_SEQ_CST) == 0u)) {
+        eventfd_t               value;
+
+        eventfd_read(g_io_wake, &value);
+    }
+    returned = 0u;
+
+    for (int itr = 0; itr < count; itr++) {
+
+        if (ready[itr].data.ptr != &g_io_wake) {
+            events[returned].tag    = ready[itr].data.ptr;
+            events[returned].events = io_events(ready[itr].events);
+            returned++;
+        }
+    }
+
+    return (returned);
+}
+
+
+
+void * nc_cpu_page_alloc(
+    size_t                      size)
+{
+    void *                      mem;
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+        -1, 0);
+
+    return (mem != MAP_FAILED ? mem : NULL);
+}
+
+
+
+void nc_cpu_page_free(
+    void *                      mem,
+    size_t                      size)
+{
+    munmap(mem, size);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of nc_port.c
+ ******************************************************************************/
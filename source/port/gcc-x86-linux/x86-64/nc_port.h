@@ -0,0 +1,421 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Port header for x86-64 Linux hosts
+ * @details     Unlike the x32 host port this port uses the native 64-bit
+ *              register width. A single bitmap word covers up to 64 priority
+ *              levels. Bit-scan is done by `__builtin_clzll()` which compiles
+ *              to LZCNT when the target supports it (`-mlzcnt`) or to BSR
+ *              otherwise, so no lookup tables are needed.
+ *********************************************************************//** @{ */
+
+#ifndef NC_PORT_H
+#define NC_PORT_H
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*===============================================================  MACRO's  ==*/
+
+#define NCPU_DATA_WIDTH                 64
+
+#define NCPU_DATA_REG_MAX               UINT64_MAX
+
+/**@brief       This port supports multiple scheduler cores
+ */
+#define NCPU_SMP                        1
+
+/**@brief       Storage class of variables which are local to an OS thread
+ */
+#define NCPU_THREAD_LOCAL               __thread
+
+/**@brief       This port supports atomic pointer and counter operations
+ */
+#define NCPU_ATOMIC                     1
+
+/**@brief       This port supports sleeping when scheduler is idle
+ */
+#define NCPU_IDLE                       1
+
+/**@brief       Sleep timeout which never expires
+ */
+#define NCPU_IDLE_INFINITE              UINT64_MAX
+
+/**@brief       This port provides a cycle counter for profiling
+ */
+#define NCPU_PROFILE                    1
+
+/**@brief       This port provides monotonic time, see nc_cpu_time_ns()
+ */
+#define NCPU_TIME                       1
+
+/**@brief       This port provides memory pages for the slab allocator
+ */
+#define NCPU_PAGE                       1
+
+/**@brief       Size of memory page
+ */
+#define NCPU_PAGE_SIZE                  4096u
+
+/**@brief       This port can wait for file descriptor events when idle
+ */
+#define NCPU_IO                         1
+
+/**@brief       File descriptor event bits
+ * @{ */
+#define NCPU_IO_READ                    0x1u
+#define NCPU_IO_WRITE                   0x2u
+#define NCPU_IO_HANGUP                  0x4u
+#define NCPU_IO_ERROR                   0x8u
+/**@} */
+
+/*------------------------------------------------------  C++ extern begin  --*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================  DATA TYPES  ==*/
+
+typedef uint64_t                nc_isr_lock;
+
+typedef uint64_t                nc_cpu_reg;
+
+typedef uint32_t                nc_spinlock;
+
+/**@brief       File descriptor event returned by nc_cpu_io_wait()
+ */
+struct nc_cpu_io_event
+{
+    void *                      tag;        /**<@brief Tag given when armed  */
+    uint32_t                    events;     /**<@brief NCPU_IO_* bits        */
+};
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+
+/**@brief       Scheduler core of the calling OS thread
+ */
+extern __thread uint_fast8_t    g_cpu_id;
+
+/*===================================================  FUNCTION PROTOTYPES  ==*/
+
+
+static inline void nc_isr_lock_save(
+    nc_isr_lock *               lock)
+{
+    /* There are no interrupts on a host. When more scheduler cores are
+     * used the scheduler protects its data with spin locks.
+     */
+    (void)lock;
+}
+
+
+
+static inline void nc_isr_unlock(
+    nc_isr_lock *               lock)
+{
+    (void)lock;
+}
+
+
+
+static inline nc_cpu_reg nc_exp2(
+    uint_fast8_t                value)
+{
+    return ((nc_cpu_reg)1u << value);
+}
+
+
+
+static inline uint_fast8_t nc_log2(
+    nc_cpu_reg                  value)
+{
+    /* NOTE: The result is undefined for value == 0, scheduler never asks for
+     *       log2 of an empty bitmap word.
+     */
+    return ((uint_fast8_t)(63u - (uint_fast8_t)__builtin_clzll(value)));
+}
+
+
+
+static inline void nc_spin_lock(
+    nc_spinlock *               lock)
+{
+    while (__atomic_exchange_n(lock, 1u, __ATOMIC_ACQUIRE) != 0u) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED) != 0u) {
+            __builtin_ia32_pause();
+        }
+    }
+}
+
+
+
+static inline void nc_spin_unlock(
+    nc_spinlock *               lock)
+{
+    __atomic_store_n(lock, 0u, __ATOMIC_RELEASE);
+}
+
+
+
+static inline void * nc_atomic_ptr_load(
+    void * volatile *           ptr)
+{
+    return (__atomic_load_n(ptr, __ATOMIC_ACQUIRE));
+}
+
+
+
+static inline void nc_atomic_ptr_store(
+    void * volatile *           ptr,
+    void *                      value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+
+
+static inline bool nc_atomic_ptr_cas(
+    void * volatile *           ptr,
+    void *                      expected,
+    void *                      desired)
+{
+    return (__atomic_compare_exchange_n(ptr, &expected, desired, false,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+
+
+static inline void * nc_atomic_ptr_swap(
+    void * volatile *           ptr,
+    void *                      value)
+{
+    return (__atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL));
+}
+
+
+
+static inline uint32_t nc_atomic_u32_fetch_add(
+    uint32_t volatile *         value,
+    uint32_t                    increment)
+{
+    return (__atomic_fetch_add(value, increment, __ATOMIC_RELAXED));
+}
+
+
+
+static inline uint32_t nc_atomic_u32_load(
+    uint32_t volatile *         value)
+{
+    return (__atomic_load_n(value, __ATOMIC_ACQUIRE));
+}
+
+
+
+static inline void nc_atomic_u32_store(
+    uint32_t volatile *         value,
+    uint32_t                    new_value)
+{
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+
+
+
+static inline bool nc_atomic_u32_cas(
+    uint32_t volatile *         value,
+    uint32_t                    expected,
+    uint32_t                    desired)
+{
+    return (__atomic_compare_exchange_n(value, &expected, desired, false,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+
+
+static inline uint_fast8_t nc_cpu_id(void)
+{
+    return (g_cpu_id);
+}
+
+
+
+static inline void nc_cpu_id_set(
+    uint_fast8_t                id)
+{
+    g_cpu_id = id;
+}
+
+
+
+/**@brief       Read the CPU time stamp counter
+ */
+static inline uint64_t nc_cpu_cycles(void)
+{
+    return (__builtin_ia32_rdtsc());
+}
+
+
+
+static inline void nc_sat_increment(
+    nc_cpu_reg *                value)
+{
+    if (*value != NCPU_DATA_REG_MAX) {
+        (*value)++;
+    }
+}
+
+
+
+static inline void nc_sat_decrement(
+    nc_cpu_reg *                value)
+{
+    if (*value != 0u) {
+        (*value)--;
+    }
+}
+
+
+
+/**@brief       Get monotonic time in nanoseconds
+ */
+uint64_t        nc_cpu_time_ns(void);
+
+
+
+/**@brief       Prepare for idle sleep
+ * @return      Token which must be passed to nc_cpu_idle_sleep()
+ * @details     Call this before checking if there is any work. A wake-up
+ *              which arrives after this call is not lost.
+ */
+uint32_t        nc_cpu_idle_prepare(void);
+
+
+
+/**@brief       Sleep until timeout or until nc_cpu_idle_wake() is called
+ * @param       token
+ *              Value returned by nc_cpu_idle_prepare().
+ * @param       timeout_ns
+ *              Relative timeout in nanoseconds, or NCPU_IDLE_INFINITE.
+ */
+void            nc_cpu_idle_sleep(
+    uint32_t                    token,
+    uint64_t                    timeout_ns);
+
+
+
+/**@brief       Wake all sleeping scheduler cores
+ * @details     Cheap when nobody is sleeping: no system call is made.
+ */
+void            nc_cpu_idle_wake(void);
+
+
+
+/**@brief       Allocate memory pages from the OS
+ * @param       size
+ *              Size in bytes, a multiple of NCPU_PAGE_SIZE.
+ * @return      Page aligned memory or NULL when there is no memory.
+ */
+void *          nc_cpu_page_alloc(
+    size_t                      size);
+
+
+
+/**@brief       Return memory pages to the OS
+ */
+void            nc_cpu_page_free(
+    void *                      mem,
+    size_t                      size);
+
+
+
+/**@brief       Start waiting for file descriptor events when idle
+ * @return      Is the event poller created?
+ * @details     Until this function is called nc_cpu_io_wait() behaves like
+ *              nc_cpu_idle_sleep() and no descriptor can be armed.
+ */
+bool            nc_cpu_io_init(void);
+
+
+
+/**@brief       Arm a file descriptor for one event
+ * @param       fd
+ *              File descriptor.
+ * @param       events
+ *              NCPU_IO_READ and/or NCPU_IO_WRITE bits. Hang-up and error
+ *              events are always reported.
+ * @param       tag
+ *              Pointer returned by nc_cpu_io_wait() together with the events.
+ * @return      Is the descriptor armed?
+ * @details     The descriptor is disarmed when its event is returned, so
+ *              each event is returned to exactly one caller.
+ */
+bool            nc_cpu_io_arm(
+    int                         fd,
+    uint32_t                    events,
+    void *                      tag);
+
+
+
+/**@brief       Disarm a file descriptor
+ */
+void            nc_cpu_io_disarm(
+    int                         fd);
+
+
+
+/**@brief       Sleep like nc_cpu_idle_sleep() and collect file descriptor
+ *              events
+ * @param       token
+ *              Value returned by nc_cpu_idle_prepare().
+ * @param       timeout_ns
+ *              Relative timeout in nanoseconds, or NCPU_IDLE_INFINITE. When
+ *              it is zero the call only polls for pending events.
+ * @param       events
+ *              Buffer for returned events.
+ * @param       size
+ *              Number of elements in the buffer.
+ * @return      Number of returned events.
+ */
+size_t          nc_cpu_io_wait(
+    uint32_t                    token,
+    uint64_t                    timeout_ns,
+    struct nc_cpu_io_event *    events,
+    size_t                      size);
+
+/*--------------------------------------------------------  C++ extern end  --*/
+#ifdef __cplusplus
+}
+#endif
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if !defined(__x86_64__)
+# error "nanocoop: this port is intended for x86-64 targets only."
+#endif
+
+/** @endcond *//**@} *//**@} *//***********************************************
+ * END of nc_port.h
+ ******************************************************************************/
+#endif /* NC_PORT_H */
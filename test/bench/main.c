@@ -0,0 +1,309 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Scheduler benchmark suite
+ * @details     Measures the cost of basic scheduler operations for the
+ *              configuration this file is compiled with. Results are printed
+ *              as CSV records, one metric per line:
+ *
+ *                  port,variant,threads,prio_levels,benchmark,metric,value
+ *
+ *              The header line is printed only when the first argument is
+ *              `-h`, so outputs of several builds can be concatenated.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nanocoop.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#if !defined(BENCH_PORT)
+#define BENCH_PORT                      "unknown"
+#endif
+
+#if !defined(BENCH_VARIANT)
+#define BENCH_VARIANT                   "default"
+#endif
+
+#define CREATE_ITERATIONS               1000000u
+#define READY_ITERATIONS                1000000u
+#define DISPATCH_ITERATIONS             1000000u
+#define LATENCY_SAMPLES                 100000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct dispatch_stack
+{
+    uint32_t                    left;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static uint64_t time_ns(void);
+static void     report(const char * benchmark, const char * metric,
+                    double value);
+static void     empty_fn(void *);
+static void     dispatch_fn(void *);
+static void     latency_fn(void *);
+static int      compare_u64(const void *, const void *);
+static void     bench_create_destroy(void);
+static void     bench_ready_block(void);
+static void     bench_ready_many(void);
+static void     bench_dispatch(void);
+static void     bench_latency(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static uint64_t                 g_latency_end;
+static uint64_t                 g_latency[LATENCY_SAMPLES];
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static uint64_t time_ns(void)
+{
+    struct timespec             now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+}
+
+static void report(const char * benchmark, const char * metric, double value)
+{
+    printf("%s,%s,%u,%u,%s,%s,%.2f\n", BENCH_PORT, BENCH_VARIANT,
+        (unsigned)CONFIG_NC_NUM_OF_THREADS,
+        (unsigned)CONFIG_NC_NUM_OF_PRIO_LEVELS, benchmark, metric, value);
+}
+
+static void empty_fn(void * stack)
+{
+    (void)stack;
+    nc_thread_done();
+}
+
+static void dispatch_fn(void * stack_)
+{
+    struct dispatch_stack * stack = stack_;
+
+    if (--stack->left == 0u) {
+        nc_thread_done();
+    }
+}
+
+static void latency_fn(void * stack)
+{
+    (void)stack;
+    g_latency_end = time_ns();
+    nc_thread_done();
+}
+
+static int compare_u64(const void * a_, const void * b_)
+{
+    const uint64_t *            a = a_;
+    const uint64_t *            b = b_;
+
+    return ((*a > *b) - (*a < *b));
+}
+
+/* Allocate and free one thread descriptor.
+ */
+static void bench_create_destroy(void)
+{
+    uint64_t                    start;
+    uint64_t                    elapsed;
+
+    start = time_ns();
+
+    for (uint32_t itr = 0u; itr < CREATE_ITERATIONS; itr++) {
+        nc_thread *             thread;
+
+        thread = nc_thread_create(empty_fn, NULL, 0u);
+        nc_thread_destroy(thread);
+    }
+    elapsed = time_ns() - start;
+    report("create_destroy", "ns_per_op",
+        (double)elapsed / CREATE_ITERATIONS);
+}
+
+/* Insert a thread into ready list and remove it again.
+ */
+static void bench_ready_block(void)
+{
+    nc_thread *                 thread;
+    uint64_t                    start;
+    uint64_t                    elapsed;
+
+    thread = nc_thread_create(empty_fn, NULL,
+        CONFIG_NC_NUM_OF_PRIO_LEVELS - 1u);
+    start  = time_ns();
+
+    for (uint32_t itr = 0u; itr < READY_ITERATIONS; itr++) {
+        nc_thread_ready(thread);
+        nc_thread_block(thread);
+    }
+    elapsed = time_ns() - start;
+    nc_thread_destroy(thread);
+    report("ready_block", "ns_per_op", (double)elapsed / READY_ITERATIONS);
+}
+
+/* Make all threads of the pool ready and blocked with one call each.
+ */
+static void bench_ready_many(void)
+{
+    static nc_thread *          threads[CONFIG_NC_NUM_OF_THREADS];
+    uint32_t                    rounds;
+    uint64_t                    start;
+    uint64_t                    elapsed;
+
+    rounds = READY_ITERATIONS / CONFIG_NC_NUM_OF_THREADS;
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_thread_create(empty_fn, NULL,
+            (uint_fast8_t)(itr % CONFIG_NC_NUM_OF_PRIO_LEVELS));
+    }
+    start = time_ns();
+
+    for (uint32_t itr = 0u; itr < rounds; itr++) {
+        nc_thread_ready_many(threads, CONFIG_NC_NUM_OF_THREADS);
+        nc_thread_block_many(threads, CONFIG_NC_NUM_OF_THREADS);
+    }
+    elapsed = time_ns() - start;
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    report("ready_block_many", "ns_per_thread",
+        (double)elapsed / ((double)rounds * CONFIG_NC_NUM_OF_THREADS));
+}
+
+/* All threads of the pool are spread over all priority levels and each one is
+ * dispatched the same number of times.
+ */
+static void bench_dispatch(void)
+{
+    static struct dispatch_stack stacks[CONFIG_NC_NUM_OF_THREADS];
+    static nc_thread *          threads[CONFIG_NC_NUM_OF_THREADS];
+    uint32_t                    per_thread;
+    uint64_t                    start;
+    uint64_t                    elapsed;
+
+    per_thread = DISPATCH_ITERATIONS / CONFIG_NC_NUM_OF_THREADS;
+
+    if (per_thread == 0u) {               /* Larger pools than the iterations */
+        per_thread = 1u;
+    }
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        stacks[itr].left = per_thread;
+        threads[itr] = nc_thread_create(dispatch_fn, &stacks[itr],
+            (uint_fast8_t)(itr % CONFIG_NC_NUM_OF_PRIO_LEVELS));
+        nc_thread_ready(threads[itr]);
+    }
+    start   = time_ns();
+    nc_schedule();
+    elapsed = time_ns() - start;
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    report("dispatch", "ns_per_op",
+        (double)elapsed / ((double)per_thread * CONFIG_NC_NUM_OF_THREADS));
+}
+
+/* Time from nc_thread_ready() call until the thread function is entered. The
+ * other threads of the pool are created and left idle.
+ */
+static void bench_latency(void)
+{
+    static nc_thread *          threads[CONFIG_NC_NUM_OF_THREADS];
+    uint64_t                    total;
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_thread_create(latency_fn, NULL,
+            (uint_fast8_t)(itr % CONFIG_NC_NUM_OF_PRIO_LEVELS));
+    }
+    total = 0u;
+
+    for (uint32_t itr = 0u; itr < LATENCY_SAMPLES; itr++) {
+        uint64_t                start;
+
+        start = time_ns();
+        nc_thread_ready(threads[itr % CONFIG_NC_NUM_OF_THREADS]);
+        nc_schedule();
+        g_latency[itr] = g_latency_end - start;
+        total         += g_latency[itr];
+    }
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    qsort(g_latency, LATENCY_SAMPLES, sizeof(g_latency[0]), compare_u64);
+    report("wake_latency", "ns_mean", (double)total / LATENCY_SAMPLES);
+    report("wake_latency", "ns_p50",
+        (double)g_latency[LATENCY_SAMPLES / 2u]);
+    report("wake_latency", "ns_p99",
+        (double)g_latency[LATENCY_SAMPLES - LATENCY_SAMPLES / 100u]);
+    report("wake_latency", "ns_max",
+        (double)g_latency[LATENCY_SAMPLES - 1u]);
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(int argc, char ** argv)
+{
+    if ((argc > 1) && (strcmp(argv[1], "-h") == 0)) {
+        printf("port,variant,threads,prio_levels,benchmark,metric,value\n");
+    }
+    bench_create_destroy();
+    bench_ready_block();
+    bench_ready_many();
+    bench_dispatch();
+    bench_latency();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0)
+# error "bench: the benchmark needs a static thread pool."
+#endif
+
+#if (CONFIG_NC_NUM_OF_CORES != 1)
+# error "bench: the benchmark measures a single scheduler core."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -30,6 +30,7 @@
 #include <stdio.h>
 
 #include "nanocoop.h"
+#include "nc_timer.h"
 
 /*=========================================================  LOCAL MACRO's  ==*/
 
@@ -42,111 +43,88 @@
 
 struct blinky_stack
 {
-    uint32_t counter;
-    uint32_t reload;
     uint8_t  led;
 };
 
 /*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
 
-static void blinky_fn      (void *);
-static void toggle_green_fn(void *);
-static void toggle_red_fn  (void *);
+static void toggle_fn(void *);
 
 /*=======================================================  LOCAL VARIABLES  ==*/
 
-/* Each thread is referenced by using nc_thread structure.
+/* Software timers are statically allocated.
  */
-static nc_thread * g_fast_blinky;
-static nc_thread * g_slow_blinky;
-static nc_thread * g_toggle_green;
-static nc_thread * g_toggle_red;
+static nc_timer g_fast_blinky;
+static nc_timer g_slow_blinky;
 
-static struct blinky_stack g_fast_blinky_stack =
+static struct blinky_stack g_green_stack =
 {
-     FAST_BLINKY_PERIOD,
-     FAST_BLINKY_PERIOD,
      GREEN_LED
 };
 
-static struct blinky_stack g_slow_blinky_stack =
+static struct blinky_stack g_red_stack =
 {
-     SLOW_BLINKY_PERIOD,
-     SLOW_BLINKY_PERIOD,
      RED_LED
 };
 
 /*======================================================  GLOBAL VARIABLES  ==*/
+
+/* Each thread is referenced by using nc_thread pointer. Threads are defined
+ * statically and they are initialized by nc_thread_create_defined() in main().
+ * They are not started here, the timers will make them ready.
+ */
+NC_THREAD_DEFINE(g_toggle_green, toggle_fn, &g_green_stack, 7, false);
+NC_THREAD_DEFINE(g_toggle_red,   toggle_fn, &g_red_stack,   7, false);
+
 /*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
 
-static void blinky_fn(void * stack_)
+static void toggle_fn(void * stack_)
 {
     /* Cast the void pointer to something more appropriate.
      */
     struct blinky_stack * stack = stack_;
 
-    stack->counter--;
-
-    if (stack->counter == 0) {
-        stack->counter = stack->reload;
-
-        switch (stack->led) {
-            case GREEN_LED : {
-                nc_thread_ready(g_toggle_green);
-                break;
-            }
-            case RED_LED : {
-                nc_thread_ready(g_toggle_red);
-                break;
-            }
+    switch (stack->led) {
+        case GREEN_LED : {
+            printf("\n Toggle GREEN led\n");
+            break;
+        }
+        case RED_LED : {
+            printf("\n Toggle RED led\n");
+            break;
         }
     }
-}
-
-static void toggle_green_fn(void * stack)
-{
-    (void)stack;
-    printf("\n Toggle GREEN led\n");
 
     /* This is one shot thread. When it's done doing it's job it will make
-     * himself idle.
+     * himself idle. The timer will make it ready again.
      */
     nc_thread_done();
 }
 
-static void toggle_red_fn(void * stack)
-{
-    (void)stack;
-    printf("\n Toggle RED led\n");
-    nc_thread_done();
-}
-
 /*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
 /*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
 
 int main(void)
 {
-    /* Create four threads.
-     *
-     * Threads g_fast_blinky and g_slow_blinky are implementing counters for
-     * software timers. When the timer finishes each thread will make either
-     * g_toggle_green or g_toggle_red to do the actual job.
+    /* Create all defined threads in one pass. When threads are created they
+     * are in NC_STATE_IDLE state.
      */
-    g_fast_blinky  = nc_thread_create(blinky_fn,       &g_fast_blinky_stack, 1);
-    g_slow_blinky  = nc_thread_create(blinky_fn,       &g_slow_blinky_stack, 1);
-    g_toggle_green = nc_thread_create(toggle_green_fn, NULL,                 7);
-    g_toggle_red   = nc_thread_create(toggle_red_fn,   NULL,                 7);
+    nc_thread_create_defined();
 
-    /* When threads are created they are in NC_STATE_IDLE state. In order to run
-     * them nc_thread_ready() must be called with pointer to thread structure.
+    /* Periodic timers g_fast_blinky and g_slow_blinky will make the threads
+     * ready on each expiry. Pending timers do not consume any CPU time.
      */
-    nc_thread_ready(g_fast_blinky);
-    nc_thread_ready(g_slow_blinky);
+    nc_timer_start(&g_fast_blinky, g_toggle_green, FAST_BLINKY_PERIOD,
+        FAST_BLINKY_PERIOD);
+    nc_timer_start(&g_slow_blinky, g_toggle_red,   SLOW_BLINKY_PERIOD,
+        SLOW_BLINKY_PERIOD);
 
     /* Execute all running threads. Function nc_schedule() must be periodically
-     * called to execute all ready threads.
+     * called to execute all ready threads. Function nc_timer_tick() is usually
+     * called from a periodic timer interrupt, here it is called from the loop.
      */
     while (true) {
+        nc_timer_tick();
         nc_schedule();
     }
 
@@ -167,6 +145,11 @@ void _exit(int code)
 }
 
 /*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_TIMER != 1)
+# error "blinky: the example needs timers, set CONFIG_NC_TIMER to 1."
+#endif
+
 /** @endcond *//** @} *//******************************************************
  * END of main.c
  ******************************************************************************/
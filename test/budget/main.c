@@ -0,0 +1,226 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Scheduling budget tests
+ * @details     Covers the dispatch budget of nc_schedule_for() and
+ *              nc_schedule_one(), their return values, the time budget and
+ *              threads made ready while a budget is used.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_port.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WORKERS                  3u
+#define SPIN_NS                         1000000u
+#define BUDGET_NS                       (3u * SPIN_NS)
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct worker
+{
+    char                        name;
+    uint32_t                    left;       /* Dispatches until done         */
+    uint64_t                    spin_ns;    /* Busy time of each dispatch    */
+    nc_thread *                 thread;
+    nc_thread *                 wake;       /* Made ready on each dispatch   */
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void trace_reset(void);
+static void worker_fn(void *);
+static void workers_create(uint32_t left, uint64_t spin_ns);
+static void workers_destroy(void);
+static void test_empty(void);
+static void test_dispatches(void);
+static void test_time(void);
+static void test_made_ready(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct worker            g_workers[NUM_OF_WORKERS];
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void trace_reset(void)
+{
+    g_trace_size = 0u;
+    g_trace[0]   = '\0';
+}
+
+static void worker_fn(void * stack)
+{
+    struct worker *             worker = stack;
+
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = worker->name;
+    g_trace[g_trace_size]   = '\0';
+
+    if (worker->spin_ns != 0u) {
+        uint64_t                start = nc_cpu_time_ns();
+
+        while ((nc_cpu_time_ns() - start) < worker->spin_ns) {
+            /* Busy work */
+        }
+    }
+
+    if (worker->wake != NULL) {
+        nc_thread_ready(worker->wake);
+    }
+
+    if (--worker->left == 0u) {
+        nc_thread_done();
+    }
+}
+
+static void workers_create(uint32_t left, uint64_t spin_ns)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        struct worker *         worker = &g_workers[itr];
+
+        worker->name    = (char)('a' + itr);
+        worker->left    = left;
+        worker->spin_ns = spin_ns;
+        worker->wake    = NULL;
+        worker->thread  = nc_thread_create(worker_fn, worker, 1u);
+        TEST_ASSERT(worker->thread != NULL);
+        nc_thread_ready(worker->thread);
+    }
+    trace_reset();
+}
+
+static void workers_destroy(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        nc_thread_destroy(g_workers[itr].thread);
+    }
+}
+
+static void test_empty(void)
+{
+    trace_reset();
+    TEST_ASSERT(!nc_schedule_for(10u, 0u));
+    TEST_ASSERT(!nc_schedule_for(0u, BUDGET_NS));
+    TEST_ASSERT(!nc_schedule_one());
+    TEST_ASSERT(g_trace_size == 0u);
+    printf("budget: nothing ready ok\n");
+}
+
+/* Each call stops after the given number of dispatches and tells whether
+ * threads are still ready, the last call drains the ready threads.
+ */
+static void test_dispatches(void)
+{
+    workers_create(4u, 0u);
+    TEST_ASSERT(nc_schedule_for(5u, 0u));
+    TEST_ASSERT(strcmp(g_trace, "abcab") == 0);
+    TEST_ASSERT(nc_schedule_one());
+    TEST_ASSERT(strcmp(g_trace, "abcabc") == 0);
+    TEST_ASSERT(nc_schedule_for(5u, 0u));
+    TEST_ASSERT(g_trace_size == 11u);
+    TEST_ASSERT(!nc_schedule_one());       /* Takes the last dispatch */
+    TEST_ASSERT(strcmp(g_trace, "abcabcabcabc") == 0);
+    TEST_ASSERT(!nc_schedule_for(5u, 0u));
+    TEST_ASSERT(g_trace_size == 12u);
+    workers_destroy();
+    printf("budget: dispatches ok\n");
+}
+
+/* The time is checked between dispatches, at least one dispatch is done and
+ * the dispatch budget still applies.
+ */
+static void test_time(void)
+{
+    uint64_t                    start;
+
+    workers_create(100u, SPIN_NS);
+    start = nc_cpu_time_ns();
+    TEST_ASSERT(nc_schedule_for(0u, BUDGET_NS));
+    TEST_ASSERT((g_trace_size >= 1u) && (g_trace_size <= 3u));
+    TEST_ASSERT((nc_cpu_time_ns() - start) >= BUDGET_NS);
+
+    trace_reset();
+    TEST_ASSERT(nc_schedule_for(0u, 1u));
+    TEST_ASSERT(g_trace_size == 1u);
+
+    trace_reset();
+    TEST_ASSERT(nc_schedule_for(2u, 1000u * BUDGET_NS));
+    TEST_ASSERT(g_trace_size == 2u);
+    workers_destroy();
+    printf("budget: time ok\n");
+}
+
+/* A thread made ready by a dispatched thread takes from the same budget.
+ */
+static void test_made_ready(void)
+{
+    static struct worker        urgent = { 'u', 1u, 0u, NULL, NULL };
+
+    workers_create(1u, 0u);
+    urgent.thread = nc_thread_create(worker_fn, &urgent, 2u);
+    TEST_ASSERT(urgent.thread != NULL);
+    g_workers[0].wake = urgent.thread;
+    TEST_ASSERT(nc_schedule_for(2u, 0u));
+    TEST_ASSERT(strcmp(g_trace, "au") == 0);
+    TEST_ASSERT(!nc_schedule_for(2u, 0u));
+    TEST_ASSERT(strcmp(g_trace, "aubc") == 0);
+    nc_thread_destroy(urgent.thread);
+    workers_destroy();
+    printf("budget: threads made ready ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_empty();
+    test_dispatches();
+    test_time();
+    test_made_ready();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if !defined(NCPU_TIME)
+# error "test_budget: the test needs a port with monotonic time."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,311 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Event bus tests
+ * @details     Covers publishing to subscribers in more bitmap words,
+ *              reference counting and freeing of events, topics and
+ *              unsubscribing, overruns of full subscriber queues, detaching
+ *              with pending events, detaching of a subscriber which is not
+ *              attached and blocking of subscribers without events.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanocoop.h"
+#include "nc_bus.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_TOPICS                   3u
+#define NUM_OF_SUBSCRIBERS              70u     /* More than one bitmap word */
+#define MANY_CAPACITY                   2u
+#define NUM_OF_EVENTS                   8u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct test_event
+{
+    nc_event                    header;
+    uint32_t                    frees;
+};
+
+struct subscriber_stack
+{
+    nc_bus_subscriber *         subscriber;
+    nc_thread *                 thread;
+    uint32_t                    runs;
+    uint32_t                    received;
+    uint32_t                    topics;     /* Bit per received topic        */
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void event_free(nc_event *);
+static void events_init(void);
+static void subscriber_fn(void *);
+static void subscriber_start(struct subscriber_stack * stack,
+                nc_bus_subscriber * subscriber);
+static void subscriber_stop(struct subscriber_stack * stack);
+static void test_many(void);
+static void test_topics(void);
+static void test_overruns(void);
+static void test_detach(void);
+static void test_attach_full(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+NC_BUS_DEFINE(g_bus, NUM_OF_TOPICS, NUM_OF_SUBSCRIBERS);
+NC_BUS_DEFINE(g_small_bus, 1u, 2u);
+NC_BUS_SUBSCRIBER_DEFINE(g_first, 8u);
+NC_BUS_SUBSCRIBER_DEFINE(g_second, 8u);
+NC_BUS_SUBSCRIBER_DEFINE(g_short, 4u);
+
+static struct test_event        g_events[NUM_OF_EVENTS];
+static nc_event *               g_queues[NUM_OF_SUBSCRIBERS][MANY_CAPACITY];
+static nc_bus_subscriber        g_many[NUM_OF_SUBSCRIBERS];
+static struct subscriber_stack  g_many_stacks[NUM_OF_SUBSCRIBERS];
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void event_free(nc_event * event)
+{
+    ((struct test_event *)event)->frees++;
+}
+
+static void events_init(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_EVENTS; itr++) {
+        nc_event_init(&g_events[itr].header, event_free);
+        g_events[itr].frees = 0u;
+    }
+}
+
+/* Releases all pending events, then it is blocked by nc_bus_receive().
+ */
+static void subscriber_fn(void * stack_)
+{
+    struct subscriber_stack *   stack = stack_;
+    nc_event *                  event;
+
+    stack->runs++;
+
+    while ((event = nc_bus_receive(stack->subscriber)) != NULL) {
+        stack->received++;
+        stack->topics |= 1u << nc_event_get_topic(event);
+        nc_event_release(event);
+    }
+}
+
+static void subscriber_start(struct subscriber_stack * stack,
+    nc_bus_subscriber * subscriber)
+{
+    stack->subscriber = subscriber;
+    stack->runs       = 0u;
+    stack->received   = 0u;
+    stack->topics     = 0u;
+    stack->thread     = nc_thread_create(subscriber_fn, stack, 1u);
+    TEST_ASSERT(stack->thread != NULL);
+    TEST_ASSERT(nc_bus_attach(&g_bus, subscriber, stack->thread));
+}
+
+static void subscriber_stop(struct subscriber_stack * stack)
+{
+    nc_bus_detach(&g_bus, stack->subscriber);
+    nc_thread_destroy(stack->thread);
+}
+
+/* One event is shared by all subscribers and it is freed once, after the
+ * last release.
+ */
+static void test_many(void)
+{
+    events_init();
+
+    for (uint32_t itr = 0u; itr < NUM_OF_SUBSCRIBERS; itr++) {
+        g_many[itr].queue = g_queues[itr];   /* As the define macro does */
+        g_many[itr].mask  = MANY_CAPACITY - 1u;
+        subscriber_start(&g_many_stacks[itr], &g_many[itr]);
+        nc_bus_subscribe(&g_bus, &g_many[itr], 1u);
+    }
+    TEST_ASSERT(nc_bus_publish(&g_bus, 1u, &g_events[0].header) ==
+        NUM_OF_SUBSCRIBERS);
+    TEST_ASSERT(g_events[0].frees == 0u);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_SUBSCRIBERS; itr++) {
+        TEST_ASSERT(nc_thread_get_state(g_many_stacks[itr].thread) ==
+            NC_STATE_READY);
+    }
+    nc_schedule();
+    TEST_ASSERT(g_events[0].frees == 1u);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_SUBSCRIBERS; itr++) {
+        TEST_ASSERT(g_many_stacks[itr].runs == 1u);
+        TEST_ASSERT(g_many_stacks[itr].received == 1u);
+        TEST_ASSERT(g_many_stacks[itr].topics == 0x2u);
+        TEST_ASSERT(nc_thread_get_state(g_many_stacks[itr].thread) ==
+            NC_STATE_BLOCKED);
+        subscriber_stop(&g_many_stacks[itr]);
+    }
+    printf("bus: many subscribers ok\n");
+}
+
+/* Only subscribers of the topic receive the event, an event without
+ * subscribers is freed by the publish call.
+ */
+static void test_topics(void)
+{
+    static struct subscriber_stack first;
+    static struct subscriber_stack second;
+
+    events_init();
+    subscriber_start(&first,  &g_first);
+    subscriber_start(&second, &g_second);
+    nc_bus_subscribe(&g_bus, &g_first,  0u);
+    nc_bus_subscribe(&g_bus, &g_first,  1u);
+    nc_bus_subscribe(&g_bus, &g_second, 1u);
+
+    TEST_ASSERT(nc_bus_publish(&g_bus, 2u, &g_events[0].header) == 0u);
+    TEST_ASSERT(g_events[0].frees == 1u);
+    TEST_ASSERT(nc_bus_publish(&g_bus, 0u, &g_events[1].header) == 1u);
+    TEST_ASSERT(nc_bus_publish(&g_bus, 1u, &g_events[2].header) == 2u);
+    nc_bus_unsubscribe(&g_bus, &g_first, 1u);
+    TEST_ASSERT(nc_bus_publish(&g_bus, 1u, &g_events[3].header) == 1u);
+    nc_schedule();
+
+    TEST_ASSERT((first.received == 2u) && (first.topics == 0x3u));
+    TEST_ASSERT((second.received == 2u) && (second.topics == 0x2u));
+
+    for (uint32_t itr = 0u; itr < 4u; itr++) {
+        TEST_ASSERT(g_events[itr].frees == 1u);
+    }
+    subscriber_stop(&first);
+    subscriber_stop(&second);
+    printf("bus: topics ok\n");
+}
+
+/* Events which do not fit into a full subscriber queue are counted as
+ * overruns and not received.
+ */
+static void test_overruns(void)
+{
+    static struct subscriber_stack stack;
+
+    events_init();
+    subscriber_start(&stack, &g_short);
+    nc_bus_subscribe(&g_bus, &g_short, 0u);
+
+    for (uint32_t itr = 0u; itr < 6u; itr++) {
+        TEST_ASSERT(nc_bus_publish(&g_bus, 0u, &g_events[itr].header) ==
+            ((itr < 4u) ? 1u : 0u));
+    }
+    TEST_ASSERT(nc_bus_get_overruns(&g_short) == 2u);
+    TEST_ASSERT((g_events[4].frees == 1u) && (g_events[5].frees == 1u));
+    nc_schedule();
+    TEST_ASSERT((stack.runs == 1u) && (stack.received == 4u));
+
+    for (uint32_t itr = 0u; itr < 6u; itr++) {
+        TEST_ASSERT(g_events[itr].frees == 1u);
+    }
+    subscriber_stop(&stack);
+    printf("bus: overruns ok\n");
+}
+
+/* Detaching releases the pending events of the subscriber, detaching a
+ * subscriber which is not attached does not touch the bus.
+ */
+static void test_detach(void)
+{
+    static struct subscriber_stack first;
+    static struct subscriber_stack second;
+
+    events_init();
+    subscriber_start(&first,  &g_first);
+    subscriber_start(&second, &g_second);
+    nc_bus_subscribe(&g_bus, &g_first,  0u);
+    nc_bus_subscribe(&g_bus, &g_second, 0u);
+    nc_bus_detach(&g_bus, &g_short);      /* Its old slot is used by g_first */
+
+    for (uint32_t itr = 0u; itr < 3u; itr++) {
+        TEST_ASSERT(nc_bus_publish(&g_bus, 0u, &g_events[itr].header) == 2u);
+    }
+    nc_bus_detach(&g_bus, &g_first);
+    nc_bus_detach(&g_bus, &g_first);                    /* Has no effect */
+    TEST_ASSERT(g_events[0].frees == 0u);
+    nc_thread_block(first.thread);              /* Made ready by publishing */
+    nc_schedule();
+    TEST_ASSERT((first.runs == 0u) && (second.received == 3u));
+
+    for (uint32_t itr = 0u; itr < 3u; itr++) {
+        TEST_ASSERT(g_events[itr].frees == 1u);
+    }
+    TEST_ASSERT(nc_bus_publish(&g_bus, 0u, &g_events[3].header) == 1u);
+    nc_schedule();
+    TEST_ASSERT((first.received == 0u) && (second.received == 4u));
+    TEST_ASSERT(second.runs == 2u);
+
+    nc_thread_destroy(first.thread);
+    subscriber_stop(&second);
+    printf("bus: detach ok\n");
+}
+
+static void test_attach_full(void)
+{
+    TEST_ASSERT(nc_bus_attach(&g_small_bus, &g_first, NULL));
+    TEST_ASSERT(nc_bus_attach(&g_small_bus, &g_second, NULL));
+    TEST_ASSERT(!nc_bus_attach(&g_small_bus, &g_short, NULL));
+    nc_bus_detach(&g_small_bus, &g_first);
+    TEST_ASSERT(nc_bus_attach(&g_small_bus, &g_short, NULL));
+    nc_bus_detach(&g_small_bus, &g_second);
+    nc_bus_detach(&g_small_bus, &g_short);
+    printf("bus: attach to a full bus ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_many();
+    test_topics();
+    test_overruns();
+    test_detach();
+    test_attach_full();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_THREADS < NUM_OF_SUBSCRIBERS)
+# error "test_bus: the test needs a thread for each subscriber."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
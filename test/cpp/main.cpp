@@ -0,0 +1,173 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       C++ front end tests
+ * @details     Covers a thread table executed by priority, lambda contexts
+ *              and returning of pool threads by destructors.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "nanocoop.hpp"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+namespace
+{
+
+/* Appends its name to the trace and finishes after the given number of
+ * dispatches.
+ */
+struct tracer
+{
+    void operator()()
+    {
+        TEST_ASSERT(trace_size < sizeof(trace) - 1u);
+        trace[trace_size++] = name;
+        trace[trace_size]   = '\0';
+
+        if (--left == 0u) {
+            nc::done();
+        }
+    }
+
+    char                        name;
+    unsigned                    left;
+
+    static char                 trace[16];
+    static std::size_t          trace_size;
+};
+
+char                            tracer::trace[16];
+std::size_t                     tracer::trace_size;
+
+using table_type = nc::thread_table<
+    nc::thread<tracer, 3>,
+    nc::thread<tracer, 7>,
+    nc::thread<tracer, 5>>;
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+void test_table();
+void test_lambda();
+void test_destructor();
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+table_type                      g_table{
+    tracer{'a', 1u}, tracer{'b', 2u}, tracer{'c', 1u}};
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* The table creates all threads and they execute by priority.
+ */
+void test_table()
+{
+    static_assert(table_type::size == 3u, "table size");
+    static_assert(table_type::priority_of(1u) == 7u, "table priority");
+
+    TEST_ASSERT(g_table.get<0>().handle() == nullptr);
+    TEST_ASSERT(g_table.create_all());
+    TEST_ASSERT(g_table.get<0>().handle() != nullptr);
+    TEST_ASSERT(g_table.get<1>().state() == NC_STATE_IDLE);
+    g_table.ready_all();
+    TEST_ASSERT(g_table.get<1>().state() == NC_STATE_READY);
+    nc::schedule();
+    TEST_ASSERT(std::strcmp(tracer::trace, "bbca") == 0);
+    TEST_ASSERT(g_table.get<1>().context().left == 0u);
+
+    g_table.get<0>().context().left = 1u;
+    g_table.get<0>().ready();
+    g_table.get<0>().block();
+    nc::schedule();
+    TEST_ASSERT(std::strcmp(tracer::trace, "bbca") == 0);
+    std::printf("cpp: thread table ok\n");
+}
+
+/* A lambda is a context type as any other callable.
+ */
+void test_lambda()
+{
+    unsigned                    runs = 0u;
+    auto                        body = [&runs]()
+    {
+        runs++;
+        nc::done();
+    };
+    nc::thread<decltype(body), 1> thread(body);
+
+    TEST_ASSERT(thread.create());
+    thread.ready();
+    nc::schedule();
+    thread.ready();
+    nc::schedule();
+    TEST_ASSERT(runs == 2u);
+    std::printf("cpp: lambda context ok\n");
+}
+
+/* A thread which goes out of scope returns its pool slot.
+ */
+void test_destructor()
+{
+    for (unsigned round = 0u; round < 3u * CONFIG_NC_NUM_OF_THREADS; round++) {
+        nc::thread<tracer, 1> thread(tracer{'d', 1u});
+
+        tracer::trace_size = 0u;
+        TEST_ASSERT(thread.create());
+        thread.ready();
+        nc::schedule();
+        TEST_ASSERT(std::strcmp(tracer::trace, "d") == 0);
+    }
+    std::printf("cpp: destructor ok\n");
+}
+
+} /* namespace */
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main()
+{
+    test_table();
+    test_lambda();
+    test_destructor();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0) || (CONFIG_NC_NUM_OF_THREADS > 8)
+# error "test_cpp: the test needs a small static thread pool."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.cpp
+ ******************************************************************************/
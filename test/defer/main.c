@@ -0,0 +1,253 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Deferred call tests
+ * @details     Covers the call order, execution in batches, overruns of a
+ *              full queue, many rounds of the ring, calls posted by deferred
+ *              calls and the order of deferred calls against threads below
+ *              and above `CONFIG_NC_DEFER_PRIO`.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_defer.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_ROUNDS                   100u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void trace(char event);
+static void trace_reset(void);
+static void call_fn(void *);
+static void repost_fn(void *);
+static void wake_fn(void *);
+static void thread_fn(void *);
+static void test_batches(void);
+static void test_rounds(void);
+static void test_repost(void);
+static void test_priorities(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static const char               g_names[] = "0123456789ABCDEFGHIJ";
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void trace(char event)
+{
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = event;
+    g_trace[g_trace_size]   = '\0';
+}
+
+static void trace_reset(void)
+{
+    g_trace_size = 0u;
+    g_trace[0]   = '\0';
+}
+
+static void call_fn(void * arg)
+{
+    trace(*(const char *)arg);
+}
+
+/* Posts the call again until the counter runs out.
+ */
+static void repost_fn(void * arg)
+{
+    uint32_t *                  left = arg;
+
+    trace('r');
+
+    if (--*left != 0u) {
+        TEST_ASSERT(nc_defer_post(repost_fn, left));
+    }
+}
+
+static void wake_fn(void * arg)
+{
+    trace('w');
+    nc_thread_ready(arg);
+}
+
+static void thread_fn(void * stack)
+{
+    trace(*(const char *)stack);
+    nc_thread_done();
+}
+
+/* A full queue drops the calls, others are executed in the order they were
+ * posted, one batch per dispatch.
+ */
+static void test_batches(void)
+{
+    uint32_t                    overruns;
+
+    trace_reset();
+    overruns = nc_defer_get_overruns();
+    TEST_ASSERT(!nc_defer_is_pending());
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_DEFER_SIZE + 4u; itr++) {
+        TEST_ASSERT(nc_defer_post(call_fn, (void *)&g_names[itr]) ==
+            (itr < CONFIG_NC_DEFER_SIZE));
+    }
+    TEST_ASSERT(nc_defer_get_overruns() == overruns + 4u);
+    TEST_ASSERT(nc_defer_is_pending());
+
+    TEST_ASSERT(nc_schedule_one());
+    TEST_ASSERT(strcmp(g_trace, "01234567") == 0);
+    TEST_ASSERT(nc_defer_is_pending());
+    TEST_ASSERT(!nc_schedule_one());                  /* Nothing is left */
+    TEST_ASSERT(strcmp(g_trace, "0123456789ABCDEF") == 0);
+    TEST_ASSERT(!nc_defer_is_pending());
+
+    TEST_ASSERT(nc_defer_post(call_fn, (void *)&g_names[0]));
+    TEST_ASSERT(nc_defer_get_overruns() == overruns + 4u);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "0123456789ABCDEF0") == 0);
+    printf("defer: batches and overruns ok\n");
+}
+
+/* Sequences of the slots keep working after the positions wrap the ring many
+ * times.
+ */
+static void test_rounds(void)
+{
+    for (uint32_t round = 0u; round < NUM_OF_ROUNDS; round++) {
+        uint32_t                count = 1u + round % CONFIG_NC_DEFER_SIZE;
+
+        trace_reset();
+
+        for (uint32_t itr = 0u; itr < count; itr++) {
+            TEST_ASSERT(nc_defer_post(call_fn, (void *)&g_names[itr]));
+        }
+        nc_schedule();
+        TEST_ASSERT(strncmp(g_trace, g_names, count) == 0);
+        TEST_ASSERT(g_trace_size == count);
+        TEST_ASSERT(!nc_defer_is_pending());
+    }
+    printf("defer: ring rounds ok\n");
+}
+
+/* A call posted by a deferred call is executed in the same nc_schedule()
+ * call.
+ */
+static void test_repost(void)
+{
+    static uint32_t             left;
+
+    trace_reset();
+    left = CONFIG_NC_DEFER_BATCH + 2u;
+    TEST_ASSERT(nc_defer_post(repost_fn, &left));
+    nc_schedule();
+    TEST_ASSERT(left == 0u);
+    TEST_ASSERT(g_trace_size == CONFIG_NC_DEFER_BATCH + 2u);
+    TEST_ASSERT(!nc_defer_is_pending());
+    printf("defer: post from a deferred call ok\n");
+}
+
+/* Threads above CONFIG_NC_DEFER_PRIO run before the deferred calls and
+ * preempt them between batches, threads at or below it run after them.
+ */
+static void test_priorities(void)
+{
+    static const char           high_name = 'h';
+    static const char           low_name  = 'l';
+    nc_thread *                 high;
+    nc_thread *                 low;
+
+    high = nc_thread_create(thread_fn, (void *)&high_name,
+        CONFIG_NC_DEFER_PRIO + 1u);
+    low  = nc_thread_create(thread_fn, (void *)&low_name,
+        CONFIG_NC_DEFER_PRIO);
+    TEST_ASSERT((high != NULL) && (low != NULL));
+
+    trace_reset();
+    nc_thread_ready(low);
+    nc_thread_ready(high);
+
+    for (uint32_t itr = 0u; itr < 10u; itr++) {
+        TEST_ASSERT(nc_defer_post(call_fn, (void *)&g_names[itr]));
+    }
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "h0123456789l") == 0);
+
+    trace_reset();                  /* Made ready in the middle of a batch */
+    nc_thread_ready(low);
+    TEST_ASSERT(nc_defer_post(call_fn, (void *)&g_names[0]));
+    TEST_ASSERT(nc_defer_post(wake_fn, high));
+
+    for (uint32_t itr = 1u; itr < 10u; itr++) {
+        TEST_ASSERT(nc_defer_post(call_fn, (void *)&g_names[itr]));
+    }
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "0w123456h789l") == 0);
+    nc_thread_destroy(high);
+    nc_thread_destroy(low);
+    printf("defer: priorities ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_batches();
+    test_rounds();
+    test_repost();
+    test_priorities();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_DEFER != 1)
+# error "test_defer: the test needs CONFIG_NC_DEFER."
+#endif
+
+#if (CONFIG_NC_DEFER_SIZE != 16) || (CONFIG_NC_DEFER_BATCH != 8)
+# error "test_defer: the expected traces assume the default size and batch."
+#endif
+
+#if (CONFIG_NC_DEFER_PRIO + 1 >= CONFIG_NC_NUM_OF_PRIO_LEVELS)
+# error "test_defer: the test needs a thread priority above the defer one."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
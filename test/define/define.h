@@ -0,0 +1,59 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Static thread definition tests, shared declarations
+ *********************************************************************//** @{ */
+
+#ifndef DEFINE_H
+#define DEFINE_H
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stddef.h>
+
+#include "nanocoop.h"
+
+/*==============================================================  MACRO's  ==*/
+/*===========================================================  DATA TYPES  ==*/
+/*=====================================================  GLOBAL VARIABLES  ==*/
+
+/**@brief       Thread defined in the other translation unit
+ */
+extern nc_thread *              g_low;
+
+/**@brief       Stacks of executed threads, in execution order
+ */
+extern char                     g_define_trace[16];
+extern size_t                   g_define_trace_size;
+
+/*==================================================  FUNCTION PROTOTYPES  ==*/
+
+/**@brief       Appends the character pointed by stack to the trace
+ */
+void define_fn(void * stack);
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of define.h
+ ******************************************************************************/
+#endif /* DEFINE_H */
@@ -0,0 +1,139 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Static thread definition tests
+ * @details     Covers threads defined in two translation units, autostart,
+ *              the stack and priority of definitions and that defined threads
+ *              do not use the thread pool.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_test.h"
+#include "define.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void test_autostart(void);
+static void test_ready(void);
+static void test_pool(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static char                     g_high_stack = 'h';
+static char                     g_idle_stack = 'i';
+
+NC_THREAD_DEFINE(g_high, define_fn, &g_high_stack, 9u, true);
+NC_THREAD_DEFINE(g_idle, define_fn, &g_idle_stack, 5u, false);
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+
+char                            g_define_trace[16];
+size_t                          g_define_trace_size;
+
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Autostart threads of both translation units run by priority.
+ */
+static void test_autostart(void)
+{
+    nc_thread_create_defined();
+    TEST_ASSERT(nc_thread_get_state(g_high) == NC_STATE_READY);
+    TEST_ASSERT(nc_thread_get_state(g_low) == NC_STATE_READY);
+    TEST_ASSERT(nc_thread_get_state(g_idle) == NC_STATE_IDLE);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_define_trace, "hl") == 0);
+    printf("define: autostart ok\n");
+}
+
+/* Other defined threads are made ready as usual.
+ */
+static void test_ready(void)
+{
+    g_define_trace_size = 0u;
+    nc_thread_ready(g_low);
+    nc_thread_ready(g_idle);
+    nc_thread_ready(g_high);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_define_trace, "hil") == 0);
+    printf("define: ready ok\n");
+}
+
+/* The whole pool is still available next to the defined threads.
+ */
+static void test_pool(void)
+{
+    nc_thread *                 threads[CONFIG_NC_NUM_OF_THREADS];
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_thread_create(define_fn, &g_idle_stack, 1u);
+        TEST_ASSERT(threads[itr] != NULL);
+        TEST_ASSERT((threads[itr] != g_high) && (threads[itr] != g_low) &&
+                    (threads[itr] != g_idle));
+    }
+    TEST_ASSERT(nc_thread_create(define_fn, &g_idle_stack, 1u) == NULL);
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    printf("define: pool is not used ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+
+void define_fn(void * stack)
+{
+    TEST_ASSERT(g_define_trace_size < sizeof(g_define_trace) - 1u);
+    g_define_trace[g_define_trace_size++] = *(char *)stack;
+    g_define_trace[g_define_trace_size]   = '\0';
+    nc_thread_done();
+}
+
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_autostart();
+    test_ready();
+    test_pool();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0) || (CONFIG_NC_NUM_OF_THREADS > 8)
+# error "test_define: the test needs a small static thread pool."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,228 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Earliest deadline first scheduling tests
+ * @details     Covers the execution order by absolute deadline, priority
+ *              among equal deadlines, threads without deadline, reordering
+ *              of a ready thread and deadline miss accounting.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_timer.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_JOBS                     5u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct job
+{
+    char                        name;
+    uint_fast8_t                priority;
+    nc_tick                     deadline;   /* Relative, 0 - none            */
+    uint32_t                    dispatches; /* Needed to finish the job      */
+    uint32_t                    left;
+    nc_thread *                 thread;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void job_fn(void *);
+static void jobs_create(void);
+static void jobs_destroy(void);
+static void jobs_ready(void);
+static void run_ticks(uint32_t ticks);
+static void test_order(void);
+static void test_reorder(void);
+static void test_misses(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct job               g_jobs[NUM_OF_JOBS] =
+{
+    { 'a', 5u,  30u, 1u, 0u, NULL },
+    { 'b', 1u,  10u, 1u, 0u, NULL },
+    { 'c', 3u,  20u, 1u, 0u, NULL },
+    { 'd', 31u,  0u, 1u, 0u, NULL },
+    { 'e', 2u,  10u, 1u, 0u, NULL },
+};
+
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* A job takes the given number of dispatches, then it is finished.
+ */
+static void job_fn(void * stack)
+{
+    struct job *                job = stack;
+
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = job->name;
+    g_trace[g_trace_size]   = '\0';
+
+    if (--job->left == 0u) {
+        nc_thread_done();
+    }
+}
+
+static void jobs_create(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_JOBS; itr++) {
+        struct job *            job = &g_jobs[itr];
+
+        job->thread = nc_thread_create(job_fn, job, job->priority);
+        TEST_ASSERT(job->thread != NULL);
+        nc_thread_set_deadline(job->thread, job->deadline);
+    }
+    g_trace_size = 0u;
+}
+
+static void jobs_destroy(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_JOBS; itr++) {
+        nc_thread_destroy(g_jobs[itr].thread);
+    }
+}
+
+static void jobs_ready(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_JOBS; itr++) {
+        g_jobs[itr].left = g_jobs[itr].dispatches;
+        nc_thread_ready(g_jobs[itr].thread);
+    }
+}
+
+/* Advance the time by one tick after each dispatch.
+ */
+static void run_ticks(uint32_t ticks)
+{
+    for (uint32_t itr = 0u; itr < ticks; itr++) {
+        nc_schedule_one();
+        nc_timer_tick();
+    }
+}
+
+/* The earliest deadline goes first, higher priority first among equal
+ * deadlines, threads without a deadline last.
+ */
+static void test_order(void)
+{
+    jobs_create();
+    jobs_ready();
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "ebcad") == 0);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_JOBS; itr++) {
+        TEST_ASSERT(nc_thread_get_deadline_misses(g_jobs[itr].thread) == 0u);
+    }
+    jobs_destroy();
+    printf("edf: deadline order ok\n");
+}
+
+/* Changing the deadline of a ready thread moves it in the ready heap.
+ */
+static void test_reorder(void)
+{
+    jobs_create();
+    jobs_ready();
+    nc_thread_set_deadline(g_jobs[0].thread, 5u);
+    nc_thread_set_deadline(g_jobs[1].thread, 0u);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "aecdb") == 0);
+
+    g_trace_size = 0u;                /* The new deadlines apply to new jobs */
+    jobs_ready();
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "aecdb") == 0);
+    jobs_destroy();
+    printf("edf: reorder ready thread ok\n");
+}
+
+/* Each dispatch takes one tick. Jobs which finish after their deadline are
+ * counted as misses, a job finished exactly at its deadline is not.
+ */
+static void test_misses(void)
+{
+    g_jobs[0].dispatches = 4u;             /* 'a' runs last, in ticks 6..9 */
+    g_jobs[1].dispatches = 2u;             /* 'b' in ticks 0 and 1, on time */
+    g_jobs[1].deadline   = 1u;
+    g_jobs[2].dispatches = 4u;             /* 'c' in ticks 2..5, late */
+    g_jobs[2].deadline   = 4u;
+    g_jobs[0].deadline   = 20u;
+    jobs_create();
+
+    for (uint32_t itr = 0u; itr < 3u; itr++) {
+        g_jobs[itr].left = g_jobs[itr].dispatches;
+        nc_thread_ready(g_jobs[itr].thread);
+    }
+    run_ticks(10u);
+    TEST_ASSERT(strcmp(g_trace, "bbccccaaaa") == 0);
+    TEST_ASSERT(nc_thread_get_deadline_misses(g_jobs[0].thread) == 0u);
+    TEST_ASSERT(nc_thread_get_deadline_misses(g_jobs[1].thread) == 0u);
+    TEST_ASSERT(nc_thread_get_deadline_misses(g_jobs[2].thread) == 1u);
+
+    g_trace_size   = 0u;           /* A late job only counts once finished */
+    g_jobs[1].left = 5u;
+    nc_thread_ready(g_jobs[1].thread);
+    run_ticks(4u);
+    TEST_ASSERT(nc_thread_get_deadline_misses(g_jobs[1].thread) == 0u);
+    run_ticks(1u);
+    TEST_ASSERT(strcmp(g_trace, "bbbbb") == 0);
+    TEST_ASSERT(nc_thread_get_deadline_misses(g_jobs[1].thread) == 1u);
+    jobs_destroy();
+    printf("edf: deadline misses ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_order();
+    test_reorder();
+    test_misses();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_SCHED_EDF != 1)
+# error "test_edf: the test needs CONFIG_NC_SCHED_EDF."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
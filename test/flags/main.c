@@ -0,0 +1,264 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Event flags tests
+ * @details     Covers any and all wait conditions, waking of only the
+ *              matching waiters, cancelling and threads which are made ready
+ *              by something else than the flags while they wait.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanocoop.h"
+#include "nc_flags.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WAITERS                  3u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct waiter_stack
+{
+    nc_flags_waiter             waiter;
+    nc_cpu_reg                  mask;
+    nc_flags_mode               mode;
+    uint32_t                    runs;
+    uint32_t                    met;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void       waiter_fn(void *);
+static nc_thread * waiter_start(struct waiter_stack * stack, nc_cpu_reg mask,
+                      nc_flags_mode mode);
+static void       test_any_all(void);
+static void       test_already_met(void);
+static void       test_many_waiters(void);
+static void       test_stray_ready(void);
+static void       test_cancel(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static nc_flags                 g_flags;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Waits until the condition is met, then blocks itself so the test can
+ * inspect it.
+ */
+static void waiter_fn(void * stack_)
+{
+    struct waiter_stack *       stack = stack_;
+
+    stack->runs++;
+
+    if (nc_flags_wait(&g_flags, &stack->waiter, stack->mask, stack->mode)) {
+        stack->met++;
+        nc_thread_block(nc_thread_get_current());
+    }
+}
+
+static nc_thread * waiter_start(struct waiter_stack * stack, nc_cpu_reg mask,
+    nc_flags_mode mode)
+{
+    nc_thread *                 thread;
+
+    stack->mask = mask;
+    stack->mode = mode;
+    thread      = nc_thread_create(waiter_fn, stack, 1u);
+    TEST_ASSERT(thread != NULL);
+    nc_thread_ready(thread);
+    nc_schedule();
+
+    return (thread);
+}
+
+static void test_any_all(void)
+{
+    static struct waiter_stack  any;
+    static struct waiter_stack  all;
+    nc_thread *                 any_thread;
+    nc_thread *                 all_thread;
+
+    nc_flags_init(&g_flags);
+    any_thread = waiter_start(&any, 0x6u, NC_FLAGS_ANY);
+    all_thread = waiter_start(&all, 0x3u, NC_FLAGS_ALL);
+    TEST_ASSERT(nc_thread_get_state(any_thread) == NC_STATE_BLOCKED);
+    TEST_ASSERT(nc_thread_get_state(all_thread) == NC_STATE_BLOCKED);
+
+    nc_flags_set(&g_flags, 0x1u);
+    nc_schedule();
+    TEST_ASSERT((any.met == 0u) && (all.met == 0u));
+    TEST_ASSERT(nc_thread_get_state(all_thread) == NC_STATE_BLOCKED);
+
+    nc_flags_set(&g_flags, 0x2u);          /* Meets both conditions at once */
+    nc_schedule();
+    TEST_ASSERT((any.met == 1u) && (all.met == 1u));
+    TEST_ASSERT((any.runs == 2u) && (all.runs == 2u));
+    TEST_ASSERT(nc_flags_get(&g_flags) == 0x3u);
+    nc_flags_clear(&g_flags, 0x1u);
+    TEST_ASSERT(nc_flags_get(&g_flags) == 0x2u);
+    TEST_ASSERT(g_flags.waiters == NULL);
+    nc_thread_destroy(any_thread);
+    nc_thread_destroy(all_thread);
+    printf("flags: any and all conditions ok\n");
+}
+
+static void test_already_met(void)
+{
+    static struct waiter_stack  stack;
+    nc_thread *                 thread;
+
+    nc_flags_init(&g_flags);
+    nc_flags_set(&g_flags, 0x8u);
+    thread = waiter_start(&stack, 0x8u, NC_FLAGS_ALL);
+    TEST_ASSERT((stack.runs == 1u) && (stack.met == 1u));
+    TEST_ASSERT(g_flags.waiters == NULL);
+    nc_thread_destroy(thread);
+    printf("flags: condition already met ok\n");
+}
+
+/* Only the waiters whose condition is met are made ready, others stay in the
+ * wait list.
+ */
+static void test_many_waiters(void)
+{
+    static struct waiter_stack  stacks[NUM_OF_WAITERS];
+    nc_thread *                 threads[NUM_OF_WAITERS];
+
+    nc_flags_init(&g_flags);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WAITERS; itr++) {
+        threads[itr] = waiter_start(&stacks[itr], (nc_cpu_reg)1u << itr,
+            NC_FLAGS_ANY);
+    }
+    nc_flags_set(&g_flags, 0x10u);                   /* Nobody is interested */
+    nc_schedule();
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WAITERS; itr++) {
+        TEST_ASSERT(stacks[itr].runs == 1u);
+    }
+    nc_flags_set(&g_flags, 0x2u);
+    nc_schedule();
+    TEST_ASSERT(stacks[0].met == 0u);
+    TEST_ASSERT(stacks[1].met == 1u);
+    TEST_ASSERT(stacks[2].met == 0u);
+    nc_flags_set(&g_flags, 0x5u);
+    nc_schedule();
+    TEST_ASSERT((stacks[0].met == 1u) && (stacks[2].met == 1u));
+    TEST_ASSERT(stacks[1].runs == 2u);
+    TEST_ASSERT(g_flags.waiters == NULL);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WAITERS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    printf("flags: only matching waiters are made ready ok\n");
+}
+
+/* A waiting thread which is made ready by something else blocks again, and
+ * its new mask replaces the old one.
+ */
+static void test_stray_ready(void)
+{
+    static struct waiter_stack  stack;
+    nc_thread *                 thread;
+
+    nc_flags_init(&g_flags);
+    thread = waiter_start(&stack, 0x1u, NC_FLAGS_ANY);
+    stack.mask = 0x4u;
+    nc_thread_ready(thread);
+    TEST_ASSERT(!nc_schedule_for(1000u, 0u));
+    TEST_ASSERT(stack.runs == 2u);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+
+    nc_flags_set(&g_flags, 0x1u);                      /* The old mask */
+    nc_schedule();
+    TEST_ASSERT((stack.runs == 2u) && (stack.met == 0u));
+    nc_flags_set(&g_flags, 0x4u);
+    nc_schedule();
+    TEST_ASSERT((stack.runs == 3u) && (stack.met == 1u));
+    TEST_ASSERT(g_flags.waiters == NULL);
+
+    stack.mask = 0x8u;                       /* Wait again, then a new mask */
+    nc_thread_ready(thread);                  /* which is already met */
+    nc_schedule();
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+    TEST_ASSERT(g_flags.waiters == &stack.waiter);
+    stack.mask = 0x1u;
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT(stack.met == 2u);
+    TEST_ASSERT(g_flags.waiters == NULL);
+    nc_flags_set(&g_flags, 0x8u);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+    nc_thread_destroy(thread);
+    printf("flags: stray wake-up blocks again ok\n");
+}
+
+static void test_cancel(void)
+{
+    static struct waiter_stack  first;
+    static struct waiter_stack  second;
+    nc_thread *                 first_thread;
+    nc_thread *                 second_thread;
+
+    nc_flags_init(&g_flags);
+    first_thread  = waiter_start(&first,  0x1u, NC_FLAGS_ANY);
+    second_thread = waiter_start(&second, 0x1u, NC_FLAGS_ANY);
+    nc_flags_cancel(&g_flags, &first.waiter);
+    nc_flags_cancel(&g_flags, &first.waiter);            /* Has no effect */
+    nc_flags_set(&g_flags, 0x1u);
+    nc_schedule();
+    TEST_ASSERT((first.runs == 1u) && (first.met == 0u));
+    TEST_ASSERT((second.runs == 2u) && (second.met == 1u));
+    TEST_ASSERT(nc_thread_get_state(first_thread) == NC_STATE_BLOCKED);
+    nc_thread_destroy(first_thread);
+    nc_thread_destroy(second_thread);
+    printf("flags: cancel ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_any_all();
+    test_already_met();
+    test_many_waiters();
+    test_stray_ready();
+    test_cancel();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
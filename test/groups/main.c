@@ -0,0 +1,202 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Thread group tests
+ * @details     Covers nc_thread_ready_many() and nc_thread_block_many() with
+ *              threads of different priorities, threads which are already
+ *              ready and repeated entries, and the thread group functions.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WORKERS                  6u
+#define GROUP_CAPACITY                  4u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void worker_fn(void *);
+static void trace_reset(void);
+static void workers_create(void);
+static void workers_destroy(void);
+static void test_ready_many(void);
+static void test_block_many(void);
+static void test_group(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static nc_thread *              g_workers[NUM_OF_WORKERS];
+static char                     g_names[NUM_OF_WORKERS];
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+
+NC_THREAD_GROUP_DEFINE(g_group, GROUP_CAPACITY);
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Each worker appends its name to the trace and finishes.
+ */
+static void worker_fn(void * stack)
+{
+    const char *                name = stack;
+
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = *name;
+    g_trace[g_trace_size]   = '\0';
+    nc_thread_done();
+}
+
+static void trace_reset(void)
+{
+    g_trace_size = 0u;
+    g_trace[0]   = '\0';
+}
+
+/* Workers 'a' to 'f' have priorities 1, 2, 3, 1, 2, 3.
+ */
+static void workers_create(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        g_names[itr]   = (char)('a' + itr);
+        g_workers[itr] = nc_thread_create(worker_fn, &g_names[itr],
+            (uint_fast8_t)(1u + itr % 3u));
+        TEST_ASSERT(g_workers[itr] != NULL);
+    }
+    trace_reset();
+}
+
+static void workers_destroy(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        nc_thread_destroy(g_workers[itr]);
+    }
+}
+
+/* Threads are executed by priority, each once, also when they were already
+ * ready or when they are repeated in the array.
+ */
+static void test_ready_many(void)
+{
+    nc_thread *                 threads[NUM_OF_WORKERS + 2u];
+
+    workers_create();
+    memcpy(threads, g_workers, sizeof(g_workers));
+    threads[NUM_OF_WORKERS]      = g_workers[0];
+    threads[NUM_OF_WORKERS + 1u] = g_workers[5];
+    nc_thread_ready(g_workers[1]);
+    nc_thread_ready_many(threads, NUM_OF_WORKERS + 2u);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        TEST_ASSERT(nc_thread_get_state(g_workers[itr]) == NC_STATE_READY);
+    }
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "cfbead") == 0);
+
+    trace_reset();
+    nc_thread_ready_many(threads, 0u);
+    nc_schedule();
+    TEST_ASSERT(g_trace_size == 0u);
+    workers_destroy();
+    printf("groups: ready many ok\n");
+}
+
+static void test_block_many(void)
+{
+    nc_thread *                 blocked[3];
+
+    workers_create();
+    blocked[0] = g_workers[0];
+    blocked[1] = g_workers[2];
+    blocked[2] = g_workers[4];
+    nc_thread_ready_many(g_workers, NUM_OF_WORKERS);
+    nc_thread_block_many(blocked, 3u);
+    nc_thread_block_many(blocked, 3u);              /* Already blocked */
+    TEST_ASSERT(nc_thread_get_state(g_workers[2]) == NC_STATE_BLOCKED);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "fbd") == 0);
+    workers_destroy();
+    printf("groups: block many ok\n");
+}
+
+static void test_group(void)
+{
+    workers_create();
+
+    for (uint32_t itr = 0u; itr < GROUP_CAPACITY; itr++) {
+        TEST_ASSERT(nc_thread_group_add(&g_group, g_workers[itr]));
+    }
+    TEST_ASSERT(!nc_thread_group_add(&g_group, g_workers[4]));  /* Full */
+    nc_thread_group_remove(&g_group, g_workers[1]);
+    TEST_ASSERT(nc_thread_group_add(&g_group, g_workers[5]));
+
+    nc_thread_group_ready(&g_group);              /* a, c, d and f */
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "cfad") == 0);
+
+    trace_reset();
+    nc_thread_ready(g_workers[1]);
+    nc_thread_group_ready(&g_group);
+    nc_thread_group_block(&g_group);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "b") == 0);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        nc_thread_group_remove(&g_group, g_workers[itr]);
+    }
+    TEST_ASSERT(g_group.count == 0u);
+    workers_destroy();
+    printf("groups: thread group ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_ready_many();
+    test_block_many();
+    test_group();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_WEIGHTED_RR == 1) || (CONFIG_NC_SCHED_EDF == 1)
+# error "test_groups: the expected order assumes plain round-robin."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
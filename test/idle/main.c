@@ -0,0 +1,203 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Tickless idle tests
+ * @details     Covers sleeping in nc_idle() until the next timer expiry and
+ *              waking up early when other OS thread makes a thread ready.
+ *              The test is killed by SIGALRM when it hangs.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nanocoop.h"
+#include "nc_timer.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define TEST_TIMEOUT_S                  30u
+#define DELAY_TICKS                     20u
+#define WAKE_DELAY_US                   20000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static uint64_t now_ns(void);
+static uint32_t run_until(volatile bool * is_done);
+static void     sleeper_fn(void *);
+static void     waiter_fn(void *);
+static void *   wake_fn(void *);
+static void     test_timer_sleep(void);
+static void     test_foreign_wake(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static volatile bool            g_is_done;
+static uint32_t                 g_runs;
+static nc_thread *              g_waiter;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static uint64_t now_ns(void)
+{
+    struct timespec             now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+}
+
+/* Returns the number of nc_idle() calls.
+ */
+static uint32_t run_until(volatile bool * is_done)
+{
+    uint32_t                    idles;
+
+    idles = 0u;
+
+    for (;;) {
+        nc_schedule();
+
+        if (*is_done) {
+            break;
+        }
+        nc_idle();
+        idles++;
+    }
+
+    return (idles);
+}
+
+/* Delays on the first dispatch and finishes on the second one.
+ */
+static void sleeper_fn(void * stack)
+{
+    (void)stack;
+
+    if (g_runs++ == 0u) {
+        nc_thread_delay(DELAY_TICKS);
+    } else {
+        g_is_done = true;
+        nc_thread_done();
+    }
+}
+
+static void waiter_fn(void * stack)
+{
+    (void)stack;
+    g_runs++;
+    g_is_done = true;
+    nc_thread_done();
+}
+
+static void * wake_fn(void * arg)
+{
+    (void)arg;
+    usleep(WAKE_DELAY_US);                /* Let the scheduler fall asleep */
+    nc_thread_ready_async(g_waiter);
+
+    return (NULL);
+}
+
+/* The scheduler sleeps through the delay instead of waking on each tick.
+ */
+static void test_timer_sleep(void)
+{
+    nc_thread *                 thread;
+    nc_tick                     base;
+    uint64_t                    begin;
+    uint32_t                    idles;
+
+    thread    = nc_thread_create(sleeper_fn, NULL, 1u);
+    TEST_ASSERT(thread != NULL);
+    g_runs    = 0u;
+    g_is_done = false;
+    base      = nc_timer_get_ticks();
+    begin     = now_ns();
+    nc_thread_ready(thread);
+    idles     = run_until(&g_is_done);
+    TEST_ASSERT(g_runs == 2u);
+    TEST_ASSERT(nc_timer_get_ticks() - base >= DELAY_TICKS);
+                                        /* The first tick may be a partial one */
+    TEST_ASSERT(now_ns() - begin >=
+        (uint64_t)(DELAY_TICKS - 1u) * CONFIG_NC_TIMER_TICK_NS);
+    TEST_ASSERT(idles < DELAY_TICKS / 2u);
+    nc_thread_destroy(thread);
+    printf("idle: sleep until timer ok, %u wake-ups\n", (unsigned)idles);
+}
+
+/* Without pending timers the scheduler sleeps until other OS thread makes a
+ * thread ready.
+ */
+static void test_foreign_wake(void)
+{
+    pthread_t                   waker;
+    uint32_t                    idles;
+
+    g_waiter  = nc_thread_create(waiter_fn, NULL, 1u);
+    TEST_ASSERT(g_waiter != NULL);
+    g_runs    = 0u;
+    g_is_done = false;
+    TEST_ASSERT(nc_timer_idle_ticks() == NC_TIMER_INFINITE);
+    TEST_ASSERT(pthread_create(&waker, NULL, wake_fn, NULL) == 0);
+    idles     = run_until(&g_is_done);
+    pthread_join(waker, NULL);
+    TEST_ASSERT(g_runs == 1u);
+    TEST_ASSERT(idles <= 2u);
+    nc_thread_destroy(g_waiter);
+    printf("idle: foreign wake-up ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    alarm(TEST_TIMEOUT_S);
+    test_timer_sleep();
+    test_foreign_wake();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_IDLE != 1) || (CONFIG_NC_TIMER != 1)
+# error "test_idle: the test needs CONFIG_NC_IDLE and CONFIG_NC_TIMER."
+#endif
+
+#if (CONFIG_NC_READY_INBOX != 1)
+# error "test_idle: the test needs CONFIG_NC_READY_INBOX."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
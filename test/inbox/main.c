@@ -0,0 +1,195 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Ready inbox tests
+ * @details     Covers making threads ready through the inbox, coalescing of
+ *              repeated requests and producers running in other OS threads.
+ *              The test is killed by SIGALRM when it hangs.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "nanocoop.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define TEST_TIMEOUT_S                  30u
+#define NUM_OF_PRODUCERS                4u
+#define PRODUCER_ROUNDS                 2000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct consumer
+{
+    nc_thread *                 thread;
+    uint32_t                    runs;       /* Written by the scheduler only */
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void   consumer_fn(void *);
+static void * producer_main(void *);
+static void   test_async(void);
+static void   test_coalesce(void);
+static void   test_producers(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct consumer          g_consumer[NUM_OF_PRODUCERS];
+static uint32_t                 g_producers_done;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* The run is counted after the thread is blocked, so a producer which sees
+ * the new count can already queue the next run.
+ */
+static void consumer_fn(void * stack)
+{
+    struct consumer *           consumer = stack;
+
+    nc_thread_done();
+    __atomic_store_n(&consumer->runs, consumer->runs + 1u, __ATOMIC_RELEASE);
+}
+
+/* Each producer makes its consumer ready and waits until it has run.
+ */
+static void * producer_main(void * arg)
+{
+    struct consumer *           consumer = arg;
+
+    for (uint32_t round = 1u; round <= PRODUCER_ROUNDS; round++) {
+        nc_thread_ready_async(consumer->thread);
+
+        while (__atomic_load_n(&consumer->runs, __ATOMIC_ACQUIRE) != round) {
+            sched_yield();
+        }
+    }
+    __atomic_add_fetch(&g_producers_done, 1u, __ATOMIC_RELEASE);
+
+    return (NULL);
+}
+
+/* A thread in the inbox is not ready until the scheduler takes the inbox.
+ */
+static void test_async(void)
+{
+    g_consumer[0].thread = nc_thread_create(consumer_fn, &g_consumer[0], 1u);
+    TEST_ASSERT(g_consumer[0].thread != NULL);
+    g_consumer[0].runs = 0u;
+    nc_thread_ready_async(g_consumer[0].thread);
+    TEST_ASSERT(g_consumer[0].runs == 0u);
+    nc_schedule();
+    TEST_ASSERT(g_consumer[0].runs == 1u);
+    nc_schedule();
+    TEST_ASSERT(g_consumer[0].runs == 1u);
+    nc_thread_destroy(g_consumer[0].thread);
+    printf("inbox: ready async ok\n");
+}
+
+/* Repeated requests before the inbox is taken run the thread once.
+ */
+static void test_coalesce(void)
+{
+    g_consumer[0].thread = nc_thread_create(consumer_fn, &g_consumer[0], 1u);
+    TEST_ASSERT(g_consumer[0].thread != NULL);
+    g_consumer[0].runs = 0u;
+
+    for (uint32_t itr = 0u; itr < 3u; itr++) {
+        nc_thread_ready_async(g_consumer[0].thread);
+    }
+    nc_thread_ready(g_consumer[0].thread);
+    nc_schedule();
+    TEST_ASSERT(g_consumer[0].runs == 1u);
+    nc_thread_ready_async(g_consumer[0].thread);      /* Usable once taken */
+    nc_schedule();
+    TEST_ASSERT(g_consumer[0].runs == 2u);
+    nc_thread_destroy(g_consumer[0].thread);
+    printf("inbox: repeated requests ok\n");
+}
+
+/* Producers in other OS threads push into the inbox concurrently, no request
+ * is lost.
+ */
+static void test_producers(void)
+{
+    pthread_t                   producers[NUM_OF_PRODUCERS];
+
+    g_producers_done = 0u;
+
+    for (uint32_t itr = 0u; itr < NUM_OF_PRODUCERS; itr++) {
+        g_consumer[itr].thread = nc_thread_create(consumer_fn,
+            &g_consumer[itr], (uint_fast8_t)(itr + 1u));
+        TEST_ASSERT(g_consumer[itr].thread != NULL);
+        g_consumer[itr].runs = 0u;
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_PRODUCERS; itr++) {
+        TEST_ASSERT(pthread_create(&producers[itr], NULL, producer_main,
+            &g_consumer[itr]) == 0);
+    }
+
+    while (__atomic_load_n(&g_producers_done, __ATOMIC_ACQUIRE) !=
+           NUM_OF_PRODUCERS) {
+        nc_schedule();
+        sched_yield();
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_PRODUCERS; itr++) {
+        pthread_join(producers[itr], NULL);
+        TEST_ASSERT(g_consumer[itr].runs == PRODUCER_ROUNDS);
+        nc_thread_destroy(g_consumer[itr].thread);
+    }
+    printf("inbox: foreign producers ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    alarm(TEST_TIMEOUT_S);
+    test_async();
+    test_coalesce();
+    test_producers();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_READY_INBOX != 1)
+# error "test_inbox: the test needs CONFIG_NC_READY_INBOX."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,408 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       I/O watcher tests
+ * @details     An echo thread serves a socket pair until the peer hangs up,
+ *              a thread sleeping in nc_idle() is woken by a pipe written from
+ *              other OS thread, and a wait is cancelled from other OS thread.
+ *              The last test races nc_io_cancel() against the poller: each
+ *              armed wait must end either cancelled or woken, never both.
+ *              The test is killed by SIGALRM when it hangs.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "nanocoop.h"
+#include "nc_io.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define TEST_TIMEOUT_S                  30u
+#define ECHO_MESSAGES                   16u
+#define WAKE_DELAY_US                   20000u
+#define RACE_ITERATIONS                 20000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct echo_stack
+{
+    nc_io_watch                 watch;
+    uint32_t                    echoed;
+    uint32_t                    events;     /* Events of the last wake-up    */
+    volatile bool               is_done;
+};
+
+struct pipe_stack
+{
+    nc_io_watch                 watch;
+    int                         fd;
+    uint32_t                    runs;
+    uint32_t                    woken;
+    bool                        is_armed;
+    volatile bool               is_done;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void   run_until(volatile bool * is_done);
+static void   pipe_drain(int fd);
+static void   echo_fn(void *);
+static void   pipe_fn(void *);
+static void   marker_fn(void *);
+static void * wake_fn(void *);
+static void * cancel_fn(void *);
+static void * race_fn(void *);
+static void   test_echo_hangup(void);
+static void   test_wake(void);
+static void   test_cancel(void);
+static void   test_cancel_race(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct pipe_stack        g_pipe;
+static int                      g_pipe_write;
+static nc_thread *              g_marker;
+static volatile bool            g_is_marked;
+
+static uint32_t volatile        g_race_phase;
+static uint32_t volatile        g_race_done;
+static uint32_t                 g_race_cancelled;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void run_until(volatile bool * is_done)
+{
+    for (;;) {
+        nc_schedule();
+
+        if (*is_done) {
+            break;
+        }
+        nc_idle();
+    }
+}
+
+static void pipe_drain(int fd)
+{
+    char                        buffer[64];
+
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+        ;
+    }
+}
+
+static void echo_fn(void * stack_)
+{
+    struct echo_stack *         stack = stack_;
+    char                        buffer[64];
+    ssize_t                     size;
+
+    stack->events = nc_io_get_events(&stack->watch);
+
+    while ((size = read(stack->watch.fd, buffer, sizeof(buffer))) > 0) {
+        TEST_ASSERT(write(stack->watch.fd, buffer, (size_t)size) == size);
+        stack->echoed += (uint32_t)size;
+    }
+
+    if (size == 0) {                                    /* Peer hung up */
+        stack->is_done = true;
+        nc_thread_done();
+
+        return;
+    }
+    TEST_ASSERT(errno == EAGAIN);
+    TEST_ASSERT(nc_io_wait(&stack->watch, NC_IO_READ));
+}
+
+static void pipe_fn(void * stack_)
+{
+    struct pipe_stack *         stack = stack_;
+
+    stack->runs++;
+
+    if (stack->is_armed) {                          /* Woken by the event */
+        stack->is_armed = false;
+        stack->woken++;
+        stack->is_done  = true;
+        nc_thread_block(nc_thread_get_current());
+
+        return;
+    }
+    pipe_drain(stack->fd);
+    stack->is_armed = true;
+    TEST_ASSERT(nc_io_wait(&stack->watch, NC_IO_READ));
+}
+
+static void marker_fn(void * stack)
+{
+    (void)stack;
+    g_is_marked = true;
+    nc_thread_done();
+}
+
+static void * wake_fn(void * arg)
+{
+    (void)arg;
+    usleep(WAKE_DELAY_US);                /* Let the scheduler fall asleep */
+    TEST_ASSERT(write(g_pipe_write, "w", 1) == 1);
+
+    return (NULL);
+}
+
+static void * cancel_fn(void * arg)
+{
+    (void)arg;
+    usleep(WAKE_DELAY_US);
+    TEST_ASSERT(nc_io_cancel(&g_pipe.watch));
+    TEST_ASSERT(!nc_io_cancel(&g_pipe.watch));
+    TEST_ASSERT(write(g_pipe_write, "c", 1) == 1);     /* Must be ignored */
+    nc_thread_ready_async(g_marker);
+
+    return (NULL);
+}
+
+static void * race_fn(void * arg)
+{
+    (void)arg;
+
+    for (uint32_t itr = 1u; itr <= RACE_ITERATIONS; itr++) {
+
+        while (nc_atomic_u32_load(&g_race_phase) != itr) {
+            sched_yield();
+        }
+        TEST_ASSERT(write(g_pipe_write, "r", 1) == 1);
+
+        for (volatile uint32_t spin = 0u; spin < itr % 64u; spin++) {
+            ;                                  /* Vary the race window */
+        }
+
+        if ((itr % 2u) == 0u) {          /* Let the poller win on one CPU */
+            sched_yield();
+        }
+
+        if (nc_io_cancel(&g_pipe.watch)) {
+            g_race_cancelled++;
+        }
+        nc_atomic_u32_store(&g_race_done, itr);
+    }
+
+    return (NULL);
+}
+
+/* Echo messages over a socket pair, then close the peer: the waiting thread
+ * is woken with NC_IO_HANGUP and reads the end of stream.
+ */
+static void test_echo_hangup(void)
+{
+    static struct echo_stack    stack;
+    nc_thread *                 thread;
+    int                         pair[2];
+    uint32_t                    sent;
+
+    TEST_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, pair) == 0);
+    nc_io_watch_init(&stack.watch, pair[1]);
+    thread = nc_thread_create(echo_fn, &stack, 1u);
+    TEST_ASSERT(thread != NULL);
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+    sent = 0u;
+
+    for (uint32_t itr = 0u; itr < ECHO_MESSAGES; itr++) {
+        char                    message[16];
+        char                    reply[16];
+        size_t                  size;
+
+        size  = (size_t)snprintf(message, sizeof(message), "ping %u",
+            (unsigned)itr);
+        sent += (uint32_t)size;
+        TEST_ASSERT(write(pair[0], message, size) == (ssize_t)size);
+
+        for (;;) {
+            nc_schedule();
+
+            if (stack.echoed == sent) {
+                break;
+            }
+            nc_idle();
+        }
+        TEST_ASSERT((stack.events & NC_IO_READ) != 0u);
+        TEST_ASSERT(read(pair[0], reply, sizeof(reply)) == (ssize_t)size);
+        TEST_ASSERT(memcmp(message, reply, size) == 0);
+    }
+    close(pair[0]);
+    run_until(&stack.is_done);
+    TEST_ASSERT((stack.events & NC_IO_HANGUP) != 0u);
+    close(pair[1]);
+    nc_thread_destroy(thread);
+    printf("io: echo and hang-up ok\n");
+}
+
+/* The scheduler sleeps in nc_idle() until other OS thread writes the pipe.
+ */
+static void test_wake(void)
+{
+    nc_thread *                 thread;
+    pthread_t                   writer;
+    int                         fds[2];
+
+    TEST_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+    memset(&g_pipe, 0, sizeof(g_pipe));
+    g_pipe.fd    = fds[0];
+    g_pipe_write = fds[1];
+    nc_io_watch_init(&g_pipe.watch, fds[0]);
+    thread = nc_thread_create(pipe_fn, &g_pipe, 1u);
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT(g_pipe.is_armed);
+    TEST_ASSERT(pthread_create(&writer, NULL, wake_fn, NULL) == 0);
+    run_until(&g_pipe.is_done);
+    pthread_join(writer, NULL);
+    TEST_ASSERT(g_pipe.woken == 1u);
+    TEST_ASSERT((nc_io_get_events(&g_pipe.watch) & NC_IO_READ) != 0u);
+    nc_thread_destroy(thread);
+    close(fds[0]);
+    close(fds[1]);
+    printf("io: cross-thread wake ok\n");
+}
+
+/* Other OS thread cancels the wait and then writes the pipe: the thread must
+ * not be made ready. The scheduler is woken by a marker thread.
+ */
+static void test_cancel(void)
+{
+    nc_thread *                 thread;
+    pthread_t                   canceller;
+    int                         fds[2];
+
+    TEST_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+    memset(&g_pipe, 0, sizeof(g_pipe));
+    g_pipe.fd    = fds[0];
+    g_pipe_write = fds[1];
+    g_is_marked  = false;
+    nc_io_watch_init(&g_pipe.watch, fds[0]);
+    thread   = nc_thread_create(pipe_fn, &g_pipe, 1u);
+    g_marker = nc_thread_create(marker_fn, NULL, 2u);
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT(g_pipe.is_armed);
+    TEST_ASSERT(pthread_create(&canceller, NULL, cancel_fn, NULL) == 0);
+    run_until(&g_is_marked);
+    pthread_join(canceller, NULL);
+    nc_io_poll();
+    nc_schedule();
+    TEST_ASSERT(g_pipe.runs == 1u);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+    nc_thread_destroy(thread);
+    close(fds[0]);
+    close(fds[1]);
+    printf("io: cross-thread cancel ok\n");
+}
+
+/* Other OS thread makes the descriptor readable and cancels the wait while
+ * the scheduler polls. Exactly one of them must claim each wait.
+ */
+static void test_cancel_race(void)
+{
+    nc_thread *                 thread;
+    pthread_t                   canceller;
+    int                         fds[2];
+
+    TEST_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+    memset(&g_pipe, 0, sizeof(g_pipe));
+    g_pipe.fd        = fds[0];
+    g_pipe_write     = fds[1];
+    g_race_phase     = 0u;
+    g_race_done      = 0u;
+    g_race_cancelled = 0u;
+    nc_io_watch_init(&g_pipe.watch, fds[0]);
+    thread = nc_thread_create(pipe_fn, &g_pipe, 1u);
+    TEST_ASSERT(pthread_create(&canceller, NULL, race_fn, NULL) == 0);
+
+    for (uint32_t itr = 1u; itr <= RACE_ITERATIONS; itr++) {
+        uint32_t                woken;
+
+        g_pipe.is_armed = false;           /* Left armed by a cancelled wait */
+        nc_thread_ready(thread);
+        nc_schedule();
+        TEST_ASSERT(g_pipe.is_armed);
+        woken = g_pipe.woken;
+        nc_atomic_u32_store(&g_race_phase, itr);
+
+        while (nc_atomic_u32_load(&g_race_done) != itr) {
+            nc_io_poll();
+            nc_schedule();
+            sched_yield();
+        }
+        nc_io_poll();
+        nc_schedule();
+        TEST_ASSERT((g_pipe.woken - woken) <= 1u);
+        TEST_ASSERT(g_pipe.woken + g_race_cancelled == itr);
+    }
+    pthread_join(canceller, NULL);
+    nc_thread_destroy(thread);
+    close(fds[0]);
+    close(fds[1]);
+    printf("io: cancel race ok, %u cancelled, %u woken\n",
+        (unsigned)g_race_cancelled, (unsigned)g_pipe.woken);
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    alarm(TEST_TIMEOUT_S);
+    TEST_ASSERT(nc_io_init());
+    test_echo_hangup();
+    test_wake();
+    test_cancel();
+    test_cancel_race();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_CORES != 1)
+# error "test_io: the test uses a single scheduler core."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
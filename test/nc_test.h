@@ -0,0 +1,59 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//**********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Host test helpers
+ * @defgroup    test Host tests
+ * @brief       Helpers shared by host test suites
+ * @details     Each suite in `test/<name>/` is a single program which prints
+ *              one line for each passed case and exits with a failure status
+ *              on the first failed check.
+ ********************************************************************//** @{ */
+
+#ifndef NC_TEST_H
+#define NC_TEST_H
+
+/*========================================================  INCLUDE FILES  ==*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*==============================================================  MACRO's  ==*/
+
+/**@brief       Check an expression and stop the test when it is false
+ * @param       expr
+ *              Expression which must be true.
+ */
+#define TEST_ASSERT(expr)                                                   \
+    do {                                                                    \
+        if (!(expr)) {                                                      \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__,       \
+                #expr);                                                     \
+            exit(EXIT_FAILURE);                                             \
+        }                                                                   \
+    } while (0)
+
+/*===============================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//** @} *//********************************************
+ * END of nc_test.h
+ *****************************************************************************/
+#endif /* NC_TEST_H */
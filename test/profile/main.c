@@ -0,0 +1,220 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Execution time profiler tests
+ * @details     Covers the dispatch count and consistency of recorded times,
+ *              resetting of statistics and the snapshot of all threads.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanocoop.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WORKERS                  3u
+#define SPIN_ITERATIONS                 1000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct worker
+{
+    nc_thread *                 thread;
+    uint32_t                    left;       /* Dispatches until it is done   */
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void worker_fn(void *);
+static void other_fn(void *);
+static void worker_run(struct worker * worker, uint32_t dispatches);
+static void stats_check(const nc_thread_stats * stats, nc_thread_fn * fn,
+                        uint32_t dispatches);
+static void test_stats(void);
+static void test_reset(void);
+static void test_snapshot(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct worker            g_workers[NUM_OF_WORKERS];
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Spins for a while on each dispatch, stays ready until the last one.
+ */
+static void worker_fn(void * stack)
+{
+    struct worker *             worker = stack;
+    volatile uint32_t           spin;
+
+    for (spin = 0u; spin < SPIN_ITERATIONS; spin++) {
+        ;
+    }
+
+    if (--worker->left == 0u) {
+        nc_thread_done();
+    }
+}
+
+static void other_fn(void * stack)
+{
+    worker_fn(stack);
+}
+
+static void worker_run(struct worker * worker, uint32_t dispatches)
+{
+    worker->left = dispatches;
+    nc_thread_ready(worker->thread);
+    nc_schedule();
+    TEST_ASSERT(worker->left == 0u);
+}
+
+static void stats_check(const nc_thread_stats * stats, nc_thread_fn * fn,
+                        uint32_t dispatches)
+{
+    TEST_ASSERT(stats->fn == fn);
+    TEST_ASSERT(stats->dispatches == dispatches);
+    TEST_ASSERT(stats->exec_min > 0u);
+    TEST_ASSERT(stats->exec_min <= stats->exec_max);
+    TEST_ASSERT(stats->exec_total >= stats->exec_max);
+    TEST_ASSERT(stats->exec_total >= (uint64_t)dispatches * stats->exec_min);
+    TEST_ASSERT(stats->exec_total <= (uint64_t)dispatches * stats->exec_max);
+    TEST_ASSERT(stats->latency_max <= stats->latency_total);
+}
+
+/* Each dispatch is counted and its execution time is within the recorded
+ * bounds.
+ */
+static void test_stats(void)
+{
+    nc_thread_stats             stats;
+
+    g_workers[0].thread = nc_thread_create(worker_fn, &g_workers[0], 1u);
+    TEST_ASSERT(g_workers[0].thread != NULL);
+    nc_thread_get_stats(g_workers[0].thread, &stats);
+    TEST_ASSERT(stats.dispatches == 0u);
+    TEST_ASSERT(stats.exec_total == 0u);
+    worker_run(&g_workers[0], 5u);
+    nc_thread_get_stats(g_workers[0].thread, &stats);
+    stats_check(&stats, worker_fn, 5u);
+    worker_run(&g_workers[0], 2u);
+    nc_thread_get_stats(g_workers[0].thread, &stats);
+    stats_check(&stats, worker_fn, 7u);
+    nc_thread_destroy(g_workers[0].thread);
+    printf("profile: dispatch statistics ok\n");
+}
+
+/* Reset statistics start from scratch.
+ */
+static void test_reset(void)
+{
+    nc_thread_stats             stats;
+
+    g_workers[0].thread = nc_thread_create(worker_fn, &g_workers[0], 1u);
+    TEST_ASSERT(g_workers[0].thread != NULL);
+    worker_run(&g_workers[0], 3u);
+    nc_thread_reset_stats(g_workers[0].thread);
+    nc_thread_get_stats(g_workers[0].thread, &stats);
+    TEST_ASSERT(stats.fn == worker_fn);
+    TEST_ASSERT(stats.dispatches == 0u);
+    TEST_ASSERT(stats.exec_total == 0u);
+    TEST_ASSERT(stats.exec_max == 0u);
+    TEST_ASSERT(stats.latency_total == 0u);
+    TEST_ASSERT(stats.latency_max == 0u);
+    worker_run(&g_workers[0], 1u);
+    nc_thread_get_stats(g_workers[0].thread, &stats);
+    stats_check(&stats, worker_fn, 1u);
+    TEST_ASSERT(stats.exec_min == stats.exec_max);
+    nc_thread_destroy(g_workers[0].thread);
+    printf("profile: reset ok\n");
+}
+
+/* The snapshot reports all existing threads and no more than asked for.
+ */
+static void test_snapshot(void)
+{
+    nc_thread_stats             stats[NUM_OF_WORKERS + 2u];
+    size_t                      count;
+    uint32_t                    found;
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        g_workers[itr].thread = nc_thread_create(
+            (itr == 0u) ? other_fn : worker_fn, &g_workers[itr], 1u);
+        TEST_ASSERT(g_workers[itr].thread != NULL);
+        worker_run(&g_workers[itr], itr + 1u);
+    }
+    count = nc_profile_snapshot(stats, NUM_OF_WORKERS + 2u);
+    TEST_ASSERT(count == NUM_OF_WORKERS);
+    found = 0u;
+
+    for (size_t itr = 0u; itr < count; itr++) {
+        if (stats[itr].fn == other_fn) {
+            stats_check(&stats[itr], other_fn, 1u);
+        } else {
+            TEST_ASSERT((stats[itr].dispatches == 2u) ||
+                        (stats[itr].dispatches == 3u));
+            stats_check(&stats[itr], worker_fn, stats[itr].dispatches);
+        }
+        found |= 1u << (stats[itr].dispatches - 1u);
+    }
+    TEST_ASSERT(found == 0x7u);
+    TEST_ASSERT(nc_profile_snapshot(stats, 2u) == 2u);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        nc_thread_destroy(g_workers[itr].thread);
+    }
+    TEST_ASSERT(nc_profile_snapshot(stats, NUM_OF_WORKERS + 2u) == 0u);
+    printf("profile: snapshot ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_stats();
+    test_reset();
+    test_snapshot();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_PROFILE != 1)
+# error "test_profile: the test needs CONFIG_NC_PROFILE."
+#endif
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0)
+# error "test_profile: the snapshot needs the static thread pool."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,318 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Resumable thread tests
+ * @details     Covers resuming after NC_YIELD() with two interleaved threads,
+ *              NC_WAIT_UNTIL() with a polled and with a blocking condition,
+ *              NC_DELAY() also when made ready early, and restarting from the
+ *              beginning after NC_END() and NC_EXIT().
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_flags.h"
+#include "nc_pt.h"
+#include "nc_timer.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define YIELD_STEPS                     3u
+#define DELAY_TICKS                     5u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct yield_stack
+{
+    char                        name;
+    uint32_t                    step;
+};
+
+struct delay_stack
+{
+    uint32_t                    stage;
+    uint32_t                    runs;
+};
+
+struct wait_stack
+{
+    nc_flags_waiter             waiter;
+    uint32_t                    runs;
+    uint32_t                    stage;
+    bool                        is_open;
+    bool                        should_exit;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void trace(char event);
+static void yield_fn(void *);
+static void wait_fn(void *);
+static void delay_fn(void *);
+static void waker_fn(void *);
+static void test_yield(void);
+static void test_wait_until(void);
+static void test_delay(void);
+static void test_delay_early(void);
+static void test_exit(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+static nc_flags                 g_flags;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void trace(char event)
+{
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = event;
+    g_trace[g_trace_size]   = '\0';
+}
+
+static void yield_fn(void * stack_)
+{
+    struct yield_stack *        stack = stack_;
+
+    NC_BEGIN();
+
+    for (stack->step = 0u; stack->step < YIELD_STEPS; stack->step++) {
+        trace(stack->name);
+        NC_YIELD();
+    }
+    trace('.');
+    NC_END();
+}
+
+static void wait_fn(void * stack_)
+{
+    struct wait_stack *         stack = stack_;
+
+    stack->runs++;
+    NC_BEGIN();
+    stack->stage = 1u;
+    NC_WAIT_UNTIL(stack->is_open);                         /* Polled */
+    stack->stage = 2u;
+    NC_WAIT_UNTIL(nc_flags_wait(&g_flags, &stack->waiter, 0x1u,
+        NC_FLAGS_ANY));                                    /* Blocking */
+    stack->stage = 3u;
+
+    if (stack->should_exit) {
+        NC_EXIT();
+    }
+    stack->stage = 4u;
+    NC_END();
+}
+
+static void delay_fn(void * stack_)
+{
+    struct delay_stack *        stack = stack_;
+
+    stack->runs++;
+    NC_BEGIN();
+    stack->stage = 1u;
+    NC_DELAY(DELAY_TICKS);
+    stack->stage = 2u;
+    NC_END();
+}
+
+/* Makes the given thread ready once.
+ */
+static void waker_fn(void * stack)
+{
+    nc_thread_ready(stack);
+    nc_thread_done();
+}
+
+/* Two threads of the same priority take turns on each NC_YIELD().
+ */
+static void test_yield(void)
+{
+    static struct yield_stack   stack_a = { 'a', 0u };
+    static struct yield_stack   stack_b = { 'b', 0u };
+    nc_thread *                 thread_a;
+    nc_thread *                 thread_b;
+
+    g_trace_size = 0u;
+    thread_a = nc_thread_create(yield_fn, &stack_a, 1u);
+    thread_b = nc_thread_create(yield_fn, &stack_b, 1u);
+    nc_thread_ready(thread_a);
+    nc_thread_ready(thread_b);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "ababab..") == 0);
+    TEST_ASSERT(nc_thread_get_state(thread_a) == NC_STATE_BLOCKED);
+
+    g_trace_size = 0u;                    /* Starts again from the beginning */
+    nc_thread_ready(thread_a);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "aaa.") == 0);
+    nc_thread_destroy(thread_a);
+    nc_thread_destroy(thread_b);
+    printf("pt: yield ok\n");
+}
+
+static void test_wait_until(void)
+{
+    static struct wait_stack    stack;
+    nc_thread *                 thread;
+
+    nc_flags_init(&g_flags);
+    thread = nc_thread_create(wait_fn, &stack, 1u);
+    nc_thread_ready(thread);
+    TEST_ASSERT(nc_schedule_for(10u, 0u));          /* Polls, stays ready */
+    TEST_ASSERT((stack.stage == 1u) && (stack.runs == 10u));
+
+    stack.is_open = true;
+    nc_schedule();
+    TEST_ASSERT((stack.stage == 2u) && (stack.runs == 11u));
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+
+    nc_flags_set(&g_flags, 0x1u);
+    nc_schedule();
+    TEST_ASSERT((stack.stage == 4u) && (stack.runs == 12u));
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+    nc_thread_destroy(thread);
+    printf("pt: wait until ok\n");
+}
+
+static void test_delay(void)
+{
+    static struct delay_stack   stack;
+    nc_thread *                 thread;
+
+    thread = nc_thread_create(delay_fn, &stack, 1u);
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT(stack.stage == 1u);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+
+    for (uint32_t tick = 1u; tick < DELAY_TICKS; tick++) {
+        nc_timer_tick();
+        nc_schedule();
+        TEST_ASSERT(stack.stage == 1u);
+    }
+    nc_timer_tick();
+    nc_schedule();
+    TEST_ASSERT(stack.stage == 2u);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+    nc_thread_destroy(thread);
+    printf("pt: delay ok\n");
+}
+
+/* A thread made ready by other thread in the middle of NC_DELAY() delays
+ * again for the rest of the ticks and it is not made ready twice.
+ */
+static void test_delay_early(void)
+{
+    static struct delay_stack   stack;
+    nc_thread *                 thread;
+    nc_thread *                 waker;
+
+    thread = nc_thread_create(delay_fn, &stack, 1u);
+    waker  = nc_thread_create(waker_fn, thread, 2u);
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT((stack.stage == 1u) && (stack.runs == 1u));
+
+    nc_timer_tick();
+    nc_timer_tick();
+    nc_thread_ready(waker);
+    nc_schedule();
+    TEST_ASSERT((stack.stage == 1u) && (stack.runs == 2u));
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+
+    for (uint32_t tick = 3u; tick < DELAY_TICKS; tick++) {
+        nc_timer_tick();
+        nc_schedule();
+        TEST_ASSERT((stack.stage == 1u) && (stack.runs == 2u));
+    }
+    nc_timer_tick();
+    nc_schedule();
+    TEST_ASSERT((stack.stage == 2u) && (stack.runs == 3u));
+
+    for (uint32_t tick = 0u; tick < 2u * DELAY_TICKS; tick++) {
+        nc_timer_tick();                      /* No stale delay is pending */
+        nc_schedule();
+    }
+    TEST_ASSERT(stack.runs == 3u);
+    nc_thread_destroy(thread);
+    nc_thread_destroy(waker);
+    printf("pt: delay made ready early ok\n");
+}
+
+/* NC_EXIT() in the middle of the body resets the resume point.
+ */
+static void test_exit(void)
+{
+    static struct wait_stack    stack;
+    nc_thread *                 thread;
+
+    nc_flags_init(&g_flags);
+    nc_flags_set(&g_flags, 0x1u);
+    stack.is_open     = true;
+    stack.should_exit = true;
+    thread = nc_thread_create(wait_fn, &stack, 1u);
+    nc_thread_ready(thread);
+    nc_schedule();
+    TEST_ASSERT((stack.stage == 3u) && (stack.runs == 1u));
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+
+    stack.is_open = false;
+    nc_thread_ready(thread);
+    TEST_ASSERT(nc_schedule_one());
+    TEST_ASSERT((stack.stage == 1u) && (stack.runs == 2u));
+    nc_thread_destroy(thread);
+    printf("pt: exit ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_yield();
+    test_wait_until();
+    test_delay();
+    test_delay_early();
+    test_exit();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_TIMER != 1)
+# error "test_pt: the test needs timers for NC_DELAY()."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
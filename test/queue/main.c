@@ -0,0 +1,325 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Message queue tests
+ * @details     Covers blocking of the consumer on an empty queue, the full
+ *              queue, batches which stop at the end of the ring, nested
+ *              reservations and a producer/consumer pipeline which passes
+ *              more messages than the queue holds.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanocoop.h"
+#include "nc_queue.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define QUEUE_CAPACITY                  8u
+#define PIPELINE_MESSAGES               10000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct message
+{
+    uint32_t                    sequence;
+    uint32_t                    payload;
+};
+
+struct consumer_stack
+{
+    nc_queue *                  queue;
+    uint32_t                    runs;
+    uint32_t                    received;
+    uint32_t                    expected;   /* Next expected sequence        */
+    size_t                      max_batch;  /* Released per run, 0 - all     */
+};
+
+struct producer_stack
+{
+    nc_queue *                  queue;
+    uint32_t                    sent;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void consumer_fn(void *);
+static void producer_fn(void *);
+static void post(nc_queue * queue, uint32_t sequence);
+static void drain(nc_queue * queue, size_t pending);
+static void test_empty_blocks(void);
+static void test_full(void);
+static void test_wrap(void);
+static void test_nested(void);
+static void test_pipeline(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+NC_QUEUE_DEFINE(g_queue, struct message, QUEUE_CAPACITY);
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void consumer_fn(void * stack_)
+{
+    struct consumer_stack *     stack = stack_;
+    struct message *            messages;
+    size_t                      count;
+
+    stack->runs++;
+    messages = nc_queue_peek(stack->queue, &count);
+
+    if (messages == NULL) {
+        TEST_ASSERT(count == 0u);
+
+        return;                                   /* Blocked by the queue */
+    }
+
+    if ((stack->max_batch != 0u) && (count > stack->max_batch)) {
+        count = stack->max_batch;
+    }
+
+    for (size_t itr = 0u; itr < count; itr++) {
+        TEST_ASSERT(messages[itr].sequence == stack->expected);
+        TEST_ASSERT(messages[itr].payload  == stack->expected * 3u);
+        stack->expected++;
+    }
+    stack->received += (uint32_t)count;
+    nc_queue_release(stack->queue, count);
+}
+
+static void producer_fn(void * stack_)
+{
+    struct producer_stack *     stack = stack_;
+
+    while (stack->sent != PIPELINE_MESSAGES) {
+        struct message *        message;
+
+        message = nc_queue_reserve(stack->queue);
+
+        if (message == NULL) {
+            return;                    /* Full, try again on next dispatch */
+        }
+        message->sequence = stack->sent;
+        message->payload  = stack->sent * 3u;
+        nc_queue_commit(stack->queue);
+        stack->sent++;
+    }
+    nc_thread_done();
+}
+
+static void post(nc_queue * queue, uint32_t sequence)
+{
+    struct message *            message;
+
+    message = nc_queue_reserve(queue);
+    TEST_ASSERT(message != NULL);
+    message->sequence = sequence;
+    message->payload  = sequence * 3u;
+    nc_queue_commit(queue);
+}
+
+/* Peek blocks the caller on an empty queue, so outside of threads only the
+ * known number of pending messages is read.
+ */
+static void drain(nc_queue * queue, size_t pending)
+{
+    while (pending != 0u) {
+        size_t                  count;
+
+        TEST_ASSERT(nc_queue_peek(queue, &count) != NULL);
+        TEST_ASSERT(count <= pending);
+        nc_queue_release(queue, count);
+        pending -= count;
+    }
+}
+
+/* The consumer blocks on an empty queue and the next commit readies it.
+ */
+static void test_empty_blocks(void)
+{
+    static struct consumer_stack stack;
+    nc_thread *                 consumer;
+
+    stack.queue = &g_queue;
+    consumer    = nc_thread_create(consumer_fn, &stack, 1u);
+    nc_queue_attach(&g_queue, consumer);
+    nc_thread_ready(consumer);
+    nc_schedule();
+    TEST_ASSERT(stack.runs == 1u);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_BLOCKED);
+
+    nc_thread_ready(consumer);           /* A stray wake-up blocks it again */
+    nc_schedule();
+    TEST_ASSERT(stack.runs == 2u);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_BLOCKED);
+
+    post(&g_queue, 0u);
+    post(&g_queue, 1u);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_READY);
+    nc_schedule();                 /* One batch, then blocks on empty queue */
+    TEST_ASSERT(stack.runs     == 4u);
+    TEST_ASSERT(stack.received == 2u);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_BLOCKED);
+    nc_queue_attach(&g_queue, NULL);
+    nc_thread_destroy(consumer);
+    printf("queue: empty queue blocks the consumer ok\n");
+}
+
+/* Reservations fail when all slots are reserved and succeed again after the
+ * consumer releases messages.
+ */
+static void test_full(void)
+{
+    struct message *            messages;
+    size_t                      count;
+
+    for (uint32_t itr = 0u; itr < QUEUE_CAPACITY; itr++) {
+        post(&g_queue, itr);
+    }
+    TEST_ASSERT(nc_queue_reserve(&g_queue) == NULL);
+    messages = nc_queue_peek(&g_queue, &count);
+    TEST_ASSERT(messages != NULL);
+    TEST_ASSERT(count > 0u);
+    nc_queue_release(&g_queue, 1u);
+    post(&g_queue, QUEUE_CAPACITY);
+    TEST_ASSERT(nc_queue_reserve(&g_queue) == NULL);
+    drain(&g_queue, QUEUE_CAPACITY);
+    printf("queue: full queue ok\n");
+}
+
+/* A batch ends at the end of the ring, the rest is returned by the next peek.
+ */
+static void test_wrap(void)
+{
+    struct message *            messages;
+    size_t                      count;
+    size_t                      first;
+
+    for (uint32_t itr = 0u; itr < 3u; itr++) {     /* Move away from slot 0 */
+        post(&g_queue, itr);
+    }
+    drain(&g_queue, 3u);
+
+    for (uint32_t itr = 0u; itr < QUEUE_CAPACITY; itr++) {
+        post(&g_queue, 100u + itr);
+    }
+    messages = nc_queue_peek(&g_queue, &count);
+    TEST_ASSERT(messages != NULL);
+    TEST_ASSERT(count < QUEUE_CAPACITY);
+    TEST_ASSERT(messages[0].sequence == 100u);
+    first = count;
+    nc_queue_release(&g_queue, count);
+    messages = nc_queue_peek(&g_queue, &count);
+    TEST_ASSERT(messages != NULL);
+    TEST_ASSERT(first + count == QUEUE_CAPACITY);
+    TEST_ASSERT(messages[0].sequence == 100u + first);
+    nc_queue_release(&g_queue, count);
+    printf("queue: batches stop at the end of the ring ok\n");
+}
+
+/* Nested reservations, like one made by an ISR while a thread writes its own
+ * message, become visible together when the outer one is committed.
+ */
+static void test_nested(void)
+{
+    static struct consumer_stack stack;
+    nc_thread *                 consumer;
+    struct message *            outer;
+    struct message *            inner;
+
+    stack.queue = &g_queue;
+    consumer    = nc_thread_create(consumer_fn, &stack, 1u);
+    nc_queue_attach(&g_queue, consumer);
+    nc_thread_ready(consumer);
+    nc_schedule();
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_BLOCKED);
+
+    outer = nc_queue_reserve(&g_queue);
+    inner = nc_queue_reserve(&g_queue);
+    TEST_ASSERT((outer != NULL) && (inner != NULL));
+    outer->sequence = 0u;
+    outer->payload  = 0u;
+    inner->sequence = 1u;
+    inner->payload  = 3u;
+    nc_queue_commit(&g_queue);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_BLOCKED);
+    nc_queue_commit(&g_queue);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_READY);
+    nc_schedule();
+    TEST_ASSERT(stack.received == 2u);
+    nc_queue_attach(&g_queue, NULL);
+    nc_thread_destroy(consumer);
+    printf("queue: nested reservations ok\n");
+}
+
+/* A producer passes more messages than the queue holds to a consumer which
+ * releases them in small batches. Order and content must be preserved.
+ */
+static void test_pipeline(void)
+{
+    static struct consumer_stack consumer_stack;
+    static struct producer_stack producer_stack;
+    nc_thread *                 consumer;
+    nc_thread *                 producer;
+
+    consumer_stack.queue     = &g_queue;
+    consumer_stack.max_batch = 3u;
+    producer_stack.queue     = &g_queue;
+    consumer = nc_thread_create(consumer_fn, &consumer_stack, 2u);
+    producer = nc_thread_create(producer_fn, &producer_stack, 1u);
+    nc_queue_attach(&g_queue, consumer);
+    nc_thread_ready(producer);
+    nc_schedule();
+    TEST_ASSERT(producer_stack.sent        == PIPELINE_MESSAGES);
+    TEST_ASSERT(consumer_stack.received    == PIPELINE_MESSAGES);
+    TEST_ASSERT(consumer_stack.expected    == PIPELINE_MESSAGES);
+    TEST_ASSERT(nc_thread_get_state(consumer) == NC_STATE_BLOCKED);
+    nc_queue_attach(&g_queue, NULL);
+    nc_thread_destroy(consumer);
+    printf("queue: producer/consumer pipeline ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_empty_blocks();
+    test_full();
+    test_wrap();
+    test_nested();
+    test_pipeline();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
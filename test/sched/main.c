@@ -0,0 +1,364 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Scheduler instance tests
+ * @details     Covers allocation of instances, separate thread pools and
+ *              ready lists, the current thread inside of an instance, threads
+ *              made ready across instances and budgets of an instance.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_port.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct worker
+{
+    char                        name;
+    uint32_t                    left;       /* Dispatches until done         */
+    nc_thread *                 thread;
+    nc_thread *                 wake;       /* Made ready when done          */
+};
+
+/* An instance which is executed by its own OS thread
+ */
+struct runner
+{
+    nc_sched *                  sched;
+    nc_thread *                 thread;
+    uint32_t                    runs;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void trace_reset(void);
+static void worker_fn(void *);
+static void worker_start(struct worker * worker, nc_sched * sched, char name,
+                uint32_t left);
+static void test_create(void);
+static void test_pools(void);
+static void test_isolation(void);
+static void test_cross_ready(void);
+static void test_budget(void);
+static void runner_fn(void *);
+static void * runner_main(void *);
+static void test_os_threads(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+static pthread_barrier_t        g_barrier;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void trace_reset(void)
+{
+    g_trace_size = 0u;
+    g_trace[0]   = '\0';
+}
+
+/* Checks that it is the current thread of the executed instance, then stays
+ * ready until the given number of dispatches is used up.
+ */
+static void worker_fn(void * stack)
+{
+    struct worker *             worker = stack;
+
+    TEST_ASSERT(nc_thread_get_current() == worker->thread);
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = worker->name;
+    g_trace[g_trace_size]   = '\0';
+
+    if (--worker->left == 0u) {
+        nc_thread_done();
+
+        if (worker->wake != NULL) {
+            nc_thread_ready(worker->wake);
+        }
+    }
+}
+
+static void worker_start(struct worker * worker, nc_sched * sched, char name,
+    uint32_t left)
+{
+    worker->name   = name;
+    worker->left   = left;
+    worker->wake   = NULL;
+    worker->thread = nc_sched_thread_create(sched, worker_fn, worker, 1u);
+    TEST_ASSERT(worker->thread != NULL);
+    nc_thread_ready(worker->thread);
+}
+
+/* The default instance is not allocated, other instances are reused after
+ * they are returned.
+ */
+static void test_create(void)
+{
+    nc_sched *                  first;
+    nc_sched *                  second;
+
+    first  = nc_sched_create();
+    second = nc_sched_create();
+    TEST_ASSERT((first != NULL) && (second != NULL) && (first != second));
+    TEST_ASSERT(first  != nc_sched_get_default());
+    TEST_ASSERT(second != nc_sched_get_default());
+    TEST_ASSERT(nc_sched_create() == NULL);
+
+    nc_sched_destroy(first);
+    TEST_ASSERT(nc_sched_create() == first);
+    nc_sched_destroy(first);
+    nc_sched_destroy(second);
+    printf("sched: create and destroy ok\n");
+}
+
+/* Each instance has its own thread pool, a destroyed instance comes back
+ * with an empty one.
+ */
+static void test_pools(void)
+{
+    nc_thread *                 threads[CONFIG_NC_NUM_OF_THREADS];
+    nc_thread *                 thread;
+    nc_sched *                  sched;
+
+    sched = nc_sched_create();
+    TEST_ASSERT(sched != NULL);
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_sched_thread_create(sched, worker_fn, NULL, 1u);
+        TEST_ASSERT(threads[itr] != NULL);
+    }
+    TEST_ASSERT(nc_sched_thread_create(sched, worker_fn, NULL, 1u) == NULL);
+    thread = nc_thread_create(worker_fn, NULL, 1u);     /* Default instance */
+    TEST_ASSERT(thread != NULL);
+    nc_thread_destroy(thread);
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    nc_sched_destroy(sched);
+    sched = nc_sched_create();
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_sched_thread_create(sched, worker_fn, NULL, 1u);
+        TEST_ASSERT(threads[itr] != NULL);
+        nc_thread_destroy(threads[itr]);
+    }
+    nc_sched_destroy(sched);
+    printf("sched: thread pools ok\n");
+}
+
+/* An instance executes only its own ready threads.
+ */
+static void test_isolation(void)
+{
+    static struct worker        workers[4];
+    nc_sched *                  first;
+    nc_sched *                  second;
+
+    first  = nc_sched_create();
+    second = nc_sched_create();
+    trace_reset();
+    worker_start(&workers[0], first,  'a', 2u);
+    worker_start(&workers[1], second, 'b', 2u);
+    worker_start(&workers[2], first,  'c', 2u);
+    worker_start(&workers[3], nc_sched_get_default(), 'd', 2u);
+
+    nc_sched_schedule(first);
+    TEST_ASSERT(strcmp(g_trace, "acac") == 0);
+    TEST_ASSERT(nc_thread_get_state(workers[1].thread) == NC_STATE_READY);
+    TEST_ASSERT(nc_thread_get_state(workers[3].thread) == NC_STATE_READY);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "acacdd") == 0);
+    nc_sched_schedule(second);
+    TEST_ASSERT(strcmp(g_trace, "acacddbb") == 0);
+    TEST_ASSERT(nc_thread_get_current() == NULL);
+
+    for (uint32_t itr = 0u; itr < 4u; itr++) {
+        nc_thread_destroy(workers[itr].thread);
+    }
+    nc_sched_destroy(first);
+    nc_sched_destroy(second);
+    printf("sched: isolation ok\n");
+}
+
+/* A thread made ready by a thread of other instance is executed by its own
+ * instance.
+ */
+static void test_cross_ready(void)
+{
+    static struct worker        waker;
+    static struct worker        woken;
+    nc_sched *                  first;
+    nc_sched *                  second;
+
+    first  = nc_sched_create();
+    second = nc_sched_create();
+    trace_reset();
+    worker_start(&woken, second, 'b', 1u);
+    nc_thread_block(woken.thread);                   /* Waits for the waker */
+    worker_start(&waker, first,  'a', 1u);
+    waker.wake = woken.thread;
+
+    nc_sched_schedule(first);
+    TEST_ASSERT(strcmp(g_trace, "a") == 0);
+    TEST_ASSERT(nc_thread_get_state(woken.thread) == NC_STATE_READY);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "a") == 0);
+    nc_sched_schedule(second);
+    TEST_ASSERT(strcmp(g_trace, "ab") == 0);
+
+    nc_thread_destroy(waker.thread);
+    nc_thread_destroy(woken.thread);
+    nc_sched_destroy(first);
+    nc_sched_destroy(second);
+    printf("sched: ready across instances ok\n");
+}
+
+static void test_budget(void)
+{
+    static struct worker        workers[2];
+    nc_sched *                  sched;
+
+    sched = nc_sched_create();
+    trace_reset();
+    worker_start(&workers[0], sched, 'a', 3u);
+    worker_start(&workers[1], nc_sched_get_default(), 'd', 1u);
+
+    TEST_ASSERT(nc_sched_schedule_for(sched, 2u, 0u));
+    TEST_ASSERT(strcmp(g_trace, "aa") == 0);
+    TEST_ASSERT(!nc_sched_schedule_for(sched, 2u, 0u));
+    TEST_ASSERT(strcmp(g_trace, "aaa") == 0);
+    TEST_ASSERT(!nc_sched_schedule_for(sched, 0u, 0u));
+    TEST_ASSERT(nc_thread_get_state(workers[1].thread) == NC_STATE_READY);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "aaad") == 0);
+
+    nc_thread_destroy(workers[0].thread);
+    nc_thread_destroy(workers[1].thread);
+    nc_sched_destroy(sched);
+    printf("sched: instance budget ok\n");
+}
+
+/* Waits until the other instance executes its thread too, so both instances
+ * are executed at the same time.
+ */
+static void runner_fn(void * stack)
+{
+    struct runner *             runner = stack;
+
+    pthread_barrier_wait(&g_barrier);
+    TEST_ASSERT(nc_thread_get_current() == runner->thread);
+    pthread_barrier_wait(&g_barrier);
+    TEST_ASSERT(nc_thread_get_current() == runner->thread);
+    runner->runs++;
+    nc_thread_done();
+}
+
+static void * runner_main(void * arg)
+{
+    struct runner *             runner = arg;
+
+    runner->thread = nc_sched_thread_create(runner->sched, runner_fn, runner,
+        1u);
+    TEST_ASSERT(runner->thread != NULL);
+    nc_thread_ready(runner->thread);
+    nc_sched_schedule(runner->sched);
+    TEST_ASSERT(nc_thread_get_current() == NULL);
+    nc_thread_destroy(runner->thread);
+
+    return (NULL);
+}
+
+/* With a single core each OS thread keeps track of the instance which it
+ * executes.
+ */
+static void test_os_threads(void)
+{
+    static struct runner        runners[2];
+    pthread_t                   threads[2];
+
+    TEST_ASSERT(pthread_barrier_init(&g_barrier, NULL, 2u) == 0);
+
+    for (uint32_t itr = 0u; itr < 2u; itr++) {
+        runners[itr].sched = nc_sched_create();
+        TEST_ASSERT(runners[itr].sched != NULL);
+    }
+
+    for (uint32_t itr = 0u; itr < 2u; itr++) {
+        TEST_ASSERT(pthread_create(&threads[itr], NULL, runner_main,
+            &runners[itr]) == 0);
+    }
+
+    for (uint32_t itr = 0u; itr < 2u; itr++) {
+        TEST_ASSERT(pthread_join(threads[itr], NULL) == 0);
+        TEST_ASSERT(runners[itr].runs == 1u);
+        nc_sched_destroy(runners[itr].sched);
+    }
+    pthread_barrier_destroy(&g_barrier);
+    printf("sched: instances in OS threads ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_create();
+    test_pools();
+    test_isolation();
+    test_cross_ready();
+    test_budget();
+    test_os_threads();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS != 3)
+# error "test_sched: the test needs exactly two additional instances."
+#endif
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0)
+# error "test_sched: the test needs fixed size thread pools."
+#endif
+
+#if (CONFIG_NC_NUM_OF_CORES != 1) || !defined(NCPU_THREAD_LOCAL)
+# error "test_sched: the test needs a single core and OS thread local data."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,269 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Counting semaphore tests
+ * @details     Covers counting of units, handing units over to waiters by
+ *              priority and in FIFO order within a priority, cancelling of
+ *              waiting and granted waiters and threads which are made ready
+ *              by something else than the semaphore while they wait.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_sem.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WAITERS                  5u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct waiter_stack
+{
+    nc_sem_waiter               waiter;
+    char                        name;
+    uint32_t                    runs;
+    uint32_t                    taken;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void       trace_reset(void);
+static void       waiter_fn(void *);
+static nc_thread * waiter_start(struct waiter_stack * stack, char name,
+                      uint_fast8_t priority);
+static void       test_count(void);
+static void       test_order(void);
+static void       test_handover(void);
+static void       test_cancel(void);
+static void       test_stray_ready(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static nc_sem                   g_sem;
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void trace_reset(void)
+{
+    g_trace_size = 0u;
+    g_trace[0]   = '\0';
+}
+
+/* Takes a unit and keeps it, then blocks itself so the test can inspect it.
+ */
+static void waiter_fn(void * stack_)
+{
+    struct waiter_stack *       stack = stack_;
+
+    stack->runs++;
+
+    if (nc_sem_take(&g_sem, &stack->waiter)) {
+        TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+        g_trace[g_trace_size++] = stack->name;
+        g_trace[g_trace_size]   = '\0';
+        stack->taken++;
+        nc_thread_block(nc_thread_get_current());
+    }
+}
+
+static nc_thread * waiter_start(struct waiter_stack * stack, char name,
+    uint_fast8_t priority)
+{
+    nc_thread *                 thread;
+
+    memset(stack, 0, sizeof(*stack));
+    stack->name = name;
+    thread      = nc_thread_create(waiter_fn, stack, priority);
+    TEST_ASSERT(thread != NULL);
+    nc_thread_ready(thread);
+    nc_schedule();
+
+    return (thread);
+}
+
+static void test_count(void)
+{
+    nc_sem_init(&g_sem, 2u);
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 2u);
+    TEST_ASSERT(nc_sem_try_take(&g_sem));
+    TEST_ASSERT(nc_sem_try_take(&g_sem));
+    TEST_ASSERT(!nc_sem_try_take(&g_sem));
+    nc_sem_give(&g_sem);
+    nc_sem_give(&g_sem);
+    nc_sem_give(&g_sem);
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 3u);
+    printf("sem: count ok\n");
+}
+
+/* Units go to the highest priority waiter first, waiters of the same priority
+ * get them in the order they started waiting.
+ */
+static void test_order(void)
+{
+    static const uint_fast8_t   priorities[NUM_OF_WAITERS] =
+    {
+        1u, 3u, 1u, 3u, 2u
+    };
+    static struct waiter_stack  stacks[NUM_OF_WAITERS];
+    nc_thread *                 threads[NUM_OF_WAITERS];
+
+    nc_sem_init(&g_sem, 0u);
+    trace_reset();
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WAITERS; itr++) {
+        threads[itr] = waiter_start(&stacks[itr], (char)('a' + itr),
+            priorities[itr]);
+        TEST_ASSERT(nc_thread_get_state(threads[itr]) == NC_STATE_BLOCKED);
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WAITERS; itr++) {
+        nc_sem_give(&g_sem);
+        nc_schedule();
+    }
+    TEST_ASSERT(strcmp(g_trace, "bdeac") == 0);
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 0u);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WAITERS; itr++) {
+        TEST_ASSERT((stacks[itr].runs == 2u) && (stacks[itr].taken == 1u));
+        nc_thread_destroy(threads[itr]);
+    }
+    printf("sem: priority and FIFO order ok\n");
+}
+
+/* A unit given to a waiter is not counted, so it can not be taken by other
+ * threads before the waiter is executed.
+ */
+static void test_handover(void)
+{
+    static struct waiter_stack  stack;
+    nc_thread *                 thread;
+
+    nc_sem_init(&g_sem, 0u);
+    trace_reset();
+    thread = waiter_start(&stack, 'a', 1u);
+    nc_sem_give(&g_sem);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_READY);
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 0u);
+    TEST_ASSERT(!nc_sem_try_take(&g_sem));
+    nc_schedule();
+    TEST_ASSERT((stack.runs == 2u) && (stack.taken == 1u));
+
+    nc_sem_give(&g_sem);                                /* Nobody is waiting */
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 1u);
+    nc_thread_destroy(thread);
+    printf("sem: hand over ok\n");
+}
+
+/* A cancelled waiter leaves the wait list, a unit which was already handed
+ * over to it goes to the next waiter.
+ */
+static void test_cancel(void)
+{
+    static struct waiter_stack  first;
+    static struct waiter_stack  second;
+    nc_thread *                 first_thread;
+    nc_thread *                 second_thread;
+
+    nc_sem_init(&g_sem, 0u);
+    trace_reset();
+    first_thread  = waiter_start(&first,  'a', 2u);
+    second_thread = waiter_start(&second, 'b', 1u);
+    nc_sem_cancel(&g_sem, &first.waiter);
+    nc_sem_give(&g_sem);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "b") == 0);
+    TEST_ASSERT(first.runs == 1u);
+
+    nc_thread_ready(first_thread);                         /* Wait again */
+    nc_thread_ready(second_thread);
+    nc_schedule();
+    TEST_ASSERT((first.runs == 2u) && (second.runs == 3u));
+    nc_sem_give(&g_sem);                                  /* Granted to 'a' */
+    nc_sem_cancel(&g_sem, &first.waiter);                 /* Passed to 'b' */
+    nc_sem_cancel(&g_sem, &first.waiter);                 /* Has no effect */
+    nc_thread_block(first_thread);
+    nc_schedule();
+    TEST_ASSERT(strcmp(g_trace, "bb") == 0);
+    TEST_ASSERT((first.taken == 0u) && (second.taken == 2u));
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 0u);
+
+    nc_sem_give(&g_sem);                                /* Nobody is waiting */
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 1u);
+    nc_thread_destroy(first_thread);
+    nc_thread_destroy(second_thread);
+    printf("sem: cancel ok\n");
+}
+
+/* A waiting thread which is made ready by something else blocks again and it
+ * stays in the wait list only once.
+ */
+static void test_stray_ready(void)
+{
+    static struct waiter_stack  stack;
+    nc_thread *                 thread;
+
+    nc_sem_init(&g_sem, 0u);
+    thread = waiter_start(&stack, 'a', 1u);
+    nc_thread_ready(thread);
+    TEST_ASSERT(!nc_schedule_for(1000u, 0u));
+    TEST_ASSERT(stack.runs == 2u);
+    TEST_ASSERT(nc_thread_get_state(thread) == NC_STATE_BLOCKED);
+
+    nc_sem_give(&g_sem);
+    nc_schedule();
+    TEST_ASSERT((stack.runs == 3u) && (stack.taken == 1u));
+    nc_sem_give(&g_sem);
+    TEST_ASSERT(nc_sem_get_count(&g_sem) == 1u);
+    nc_thread_destroy(thread);
+    printf("sem: stray wake-up blocks again ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_count();
+    test_order();
+    test_handover();
+    test_cancel();
+    test_stray_ready();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,296 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Arena and slab allocator tests
+ * @details     Covers alignment and reuse of arena chunks after a reset,
+ *              oversized allocations, the slab free list, the size taken from
+ *              the first allocation, and threads allocated from the built-in
+ *              slab of an instance and from an application allocator.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_slab.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define CHUNK_SIZE                      256u
+#define NUM_OF_ALLOCS                   64u
+#define NUM_OF_THREADS                  100u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+/**@brief       Counting allocator on top of a slab
+ */
+struct counting
+{
+    nc_slab                     slab;
+    uint32_t                    allocs;
+    uint32_t                    frees;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void * counting_alloc(void * context, size_t size);
+static void counting_free(void * context, void * mem);
+static void worker_fn(void *);
+static void test_arena(void);
+static void test_oversized(void);
+static void test_slab(void);
+static void test_first_size(void);
+static void test_threads(void);
+static void test_allocator(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static uint32_t                 g_runs;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void * counting_alloc(void * context, size_t size)
+{
+    struct counting *           counting = context;
+
+    counting->allocs++;
+
+    return (nc_slab_allocator_alloc(&counting->slab, size));
+}
+
+static void counting_free(void * context, void * mem)
+{
+    struct counting *           counting = context;
+
+    counting->frees++;
+    nc_slab_allocator_free(&counting->slab, mem);
+}
+
+static void worker_fn(void * stack)
+{
+    (void)stack;
+    g_runs++;
+    nc_thread_done();
+}
+
+/* Allocations are aligned and do not overlap, a reset arena hands out the
+ * same memory again from the kept chunks.
+ */
+static void test_arena(void)
+{
+    nc_arena                    arena;
+    uint8_t *                   allocs[NUM_OF_ALLOCS];
+
+    nc_arena_init(&arena, CHUNK_SIZE);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_ALLOCS; itr++) {
+        allocs[itr] = nc_arena_alloc(&arena, 1u + itr % 24u);
+        TEST_ASSERT(allocs[itr] != NULL);
+        TEST_ASSERT(((uintptr_t)allocs[itr] % __alignof__(long double)) == 0u);
+        memset(allocs[itr], (int)itr, 1u + itr % 24u);
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_ALLOCS; itr++) {
+        for (uint32_t byte = 0u; byte < 1u + itr % 24u; byte++) {
+            TEST_ASSERT(allocs[itr][byte] == (uint8_t)itr);
+        }
+    }
+    nc_arena_reset(&arena);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_ALLOCS; itr++) {
+        TEST_ASSERT(nc_arena_alloc(&arena, 1u + itr % 24u) == allocs[itr]);
+    }
+    nc_arena_term(&arena);
+    printf("slab: arena ok\n");
+}
+
+/* An allocation bigger than the chunk size gets its own chunk.
+ */
+static void test_oversized(void)
+{
+    nc_arena                    arena;
+    uint8_t *                   small;
+    uint8_t *                   big;
+
+    nc_arena_init(&arena, CHUNK_SIZE);
+    small = nc_arena_alloc(&arena, 8u);
+    big   = nc_arena_alloc(&arena, CHUNK_SIZE * 4u);
+    TEST_ASSERT((small != NULL) && (big != NULL));
+    memset(big, 0xaa, CHUNK_SIZE * 4u);
+    TEST_ASSERT(nc_arena_alloc(&arena, 8u) != NULL);
+
+    nc_arena_reset(&arena);
+    TEST_ASSERT(nc_arena_alloc(&arena, 8u) == small);
+    TEST_ASSERT(nc_arena_alloc(&arena, CHUNK_SIZE * 4u) == big);
+    nc_arena_term(&arena);
+    printf("slab: oversized allocation ok\n");
+}
+
+/* Freed objects are reused first, objects smaller than a pointer still have
+ * room for the free list link.
+ */
+static void test_slab(void)
+{
+    nc_slab                     slab;
+    uint8_t *                   objects[NUM_OF_ALLOCS];
+
+    nc_slab_init(&slab, 1u, CHUNK_SIZE);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_ALLOCS; itr++) {
+        objects[itr] = nc_slab_alloc(&slab);
+        TEST_ASSERT(objects[itr] != NULL);
+
+        for (uint32_t other = 0u; other < itr; other++) {
+            TEST_ASSERT(objects[other] != objects[itr]);
+        }
+    }
+    nc_slab_free(&slab, objects[3]);
+    nc_slab_free(&slab, objects[7]);
+    TEST_ASSERT(nc_slab_alloc(&slab) == objects[7]);
+    TEST_ASSERT(nc_slab_alloc(&slab) == objects[3]);
+
+    nc_slab_free(&slab, objects[5]);         /* Reset drops the free list too */
+    nc_slab_reset(&slab);
+    TEST_ASSERT(nc_slab_alloc(&slab) == objects[0]);
+    TEST_ASSERT(nc_slab_alloc(&slab) == objects[1]);
+    nc_slab_term(&slab);
+    TEST_ASSERT(nc_slab_alloc(&slab) != NULL);
+    nc_slab_term(&slab);
+    printf("slab: free list ok\n");
+}
+
+static void test_first_size(void)
+{
+    static nc_slab              slab;                    /* Zero initialized */
+    void *                      object;
+
+    object = nc_slab_allocator_alloc(&slab, 48u);
+    TEST_ASSERT(object != NULL);
+    TEST_ASSERT(nc_slab_allocator_alloc(&slab, 49u) == NULL);
+    TEST_ASSERT(nc_slab_allocator_alloc(&slab, 16u) != NULL);
+    nc_slab_allocator_free(&slab, object);
+    TEST_ASSERT(nc_slab_allocator_alloc(&slab, 48u) == object);
+    nc_slab_term(&slab);
+    printf("slab: size of the first allocation ok\n");
+}
+
+/* Threads of an instance come from its own slab, destroyed threads are
+ * reused.
+ */
+static void test_threads(void)
+{
+    nc_thread *                 threads[NUM_OF_THREADS];
+    nc_thread *                 reused;
+    nc_sched *                  sched;
+
+    sched  = nc_sched_create();
+    TEST_ASSERT(sched != NULL);
+    g_runs = 0u;
+
+    for (uint32_t itr = 0u; itr < NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_sched_thread_create(sched, worker_fn, NULL, 1u);
+        TEST_ASSERT(threads[itr] != NULL);
+        nc_thread_ready(threads[itr]);
+    }
+    nc_sched_schedule(sched);
+    TEST_ASSERT(g_runs == NUM_OF_THREADS);
+
+    nc_thread_destroy(threads[10]);
+    reused = nc_sched_thread_create(sched, worker_fn, NULL, 1u);
+    TEST_ASSERT(reused == threads[10]);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    nc_sched_destroy(sched);
+    printf("slab: threads from the instance slab ok\n");
+}
+
+/* The default instance uses the application allocator.
+ */
+static void test_allocator(void)
+{
+    static struct counting      counting;
+    static const nc_allocator   allocator =
+    {
+        counting_alloc,
+        counting_free,
+        &counting
+    };
+    nc_thread *                 threads[NUM_OF_THREADS];
+
+    nc_sched_set_allocator(nc_sched_get_default(), &allocator);
+    g_runs = 0u;
+
+    for (uint32_t itr = 0u; itr < NUM_OF_THREADS; itr++) {
+        threads[itr] = nc_thread_create(worker_fn, NULL, 1u);
+        TEST_ASSERT(threads[itr] != NULL);
+        nc_thread_ready(threads[itr]);
+    }
+    nc_schedule();
+    TEST_ASSERT(g_runs == NUM_OF_THREADS);
+    TEST_ASSERT(counting.allocs == NUM_OF_THREADS);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_THREADS; itr++) {
+        nc_thread_destroy(threads[itr]);
+    }
+    TEST_ASSERT(counting.frees == NUM_OF_THREADS);
+    nc_slab_term(&counting.slab);
+    printf("slab: application allocator ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_arena();
+    test_oversized();
+    test_slab();
+    test_first_size();
+    test_threads();
+    test_allocator();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_THREADS != 0)
+# error "test_slab: the test needs threads allocated at run time."
+#endif
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS < 2)
+# error "test_slab: the test needs an additional scheduler instance."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,188 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Multi-core scheduler throughput benchmark
+ * @details     All worker threads are created on core 0. Other cores start
+ *              empty and get their work by stealing. The benchmark reports
+ *              the number of dispatches per second for 1, 2, 4... cores.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nanocoop.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WORKERS                  64
+#define NUM_OF_WORKER_PRIOS             4
+#define WORK_ITERATIONS                 200
+#define RUN_TIME_MS                     500
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct worker_stack
+{
+    uint64_t                    dispatches;
+    uint32_t                    seed;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void   worker_fn(void *);
+static void * core_fn(void *);
+static double run(uint_fast8_t num_of_cores);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static nc_thread *              g_workers[NUM_OF_WORKERS];
+static struct worker_stack      g_worker_stacks[NUM_OF_WORKERS];
+static volatile bool            g_should_stop;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void worker_fn(void * stack_)
+{
+    struct worker_stack * stack = stack_;
+
+    /* Simulate some work so the dispatch is not only lock traffic.
+     */
+    for (uint32_t itr = 0; itr < WORK_ITERATIONS; itr++) {
+        stack->seed = stack->seed * 1103515245u + 12345u;
+    }
+    stack->dispatches++;
+
+    if (g_should_stop) {
+        nc_thread_done();
+    }
+}
+
+static void * core_fn(void * arg)
+{
+    uint_fast8_t                core = (uint_fast8_t)(uintptr_t)arg;
+    cpu_set_t                   cpu_set;
+
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    nc_core_attach(core);
+
+    while (!g_should_stop) {
+        nc_schedule();
+    }
+    nc_schedule();                            /* Drain the remaining threads */
+
+    return (NULL);
+}
+
+static double run(uint_fast8_t num_of_cores)
+{
+    pthread_t                   cores[CONFIG_NC_NUM_OF_CORES];
+    struct timespec             sleep_time;
+    uint64_t                    dispatches;
+
+    g_should_stop = false;
+
+    for (uint32_t itr = 0; itr < NUM_OF_WORKERS; itr++) {
+        g_worker_stacks[itr].dispatches = 0u;
+        g_worker_stacks[itr].seed       = itr;
+        g_workers[itr] = nc_thread_create(
+            worker_fn,
+            &g_worker_stacks[itr],
+            (uint_fast8_t)(itr % NUM_OF_WORKER_PRIOS));
+
+        if (g_workers[itr] == NULL) {
+            fprintf(stderr, "Failed to create worker thread\n");
+            exit(1);
+        }
+        nc_thread_ready(g_workers[itr]);
+    }
+
+    for (uint_fast8_t core = 0; core < num_of_cores; core++) {
+        pthread_create(&cores[core], NULL, core_fn, (void *)(uintptr_t)core);
+    }
+    sleep_time.tv_sec  = RUN_TIME_MS / 1000;
+    sleep_time.tv_nsec = (RUN_TIME_MS % 1000) * 1000000l;
+    nanosleep(&sleep_time, NULL);
+    g_should_stop = true;
+
+    for (uint_fast8_t core = 0; core < num_of_cores; core++) {
+        pthread_join(cores[core], NULL);
+    }
+    dispatches = 0u;
+
+    for (uint32_t itr = 0; itr < NUM_OF_WORKERS; itr++) {
+        dispatches += g_worker_stacks[itr].dispatches;
+        nc_thread_destroy(g_workers[itr]);
+    }
+
+    return ((double)dispatches * 1000.0 / RUN_TIME_MS);
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    long                        num_of_cpus;
+    double                      base_rate;
+
+    num_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    base_rate   = 0.0;
+    printf("cores,dispatches_per_sec,speedup\n");
+
+    for (uint_fast8_t cores = 1;
+         (cores <= CONFIG_NC_NUM_OF_CORES) && (cores <= num_of_cpus);
+         cores *= 2u) {
+        double                  rate;
+
+        rate = run(cores);
+
+        if (cores == 1u) {
+            base_rate = rate;
+        }
+        printf("%u,%.0f,%.2f\n", (unsigned)cores, rate, rate / base_rate);
+    }
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_NUM_OF_THREADS != 0) && (CONFIG_NC_NUM_OF_THREADS < NUM_OF_WORKERS)
+# error "smp_bench: CONFIG_NC_NUM_OF_THREADS is too small for the benchmark."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,220 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Hot/cold thread split tests
+ * @details     Covers delay timers and statistics kept in the cold array for
+ *              every thread of the pool, reuse of a pool slot and threads of
+ *              an additional scheduler instance.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_timer.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_SLEEPERS                 CONFIG_NC_NUM_OF_THREADS
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct sleeper
+{
+    char                        name;
+    nc_tick                     ticks;
+    bool                        is_woken;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void sleeper_fn(void *);
+static void test_pool(void);
+static void test_reuse(void);
+static void test_instance(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct sleeper           g_sleepers[NUM_OF_SLEEPERS];
+static char                     g_trace[NUM_OF_SLEEPERS + 1u];
+static size_t                   g_trace_size;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Delays on the first dispatch, records its name when it is woken.
+ */
+static void sleeper_fn(void * stack)
+{
+    struct sleeper *            sleeper = stack;
+
+    if (!sleeper->is_woken) {
+        sleeper->is_woken = true;
+        nc_thread_delay(sleeper->ticks);
+
+        return;
+    }
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = sleeper->name;
+    g_trace[g_trace_size]   = '\0';
+    nc_thread_done();
+}
+
+/* Each pool thread has its own delay and statistics. Later threads delay
+ * shorter, so they wake first.
+ */
+static void test_pool(void)
+{
+    nc_thread *                 threads[NUM_OF_SLEEPERS];
+    char                        expected[NUM_OF_SLEEPERS + 1u];
+
+    g_trace_size = 0u;
+
+    for (uint32_t itr = 0u; itr < NUM_OF_SLEEPERS; itr++) {
+        g_sleepers[itr].name     = (char)('a' + itr);
+        g_sleepers[itr].ticks    = (nc_tick)(3u * (NUM_OF_SLEEPERS - itr));
+        g_sleepers[itr].is_woken = false;
+        threads[itr] = nc_thread_create(sleeper_fn, &g_sleepers[itr], 1u);
+        TEST_ASSERT(threads[itr] != NULL);
+        nc_thread_ready(threads[itr]);
+        expected[NUM_OF_SLEEPERS - 1u - itr] = g_sleepers[itr].name;
+    }
+    expected[NUM_OF_SLEEPERS] = '\0';
+    nc_schedule();
+
+    for (uint32_t itr = 0u; itr < 3u * NUM_OF_SLEEPERS; itr++) {
+        nc_timer_tick();
+        nc_schedule();
+        TEST_ASSERT(g_trace_size == (itr + 1u) / 3u);
+    }
+    TEST_ASSERT(strcmp(g_trace, expected) == 0);
+
+    for (uint32_t itr = 0u; itr < NUM_OF_SLEEPERS; itr++) {
+        nc_thread_stats         stats;
+
+        nc_thread_get_stats(threads[itr], &stats);
+        TEST_ASSERT(stats.fn == sleeper_fn);
+        TEST_ASSERT(stats.dispatches == 2u);
+        nc_thread_destroy(threads[itr]);
+    }
+    printf("split: pool delays and statistics ok\n");
+}
+
+/* A thread destroyed while delayed does not leave its timer or statistics to
+ * the next thread in the same slot.
+ */
+static void test_reuse(void)
+{
+    nc_thread *                 thread;
+    nc_thread *                 reused;
+    nc_thread_stats             stats;
+
+    g_sleepers[0].ticks    = 5u;
+    g_sleepers[0].is_woken = false;
+    thread = nc_thread_create(sleeper_fn, &g_sleepers[0], 1u);
+    TEST_ASSERT(thread != NULL);
+    nc_thread_ready(thread);
+    nc_schedule();
+    nc_thread_destroy(thread);
+    reused = nc_thread_create(sleeper_fn, &g_sleepers[1], 1u);
+    TEST_ASSERT(reused == thread);
+    nc_thread_get_stats(reused, &stats);
+    TEST_ASSERT(stats.dispatches == 0u);
+
+    for (uint32_t itr = 0u; itr < 10u; itr++) {
+        nc_timer_tick();
+        TEST_ASSERT(nc_thread_get_state(reused) == NC_STATE_IDLE);
+    }
+    nc_thread_destroy(reused);
+    printf("split: slot reuse ok\n");
+}
+
+/* Threads of an additional instance use the cold array of that instance.
+ */
+static void test_instance(void)
+{
+    nc_sched *                  sched;
+    nc_thread *                 thread;
+    nc_thread_stats             stats;
+
+    sched = nc_sched_create();
+    TEST_ASSERT(sched != NULL);
+    g_trace_size           = 0u;
+    g_sleepers[0].ticks    = 3u;
+    g_sleepers[0].is_woken = false;
+    thread = nc_sched_thread_create(sched, sleeper_fn, &g_sleepers[0], 1u);
+    TEST_ASSERT(thread != NULL);
+    nc_thread_ready(thread);
+    nc_sched_schedule(sched);
+
+    for (uint32_t itr = 0u; itr < 3u; itr++) {
+        TEST_ASSERT(g_trace_size == 0u);
+        nc_timer_tick();
+        nc_sched_schedule(sched);
+    }
+    TEST_ASSERT(strcmp(g_trace, "a") == 0);
+    nc_thread_get_stats(thread, &stats);
+    TEST_ASSERT(stats.dispatches == 2u);
+    nc_thread_destroy(thread);
+    nc_sched_destroy(sched);
+    printf("split: scheduler instance ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_pool();
+    test_reuse();
+    test_instance();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_THREAD_SPLIT != 1)
+# error "test_split: the test needs CONFIG_NC_THREAD_SPLIT."
+#endif
+
+#if (CONFIG_NC_TIMER != 1) || (CONFIG_NC_PROFILE != 1)
+# error "test_split: the test needs CONFIG_NC_TIMER and CONFIG_NC_PROFILE."
+#endif
+
+#if (CONFIG_NC_NUM_OF_SCHEDULERS < 2)
+# error "test_split: the test needs an additional scheduler instance."
+#endif
+
+#if (CONFIG_NC_NUM_OF_THREADS == 0) || (CONFIG_NC_NUM_OF_THREADS > 26)
+# error "test_split: the test needs a small static thread pool."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,349 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Timer wheel tests
+ * @details     Covers the expiry tick of timers on the first wheel level,
+ *              cascading across a level boundary, cancelling of a cascaded
+ *              timer, periodic reload, skipping of empty ticks and the idle
+ *              ticks estimate.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanocoop.h"
+#include "nc_timer.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_TIMERS                   3u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void idle_fn(void *);
+static void sleeper_fn(void *);
+static void threads_create(void);
+static void threads_destroy(void);
+static bool take(nc_thread * thread);
+static void test_insert(void);
+static void test_cascade(void);
+static void test_cancel_cascaded(void);
+static void test_periodic(void);
+static void test_delay_early(void);
+static void test_advance(void);
+static void test_idle_ticks(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static nc_thread *              g_thread[NUM_OF_TIMERS];
+static nc_timer                 g_timer[NUM_OF_TIMERS];
+static nc_tick                  g_delay_left;
+static uint32_t                 g_dispatches;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Threads of timers are never scheduled, only their state is checked.
+ */
+static void idle_fn(void * stack)
+{
+    (void)stack;
+    nc_thread_done();
+}
+
+/* Delays on the first dispatch and finishes on the second one.
+ */
+static void sleeper_fn(void * stack)
+{
+    (void)stack;
+
+    if (g_dispatches++ == 0u) {
+        nc_thread_delay(5u);
+    } else {
+        g_delay_left = nc_thread_delay_left();
+        nc_thread_done();
+    }
+}
+
+static void threads_create(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+        g_thread[itr] = nc_thread_create(idle_fn, NULL, 1u);
+        TEST_ASSERT(g_thread[itr] != NULL);
+        nc_timer_init(&g_timer[itr]);
+    }
+}
+
+static void threads_destroy(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+        nc_timer_cancel(&g_timer[itr]);
+        nc_thread_destroy(g_thread[itr]);
+    }
+}
+
+/* Was the thread made ready by its timer? The thread is blocked again, so the
+ * next expiry can be noticed.
+ */
+static bool take(nc_thread * thread)
+{
+    if (nc_thread_get_state(thread) == NC_STATE_READY) {
+        nc_thread_block(thread);
+
+        return (true);
+    }
+
+    return (false);
+}
+
+/* Each timer on the first level expires on exactly its tick.
+ */
+static void test_insert(void)
+{
+    static const nc_tick        ticks[NUM_OF_TIMERS] = { 1u, 3u, 15u };
+    nc_tick                     fired[NUM_OF_TIMERS] = { 0u, 0u, 0u };
+
+    threads_create();
+
+    for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+        nc_timer_start(&g_timer[itr], g_thread[itr], ticks[itr], 0u);
+        TEST_ASSERT(nc_timer_is_pending(&g_timer[itr]));
+    }
+
+    for (nc_tick tick = 1u; tick <= 20u; tick++) {
+        nc_timer_tick();
+
+        for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+            if (take(g_thread[itr])) {
+                TEST_ASSERT(fired[itr] == 0u);
+                fired[itr] = tick;
+            }
+        }
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+        TEST_ASSERT(fired[itr] == ticks[itr]);
+        TEST_ASSERT(!nc_timer_is_pending(&g_timer[itr]));
+    }
+    threads_destroy();
+    printf("timer: insert ok\n");
+}
+
+/* Timers on the second and third levels are cascaded down and expire on
+ * exactly their tick. The base is moved off a level boundary first.
+ */
+static void test_cascade(void)
+{
+    static const nc_tick        ticks[NUM_OF_TIMERS] = { 16u, 40u, 300u };
+    nc_tick                     fired[NUM_OF_TIMERS] = { 0u, 0u, 0u };
+
+    threads_create();
+
+    for (uint32_t itr = 0u; itr < 5u; itr++) {
+        nc_timer_tick();
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+        nc_timer_start(&g_timer[itr], g_thread[itr], ticks[itr], 0u);
+    }
+
+    for (nc_tick tick = 1u; tick <= 310u; tick++) {
+        nc_timer_tick();
+
+        for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+            if (take(g_thread[itr])) {
+                TEST_ASSERT(fired[itr] == 0u);
+                fired[itr] = tick;
+            }
+        }
+    }
+
+    for (uint32_t itr = 0u; itr < NUM_OF_TIMERS; itr++) {
+        TEST_ASSERT(fired[itr] == ticks[itr]);
+    }
+    threads_destroy();
+    printf("timer: cascade ok\n");
+}
+
+/* A timer which was already cascaded to a lower level is removed from there.
+ */
+static void test_cancel_cascaded(void)
+{
+    threads_create();
+    nc_timer_start(&g_timer[0], g_thread[0], 40u, 0u);
+
+    for (uint32_t itr = 0u; itr < 33u; itr++) {
+        nc_timer_tick();
+    }
+    TEST_ASSERT(nc_timer_is_pending(&g_timer[0]));
+    nc_timer_cancel(&g_timer[0]);
+    TEST_ASSERT(!nc_timer_is_pending(&g_timer[0]));
+
+    for (uint32_t itr = 0u; itr < 20u; itr++) {
+        nc_timer_tick();
+        TEST_ASSERT(!take(g_thread[0]));
+    }
+    threads_destroy();
+    printf("timer: cancel after cascade ok\n");
+}
+
+/* A periodic timer first expires after its ticks, then after each period.
+ */
+static void test_periodic(void)
+{
+    uint32_t                    expiries;
+
+    threads_create();
+    nc_timer_start(&g_timer[0], g_thread[0], 3u, 5u);
+    expiries = 0u;
+
+    for (nc_tick tick = 1u; tick <= 40u; tick++) {
+        nc_timer_tick();
+
+        if (take(g_thread[0])) {
+            TEST_ASSERT((tick >= 3u) && (((tick - 3u) % 5u) == 0u));
+            expiries++;
+        }
+    }
+    TEST_ASSERT(expiries == 8u);
+    TEST_ASSERT(nc_timer_is_pending(&g_timer[0]));
+    nc_timer_cancel(&g_timer[0]);
+    threads_destroy();
+    printf("timer: periodic reload ok\n");
+}
+
+/* A thread made ready before its delay expires sees the ticks left and is not
+ * made ready again by the cancelled delay.
+ */
+static void test_delay_early(void)
+{
+    nc_thread *                 sleeper;
+
+    sleeper = nc_thread_create(sleeper_fn, NULL, 1u);
+    TEST_ASSERT(sleeper != NULL);
+    g_dispatches = 0u;
+    nc_thread_ready(sleeper);
+    nc_schedule();
+    TEST_ASSERT(nc_thread_get_state(sleeper) == NC_STATE_BLOCKED);
+    nc_timer_tick();
+    nc_timer_tick();
+    nc_thread_ready(sleeper);
+    nc_schedule();
+    TEST_ASSERT(g_dispatches == 2u);
+    TEST_ASSERT(g_delay_left == 3u);
+
+    for (uint32_t itr = 0u; itr < 10u; itr++) {
+        nc_timer_tick();
+        TEST_ASSERT(nc_thread_get_state(sleeper) != NC_STATE_READY);
+    }
+    nc_thread_destroy(sleeper);
+    printf("timer: delay made ready early ok\n");
+}
+
+/* Advancing by many ticks at once expires timers on the same ticks as
+ * ticking one by one.
+ */
+static void test_advance(void)
+{
+    nc_tick                     base;
+
+    threads_create();
+    base = nc_timer_get_ticks();
+    nc_timer_start(&g_timer[0], g_thread[0], 10u, 0u);
+    nc_timer_start(&g_timer[1], g_thread[1], 500u, 0u);
+    nc_timer_advance(9u);
+    TEST_ASSERT(nc_timer_get_ticks() == base + 9u);
+    TEST_ASSERT(!take(g_thread[0]));
+    nc_timer_advance(1u);
+    TEST_ASSERT(take(g_thread[0]));
+    TEST_ASSERT(!take(g_thread[1]));
+    nc_timer_advance(489u);
+    TEST_ASSERT(!take(g_thread[1]));
+    nc_timer_advance(1u);
+    TEST_ASSERT(take(g_thread[1]));
+    TEST_ASSERT(nc_timer_get_ticks() == base + 500u);
+    nc_timer_advance(1000u);                         /* Nothing is pending */
+    TEST_ASSERT(nc_timer_get_ticks() == base + 1500u);
+    threads_destroy();
+    printf("timer: advance skips empty ticks ok\n");
+}
+
+/* The estimate is exact for timers on the first level and never later than
+ * the expiry for longer timers.
+ */
+static void test_idle_ticks(void)
+{
+    nc_tick                     left;
+
+    threads_create();
+    TEST_ASSERT(nc_timer_idle_ticks() == NC_TIMER_INFINITE);
+    nc_timer_start(&g_timer[0], g_thread[0], 7u, 0u);
+    TEST_ASSERT(nc_timer_idle_ticks() == 7u);
+    nc_timer_cancel(&g_timer[0]);
+    nc_timer_start(&g_timer[1], g_thread[1], 1000u, 0u);
+    left = 1000u;
+
+    while (!take(g_thread[1])) {         /* Sleep as long as it is allowed */
+        nc_tick                 ticks;
+
+        ticks = nc_timer_idle_ticks();
+        TEST_ASSERT((ticks >= 1u) && (ticks <= left));
+        nc_timer_advance(ticks);
+        left -= ticks;
+    }
+    TEST_ASSERT(left == 0u);
+    TEST_ASSERT(nc_timer_idle_ticks() == NC_TIMER_INFINITE);
+    threads_destroy();
+    printf("timer: idle ticks ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_insert();
+    test_cascade();
+    test_cancel_cascaded();
+    test_periodic();
+    test_delay_early();
+    test_advance();
+    test_idle_ticks();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_TIMER != 1)
+# error "test_timer: the test needs CONFIG_NC_TIMER."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
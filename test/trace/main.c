@@ -0,0 +1,212 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Trace recorder tests
+ * @details     Covers the buffer header, the records of a thread life cycle
+ *              and wrapping of the ring. The last buffer is dumped into a file
+ *              given as the argument, so the make run target can feed it to
+ *              the converter.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanocoop.h"
+#include "nc_trace.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define CLOCK_HZ                        1000000000u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void worker_fn(void *);
+static void record_check(uint32_t sequence, nc_trace_event event,
+                         uint32_t thread, nc_thread_state state);
+static void test_header(void);
+static void test_life_cycle(void);
+static void test_wrap(void);
+static void dump(const char * name);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+static void worker_fn(void * stack)
+{
+    (void)stack;
+    nc_thread_done();
+}
+
+static void record_check(uint32_t sequence, nc_trace_event event,
+                         uint32_t thread, nc_thread_state state)
+{
+    const nc_trace_buffer *     buffer = nc_trace_get_buffer();
+    const nc_trace_record *     record;
+
+    record = &buffer->records[sequence % buffer->capacity];
+    TEST_ASSERT(record->event == (uint8_t)event);
+    TEST_ASSERT(record->thread == thread);
+    TEST_ASSERT(record->priority == 7u);
+    TEST_ASSERT(record->core == 0u);
+    TEST_ASSERT(record->state == (uint8_t)state);
+}
+
+/* The header describes the dump format.
+ */
+static void test_header(void)
+{
+    const nc_trace_buffer *     buffer = nc_trace_get_buffer();
+
+    nc_trace_init(CLOCK_HZ);
+    TEST_ASSERT(buffer->magic == NC_TRACE_MAGIC);
+    TEST_ASSERT(buffer->version == NC_TRACE_VERSION);
+    TEST_ASSERT(buffer->record_size == 16u);
+    TEST_ASSERT(buffer->capacity == CONFIG_NC_TRACE_SIZE);
+    TEST_ASSERT(buffer->head == 0u);
+    TEST_ASSERT(buffer->clock_hz == CLOCK_HZ);
+    printf("trace: header ok\n");
+}
+
+/* Each scheduler event of a thread is recorded in order with increasing
+ * timestamps.
+ */
+static void test_life_cycle(void)
+{
+    static const nc_trace_event events[] =
+    {
+        NC_TRACE_CREATE,
+        NC_TRACE_READY,
+        NC_TRACE_DISPATCH_BEGIN,
+        NC_TRACE_BLOCK,
+        NC_TRACE_DISPATCH_END,
+        NC_TRACE_BLOCK,
+        NC_TRACE_DESTROY
+    };
+    static const nc_thread_state states[] =
+    {
+        NC_STATE_IDLE,
+        NC_STATE_READY,
+        NC_STATE_READY,                     /* Before it is switched to run */
+        NC_STATE_BLOCKED,
+        NC_STATE_BLOCKED,
+        NC_STATE_BLOCKED,                   /* Destroy blocks it first      */
+        NC_STATE_BLOCKED
+    };
+    const nc_trace_buffer *     buffer = nc_trace_get_buffer();
+    nc_thread *                 thread;
+    uint32_t                    id;
+
+    nc_trace_init(CLOCK_HZ);
+    thread = nc_thread_create(worker_fn, NULL, 7u);
+    TEST_ASSERT(thread != NULL);
+    nc_thread_ready(thread);
+    nc_schedule();
+    nc_thread_destroy(thread);
+    TEST_ASSERT(buffer->head == sizeof(events) / sizeof(events[0]));
+    id = buffer->records[0].thread;
+
+    for (uint32_t itr = 0u; itr < buffer->head; itr++) {
+        record_check(itr, events[itr], id, states[itr]);
+
+        if (itr != 0u) {
+            TEST_ASSERT(buffer->records[itr].timestamp >=
+                        buffer->records[itr - 1u].timestamp);
+        }
+    }
+    printf("trace: thread life cycle ok\n");
+}
+
+/* When the ring is full the oldest records are overwritten and the head
+ * keeps counting.
+ */
+static void test_wrap(void)
+{
+    const nc_trace_buffer *     buffer = nc_trace_get_buffer();
+    nc_thread *                 thread;
+    uint32_t                    id;
+
+    nc_trace_init(CLOCK_HZ);
+    thread = nc_thread_create(worker_fn, NULL, 7u);
+    TEST_ASSERT(thread != NULL);
+    id = buffer->records[0].thread;
+
+    for (uint32_t itr = 0u; itr < CONFIG_NC_TRACE_SIZE; itr++) {
+        nc_thread_ready(thread);
+        nc_schedule();
+    }
+    TEST_ASSERT(buffer->head == 1u + 4u * CONFIG_NC_TRACE_SIZE);
+    record_check(buffer->head - 1u, NC_TRACE_DISPATCH_END, id,
+        NC_STATE_BLOCKED);
+    record_check(buffer->head - 4u, NC_TRACE_READY, id, NC_STATE_READY);
+    record_check(buffer->head - CONFIG_NC_TRACE_SIZE, NC_TRACE_READY, id,
+        NC_STATE_READY);                          /* Oldest record kept */
+    nc_thread_destroy(thread);
+    printf("trace: ring wrap ok\n");
+}
+
+static void dump(const char * name)
+{
+    FILE *                      file;
+
+    file = fopen(name, "wb");
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT(fwrite(nc_trace_get_buffer(), sizeof(nc_trace_buffer), 1u,
+        file) == 1u);
+    TEST_ASSERT(fclose(file) == 0);
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(int argc, char ** argv)
+{
+    test_header();
+    test_life_cycle();
+    test_wrap();
+
+    if (argc > 1) {
+        dump(argv[1]);
+    }
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_TRACE != 1)
+# error "test_trace: the test needs CONFIG_NC_TRACE."
+#endif
+
+#if (CONFIG_NC_TRACE_SIZE > 64)
+# error "test_trace: the test needs a small CONFIG_NC_TRACE_SIZE to wrap the ring."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,224 @@
+/*
+ * This file is part of nanocoop
+ *
+ * Copyright (C) 2014 - Nenad Radulovic
+ *
+ * nanocoop is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * nanocoop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * web site:    http://github.com/nradulovic
+ * e-mail  :    nenad.b.radulovic@gmail.com
+ *//***********************************************************************//**
+ * @file
+ * @author      Nenad Radulovic
+ * @brief       Weighted round-robin tests
+ * @details     Covers dispatch credits of threads with different weights,
+ *              the default and the zero weight, a full turn after blocking
+ *              in the middle of a turn, lowering the weight during a turn and
+ *              threads of other priorities.
+ *********************************************************************//** @{ */
+
+/*=========================================================  INCLUDE FILES  ==*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocoop.h"
+#include "nc_test.h"
+
+/*=========================================================  LOCAL MACRO's  ==*/
+
+#define NUM_OF_WORKERS                  3u
+
+/*======================================================  LOCAL DATA TYPES  ==*/
+
+struct worker
+{
+    char                        name;
+    uint32_t                    left;       /* Dispatches to do, 0 - forever  */
+    nc_thread *                 thread;
+};
+
+/*=============================================  LOCAL FUNCTION PROTOTYPES  ==*/
+
+static void worker_fn(void *);
+static void workers_create(uint_fast8_t weight_a, uint_fast8_t weight_b,
+                uint_fast8_t weight_c);
+static void workers_destroy(void);
+static void run(uint32_t dispatches);
+static void test_plain(void);
+static void test_weights(void);
+static void test_block_mid_turn(void);
+static void test_lower_weight(void);
+static void test_priorities(void);
+
+/*=======================================================  LOCAL VARIABLES  ==*/
+
+static struct worker            g_workers[NUM_OF_WORKERS];
+static char                     g_trace[64];
+static size_t                   g_trace_size;
+
+/*======================================================  GLOBAL VARIABLES  ==*/
+/*============================================  LOCAL FUNCTION DEFINITIONS  ==*/
+
+/* Stays ready until the given number of dispatches is used up.
+ */
+static void worker_fn(void * stack)
+{
+    struct worker *             worker = stack;
+
+    TEST_ASSERT(g_trace_size < sizeof(g_trace) - 1u);
+    g_trace[g_trace_size++] = worker->name;
+    g_trace[g_trace_size]   = '\0';
+
+    if ((worker->left != 0u) && (--worker->left == 0u)) {
+        nc_thread_done();
+    }
+}
+
+static void workers_create(uint_fast8_t weight_a, uint_fast8_t weight_b,
+    uint_fast8_t weight_c)
+{
+    const uint_fast8_t          weights[NUM_OF_WORKERS] =
+    {
+        weight_a,
+        weight_b,
+        weight_c
+    };
+
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        struct worker *         worker = &g_workers[itr];
+
+        worker->name   = (char)('a' + itr);
+        worker->left   = 0u;
+        worker->thread = nc_thread_create(worker_fn, worker, 1u);
+        TEST_ASSERT(worker->thread != NULL);
+        nc_thread_set_weight(worker->thread, weights[itr]);
+        nc_thread_ready(worker->thread);
+    }
+    g_trace_size = 0u;
+}
+
+static void workers_destroy(void)
+{
+    for (uint32_t itr = 0u; itr < NUM_OF_WORKERS; itr++) {
+        nc_thread_destroy(g_workers[itr].thread);
+    }
+}
+
+static void run(uint32_t dispatches)
+{
+    g_trace_size = 0u;
+    TEST_ASSERT(nc_schedule_for(dispatches, 0u));
+    TEST_ASSERT(g_trace_size == dispatches);
+}
+
+/* Default weight 1 and weight 0 give the plain round-robin.
+ */
+static void test_plain(void)
+{
+    workers_create(1u, 0u, 1u);
+    run(6u);
+    TEST_ASSERT(strcmp(g_trace, "abcabc") == 0);
+    workers_destroy();
+    printf("wrr: plain round-robin ok\n");
+}
+
+static void test_weights(void)
+{
+    workers_create(3u, 1u, 2u);
+    run(18u);
+    TEST_ASSERT(strcmp(g_trace, "aaabccaaabccaaabcc") == 0);
+    workers_destroy();
+    printf("wrr: dispatches in proportion to weights ok\n");
+}
+
+/* A thread blocked in the middle of its turn gets a full turn when it is
+ * made ready again.
+ */
+static void test_block_mid_turn(void)
+{
+    workers_create(3u, 1u, 1u);
+    g_workers[0].left = 2u;                /* Finishes after 2 of 3 credits */
+    run(4u);
+    TEST_ASSERT(strcmp(g_trace, "aabc") == 0);
+    TEST_ASSERT(nc_thread_get_state(g_workers[0].thread) == NC_STATE_BLOCKED);
+
+    nc_thread_ready(g_workers[0].thread);
+    run(7u);
+    TEST_ASSERT(strcmp(g_trace, "bcaaabc") == 0);
+    workers_destroy();
+    printf("wrr: full turn after blocking ok\n");
+}
+
+/* Lowering the weight during a turn does not extend the turn, raising it
+ * applies from the next turn.
+ */
+static void test_lower_weight(void)
+{
+    workers_create(4u, 1u, 1u);
+    run(2u);
+    TEST_ASSERT(strcmp(g_trace, "aa") == 0);
+    nc_thread_set_weight(g_workers[0].thread, 1u);   /* 2 credits were left */
+    run(5u);
+    TEST_ASSERT(strcmp(g_trace, "abcab") == 0);
+    nc_thread_set_weight(g_workers[1].thread, 3u);
+    run(8u);
+    TEST_ASSERT(strcmp(g_trace, "cabcabbb") == 0);
+    workers_destroy();
+    printf("wrr: weight change during a turn ok\n");
+}
+
+/* A ready thread of higher priority is dispatched first regardless of the
+ * turn of the current level.
+ */
+static void test_priorities(void)
+{
+    static struct worker        urgent = { 'u', 2u, NULL };
+
+    workers_create(3u, 1u, 1u);
+    urgent.thread = nc_thread_create(worker_fn, &urgent, 2u);
+    run(2u);
+    nc_thread_ready(urgent.thread);
+    run(5u);
+    TEST_ASSERT(strcmp(g_trace, "uuabc") == 0);
+    nc_thread_destroy(urgent.thread);
+    workers_destroy();
+    printf("wrr: higher priority first ok\n");
+}
+
+/*===================================  GLOBAL PRIVATE FUNCTION DEFINITIONS  ==*/
+/*====================================  GLOBAL PUBLIC FUNCTION DEFINITIONS  ==*/
+
+int main(void)
+{
+    test_plain();
+    test_weights();
+    test_block_mid_turn();
+    test_lower_weight();
+    test_priorities();
+
+    return (0);
+}
+
+/*================================*//** @cond *//*==  CONFIGURATION ERRORS  ==*/
+
+#if (CONFIG_NC_WEIGHTED_RR != 1)
+# error "test_wrr: the test needs CONFIG_NC_WEIGHTED_RR."
+#endif
+
+/** @endcond *//** @} *//******************************************************
+ * END of main.c
+ ******************************************************************************/
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+#
+# This file is part of nanocoop
+#
+# Copyright (C) 2014 - Nenad Radulovic
+#
+# nanocoop is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# nanocoop is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with nanocoop.  If not, see <http://www.gnu.org/licenses/>.
+#
+# web site:    http://github.com/nradulovic
+# e-mail  :    nenad.b.radulovic@gmail.com
+#
+"""Convert a nanocoop trace buffer dump into Chrome trace JSON.
+
+The input is the raw memory of nc_trace_buffer structure, see
+source/nc_trace.h. The output can be opened in chrome://tracing or
+https://ui.perfetto.dev. Each nanocoop thread is shown as one track sorted by
+priority. Thread executions are shown as slices and the time a thread spends
+in ready state as async slices. Dispatches which are longer than the given
+budget and dispatches of a thread while a higher priority thread is waiting
+are marked with instant events.
+
+Usage: nc_trace2chrome.py [-f CLOCK_HZ] [-b BUDGET_US] [-e big|little]
+                          dump.bin [trace.json]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TRACE_MAGIC = 0x5254434e
+TRACE_VERSION = 1
+
+DISPATCH_BEGIN = 1
+DISPATCH_END = 2
+READY = 3
+BLOCK = 4
+CREATE = 5
+DESTROY = 6
+
+STATE_READY = 2
+
+HEADER_FORMAT = "IHHIIQ"
+RECORD_FORMAT = "QIBBBB"
+
+INSTANT_NAMES = {
+    READY: "ready",
+    BLOCK: "block",
+    CREATE: "create",
+    DESTROY: "destroy",
+}
+
+
+def read_records(data, endian):
+    """Return the header fields and the list of records, oldest first."""
+    header = struct.Struct(endian + HEADER_FORMAT)
+    record = struct.Struct(endian + RECORD_FORMAT)
+    magic, version, record_size, capacity, head, clock_hz = \
+        header.unpack_from(data, 0)
+
+    if magic != TRACE_MAGIC:
+        raise ValueError("not a nanocoop trace buffer (bad magic)")
+
+    if version != TRACE_VERSION:
+        raise ValueError("unsupported trace version %d" % version)
+
+    if record_size != record.size:
+        raise ValueError("unsupported record size %d" % record_size)
+
+    if len(data) < header.size + capacity * record_size:
+        raise ValueError("trace buffer is truncated")
+    count = min(head, capacity)
+    records = []
+
+    for sequence in range(head - count, head):
+        offset = header.size + (sequence % capacity) * record_size
+        records.append(record.unpack_from(data, offset))
+    records.sort(key=lambda r: r[0])            # Cores may interleave claims
+
+    return clock_hz, head - count, records
+
+
+def convert(clock_hz, lost, records, budget_us):
+    """Build the list of Chrome trace events."""
+    events = []
+    origin = records[0][0] if records else 0
+    running = {}                                # thread -> begin timestamp
+    waiting = {}                                # thread -> priority
+    names = {}
+
+    def ts(timestamp):
+        return (timestamp - origin) * 1e6 / clock_hz
+
+    if lost != 0:
+        events.append({"name": "buffer wrapped: %d records lost" % lost, "ph": "i",
+                       "s": "g", "pid": 0, "tid": 0, "ts": 0})
+
+    for timestamp, thread, event, priority, core, state in records:
+        tid = thread + 1
+        common = {"pid": 0, "tid": tid, "ts": ts(timestamp)}
+        names[tid] = priority
+
+        if event == DISPATCH_BEGIN:
+            if thread in waiting:
+                del waiting[thread]
+                events.append(dict(common, name="ready", cat="wait", ph="e",
+                                   id=tid))
+            higher = [t for t, p in waiting.items() if p > priority]
+
+            if higher:
+                events.append(dict(common, name="priority inversion",
+                                   ph="i", s="t",
+                                   args={"waiting": sorted(higher)}))
+            running[thread] = timestamp
+            events.append(dict(common, name="run", cat="dispatch", ph="B",
+                               args={"core": core, "priority": priority}))
+        elif event == DISPATCH_END:
+            if thread not in running:               # Began before the dump
+                continue
+            begin = running.pop(thread)
+            events.append(dict(common, name="run", cat="dispatch", ph="E"))
+
+            if budget_us is not None and ts(timestamp) - ts(begin) > budget_us:
+                events.append(dict(common, name="overrun", ph="i", s="t",
+                                   args={"us": ts(timestamp) - ts(begin)}))
+
+            if state == STATE_READY and thread not in waiting:
+                waiting[thread] = priority
+                events.append(dict(common, name="ready", cat="wait", ph="b",
+                                   id=tid))
+        elif event in INSTANT_NAMES:
+            events.append(dict(common, name=INSTANT_NAMES[event], ph="i",
+                               s="t"))
+
+            if event == READY:
+                if thread in waiting:
+                    continue
+                waiting[thread] = priority
+                events.append(dict(common, name="ready", cat="wait", ph="b",
+                                   id=tid))
+            elif thread in waiting:                 # Blocked or destroyed
+                del waiting[thread]
+                events.append(dict(common, name="ready", cat="wait", ph="e",
+                                   id=tid))
+
+    for tid, priority in names.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 0,
+                       "tid": tid, "args": {"name": "thread %d (prio %d)" %
+                                            (tid - 1, priority)}})
+        events.append({"name": "thread_sort_index", "ph": "M", "pid": 0,
+                       "tid": tid, "args": {"sort_index": -priority}})
+    events.append({"name": "process_name", "ph": "M", "pid": 0,
+                   "args": {"name": "nanocoop"}})
+
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert a nanocoop trace dump into Chrome trace JSON.")
+    parser.add_argument("dump", help="raw nc_trace_buffer dump")
+    parser.add_argument("output", nargs="?", help="output JSON file")
+    parser.add_argument("-f", "--clock-hz", type=float,
+                        help="timestamp frequency, overrides the dump header")
+    parser.add_argument("-b", "--budget-us", type=float,
+                        help="mark dispatches longer than this as overruns")
+    parser.add_argument("-e", "--endian", choices=("little", "big"),
+                        default="little", help="byte order of the target")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as dump:
+        data = dump.read()
+    clock_hz, lost, records = read_records(
+        data, "<" if args.endian == "little" else ">")
+
+    if args.clock_hz is not None:
+        clock_hz = args.clock_hz
+
+    if not clock_hz:
+        parser.error("the dump has no clock frequency, use --clock-hz")
+    trace = {"traceEvents": convert(clock_hz, lost, records, args.budget_us),
+             "displayTimeUnit": "ns"}
+
+    if args.output:
+        with open(args.output, "w") as output:
+            json.dump(trace, output)
+    else:
+        json.dump(trace, sys.stdout)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())